@@ -2,7 +2,14 @@
 
 #include <array>
 #include <core/constants.h>
+#include <core/frameBuffers.h>
+#include <core/ioRegisters.h>
+#include <core/lineCompositor.h>
+#include <core/memoryArena.h>
+#include <core/pixelFormat.h>
 #include <core/serializable.h>
+#include <core/tileCache.h>
+#include <core/utils/staticVector.h>
 #include <core/utils/utils.h>
 #include <queue>
 #include <vector>
@@ -19,53 +26,6 @@ enum class InteruptSource
     LYC
 };
 
-union LCDRegister
-{
-    struct
-    {
-        uint8_t BGAndWindowPriority : 1;
-        uint8_t objEnable : 1;
-        uint8_t objSize : 1;
-        uint8_t bgTileMapArea : 1;
-        uint8_t BGAndWindowTileAreaData : 1;
-        uint8_t windowEnable : 1;
-        uint8_t windowTileMapArea : 1;
-        uint8_t enable : 1;
-    };
-
-    uint8_t flags = 0x00;
-};
-
-union LCDStatus
-{
-    struct
-    {
-        uint8_t mode : 2;
-        uint8_t lYcEqualLY : 1;
-        // Interrupt sources (IS)
-        uint8_t mode0HBlankIS : 1;
-        uint8_t mode1VBlankIS : 1;
-        uint8_t mode2OAMIS : 1;
-        uint8_t lYcEqualLYIS : 1;
-        uint8_t unused : 1;
-    };
-
-    uint8_t flags = 0x00;
-};
-
-union GBPaletteData
-{
-    struct
-    {
-        uint8_t color0 : 2;
-        uint8_t color1 : 2;
-        uint8_t color2 : 2;
-        uint8_t color3 : 2;
-    };
-
-    uint8_t flags = 0x00;
-};
-
 struct GBCPaletteData
 {
     std::array<RGB555, 4> colors;
@@ -95,73 +55,110 @@ struct PixelFIFO
     uint8_t bgPriority = 0x00;
 };
 
-union Attributes
-{
-    struct
-    {
-        uint8_t paletteNumberGBC : 3;
-        uint8_t tileVRAMBank : 1;
-        uint8_t paletteNumberGB : 1;
-        uint8_t xFlip : 1;
-        uint8_t yFlip : 1;
-        uint8_t bgAndWindowOverObj : 1;
-    };
-
-    uint8_t flags = 0x00;
-};
-
-struct OAMEntry
-{
-    uint8_t xPosition = 0x00;
-    uint8_t yPosition = 0x00;
-    uint8_t tileIndex = 0x00;
-
-    Attributes attributes;
-};
-
 class Processor2C02 : public ISerializable
 {
 public:
-    Processor2C02();
+    explicit Processor2C02(PixelFormat pixelFormat = PixelFormat::RGB888);
 
+    // VRAM and OAM
     uint8_t ReadByte(uint16_t addr, bool readOnly = false);
     void WriteByte(uint16_t addr, uint8_t data);
+    // Offset in OAM (0x00-0x9F), for the OAM DMA
+    void WriteOAM(uint8_t offset, uint8_t data);
+
+    // LCD registers (0xFF40-0xFF4B, except DMA), and VRAM bank and palettes in GBC mode
+    void InstallIORegisters(IORegisters& registers, bool isGBC);
 
     void SerializeTo(Utils::IWriteVisitor& visitor) const override;
     void DeserializeFrom(Utils::IReadVisitor& visitor) override;
 
     constexpr unsigned GetHeight() const { return GB_INTERNAL_HEIGHT; }
     constexpr unsigned GetWidth() const { return GB_INTERNAL_WIDTH; }
-    const auto& GetScreen() const { return m_screen; }
-
-    const auto& GetOAMEntries() const { return m_OAM; }
-    GBPaletteData GetBGPalette() const { return m_gbBGPalette; }
-    GBPaletteData GetOAM0Palette() const { return m_gbOBJ0Palette; }
-    GBPaletteData GetOAM1Palette() const { return m_gbOBJ1Palette; }
+    // Frames are rendered in a back buffer, and published when they are complete.
+    // GetWidth() * GetHeight() pixels, in the format given to the constructor.
+
+    // Last complete frame, for the emulation thread. Valid until the next frame is complete.
+    const std::vector<uint8_t>& GetScreen() const { return m_frameBuffers.GetLastPublished(); }
+    // Last complete frame, for a single consumer on any thread, without copy. The emulation never waits for it,
+    // and never writes in the frame until the next call. The sequence number tells if it is a new one.
+    FrameView AcquireFrame() { return m_frameBuffers.Acquire(); }
+    // Sequence number of the last complete frame, for the emulation thread
+    uint64_t GetNbCompleteFrames() const { return m_frameBuffers.GetNbPublishedFrames(); }
+    PixelFormat GetPixelFormat() const { return m_pixelFormat; }
+
+    // Implementation used to compose the lines, the best one supported by default.
+    // Returns false if the CPU doesn't support it.
+    bool SetCompositorImpl(CompositorImpl impl);
+    CompositorImpl GetCompositorImpl() const { return m_compositorImpl; }
+
+    const auto& GetOAMEntries() const { return *m_OAM; }
+    GBPaletteData GetBGPalette() const { return m_registers->gbBGPalette; }
+    GBPaletteData GetOAM0Palette() const { return m_registers->gbOBJ0Palette; }
+    GBPaletteData GetOAM1Palette() const { return m_registers->gbOBJ1Palette; }
 
     const auto& GetBGPalettesGBC() const { return m_gbcBGPalettes; }
     const auto& GetOBJPalettesGBC() const { return m_gbcOBJPalettes; }
 
-    uint8_t GetLY() const { return m_lY; }
+    uint8_t GetLY() const { return m_registers->lY; }
 
     bool IsFrameComplete() const { return m_isFrameComplete; }
-    bool IsInHBlank() const { return m_lcdStatus.mode == 0; }
-    bool IsInVBlank() const { return m_lcdStatus.mode == 1; }
+    bool IsInHBlank() const { return m_registers->lcdStatus.mode == 0; }
+    bool IsInVBlank() const { return m_registers->lcdStatus.mode == 1; }
 
     void ConnectBus(Bus* bus) { m_bus = bus; }
+    // The VRAM, the OAM and the registers live in the memory arena of the bus
+    void ConnectMemory(MemoryArena& memory)
+    {
+        m_VRAM = &memory.videoRAM;
+        m_OAM = &memory.OAM;
+        m_registers = &memory.lcdRegisters;
+    }
+    // The memory arena was overwritten
+    void OnMemoryRestored();
 
-    const std::vector<uint8_t>& GetVRAM() const { return m_VRAM; }
+    const MemoryArena::VideoRAM& GetVRAM() const { return *m_VRAM; }
+    // Pointer to the 256 bytes page of the current VRAM bank at this address, for the bus page tables.
+    // Direct writes must be followed by OnVRAMPageWrite, to keep the tile cache up to date.
+    uint8_t* GetVRAMPage(uint16_t addr)
+    {
+        return &(*m_VRAM)[m_registers->currentVRAMBank * 0x2000 + (addr & 0x1F00)];
+    }
+    // size bytes were written from addr (0x8000-0x9FFF) in the current VRAM bank, through its page
+    void OnVRAMPageWrite(uint16_t addr, uint16_t size)
+    {
+        m_tileCache.OnVRAMWrite(addr, m_registers->currentVRAMBank, size);
+    }
 
     void Reset();
     void Clock();
 
+    // Number of upcoming dots where the PPU only counts (HBlank/VBlank, until the end of the line).
+    // Nothing visible happens during them: no rendering, no mode change and no interrupt.
+    unsigned GetNbIdleDots() const;
+    // Same as calling Clock() nbDots times, nbDots must not be greater than GetNbIdleDots().
+    void SkipIdleDots(unsigned nbDots);
+    // Number of upcoming dots that won't change the registers (LY, STAT) or raise an interrupt.
+    unsigned GetNbDotsBeforeNextEvent() const;
+    // True if the next dot reads VRAM (the whole line is fetched at the start of mode 3)
+    bool IsReadingVRAMOnNextDot() const
+    {
+        return m_scanlines <= 143 && m_registers->lcdStatus.mode == 3 && m_lineDots == 80;
+    }
+
     using GBCPaletteDataArray = std::array<GBCPaletteData, 8>;
 
 private:
     void DebugRenderNoise();
     void DebugRenderTileIds();
     void RenderPixelFifos();
+    // Compose the pixels rendered since the last call. Must be called before changing the palettes or LCDC.
+    void ComposePendingPixels();
+    // Rebuild the output colors of a GB palette register (from this offset in m_outputPalette), on DMG only
+    void UpdateOutputPalette(size_t offset, GBPaletteData palette);
+    void UpdateOutputPalettes();
     void RenderDisabledLCD();
+    void FillScreen(uint8_t r, uint8_t g, uint8_t b);
+    void PublishFrame();
     void SetInteruptFlag(InteruptSource is);
 
     void OriginalPixelFetcher();
@@ -171,21 +168,10 @@ private:
     void WriteVRAM(uint16_t addr, uint8_t bankNumber, uint8_t data);
 
     Bus* m_bus = nullptr;
-    LCDRegister m_lcdRegister;
-    LCDStatus m_lcdStatus;
-
-    uint8_t m_scrollY = 0x00;
-    uint8_t m_scrollX = 0x00;
-    uint8_t m_lY = 0x00;
-    uint8_t m_lYC = 0x00;
-    uint8_t m_wY = 0x00;
-    uint8_t m_wX = 0x00;
+    // LCD registers, in the memory arena
+    LCDRegisterFile* m_registers = nullptr;
     uint8_t m_windowStalling = 0x00;
 
-    GBPaletteData m_gbBGPalette;
-    GBPaletteData m_gbOBJ0Palette;
-    GBPaletteData m_gbOBJ1Palette;
-
     // GBC Spcific
     bool m_isGBC = false;
     GBCPaletteDataArray m_gbcBGPalettes;
@@ -193,6 +179,10 @@ private:
     GBCPaletteAccess m_gbcBGPaletteAccess;
     GBCPaletteAccess m_gbcOBJPaletteAccess;
 
+    // Final colors of the palettes above, updated when they are written.
+    // On DMG, only the first palette of the BG and the first 2 of the objects are used.
+    CompositorPalette m_outputPalette{};
+
     // FIFOs
     Utils::MyStaticQueue<PixelFIFO, 160> m_bgFifo;
     Utils::MyStaticQueue<PixelFIFO, 160> m_objFifo;
@@ -200,10 +190,10 @@ private:
     std::array<PixelFIFO, 8> m_currentFetchedBGPixels;
     std::array<PixelFIFO, 8> m_currentFetchedOBJPixels;
 
-    // OAM
-    // 4 bytes per entry, 40 entries
-    std::array<OAMEntry, 40> m_OAM;
-    std::vector<uint8_t> m_selectedOAM;
+    // OAM, in the memory arena
+    MemoryArena::ObjectAttributeMemory* m_OAM = nullptr;
+    // Max of 10 sprites selected on a single line
+    Utils::MyStaticVector<uint8_t, 10> m_selectedOAM;
 
     uint8_t m_currentStagePixelFetcher = 0x00;
     uint8_t m_XOffsetBGTile = 0x00;
@@ -219,12 +209,20 @@ private:
     uint8_t m_currentNbPixelsToRender = 0x00;
 
     // Screen
-    std::vector<uint8_t> m_screen;
+    PixelFormat m_pixelFormat;
+    FrameBuffers m_frameBuffers;
+    // Number of pixels of each line rendered in the back buffer during this frame
+    std::array<uint8_t, GB_INTERNAL_HEIGHT> m_nbRenderedPixels{};
+    // Pixels of the current line, composed in the back buffer from m_nbComposedPixels to m_currentLinePixel
+    LinePixels m_linePixels;
+    unsigned m_nbComposedPixels = 0;
+    CompositorImpl m_compositorImpl = GetBestCompositorImpl();
     bool m_isFrameComplete = false;
     bool m_isDisabled = false;
 
-    // VRAM
-    std::vector<uint8_t> m_VRAM;
-    uint8_t m_currentVRAMBank;
+    // VRAM, in the memory arena
+    MemoryArena::VideoRAM* m_VRAM = nullptr;
+    // VRAM tiles decoded for the pixel fetcher. All VRAM writes must go through WriteVRAM or OnVRAMPageWrite.
+    TileCache m_tileCache;
 };
 } // namespace GBEmulator
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <core/audio/noiseChannel.h>
 #include <core/audio/pulseChannel.h>
 #include <core/audio/waveChannel.h>
+#include <core/ioRegisters.h>
 #include <core/serializable.h>
 
 namespace GBEmulator
@@ -22,16 +23,20 @@ public:
 
     void Stop();
 
-    void WriteByte(uint16_t addr, uint8_t data);
-    uint8_t ReadByte(uint16_t addr) const;
+    // Sound registers and wave RAM (0xFF10-0xFF3F)
+    void InstallIORegisters(IORegisters& registers);
 
     void FillSamples(float* outData, unsigned int numFrames, unsigned int numChannels);
     // Will fill 128 samples (64 sampels left and right) if they are ready.
     bool FillSamplesIfReady(float* outData);
+    bool AreSamplesReady() const { return m_samplesReady; }
 
     uint8_t GetDivCounter() const { return m_divCounter; }
 
 private:
+    void WriteSoundControl(uint8_t data);
+    uint8_t ReadSoundControl() const;
+
     PulseChannel m_channel1;
     PulseChannel m_channel2;
     WaveChannel m_channel3;
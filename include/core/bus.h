@@ -5,14 +5,19 @@
 #include <core/z80Processor.h>
 #include <core/2C02Processor.h>
 #include <core/cartridge.h>
+#include <core/cheats.h>
 #include <core/controller.h>
 #include <core/timer.h>
 #include <core/apu.h>
 #include <core/utils/instLogger.h>
+#include <core/ioRegisters.h>
+#include <core/memoryArena.h>
+#include <core/scheduler.h>
 #include <vector>
 #include <array>
 #include <cstdint>
 #include <memory>
+#include <string>
 
 namespace GBEmulator 
 {
@@ -22,28 +27,28 @@ namespace GBEmulator
         GBC
     };
 
-    union InterruptRegister
+    // Result of Bus::RunCycles/RunFrame
+    struct RunStatus
     {
-        struct
-        {
-            uint8_t vBlank : 1;
-            uint8_t lcdStat : 1;
-            uint8_t timer : 1;
-            uint8_t serial : 1;
-            uint8_t joypad : 1;
-            uint8_t unused : 3;
-        };
-
-        uint8_t flag = 0x00;
+        // Number of CPU cycles done
+        size_t nbCycles = 0;
+        // Stopped because a frame was completed
+        bool frameFinished = false;
+        // Stopped because the bus is in break mode (breakpoint/run to address reached)
+        bool isInBreak = false;
+        // Stopped because audio samples are ready to be consumed (only if requested)
+        bool areAudioSamplesReady = false;
     };
 
-    class Bus : public ISerializable
+    class Bus : public ISerializable, public IEmulatedTimeSource
     {
     public:
         // Allow the CPU to access variables directly
         friend Z80Processor;
 
-        Bus();
+        // The screen of the PPU is rendered in this format
+        explicit Bus(PixelFormat pixelFormat = PixelFormat::RGB888);
+        ~Bus();
 
         void SerializeTo(Utils::IWriteVisitor& visitor) const override;
         void DeserializeFrom(Utils::IReadVisitor& visitor) override;
@@ -58,6 +63,23 @@ namespace GBEmulator
         // Clock a CPU cycle
         bool Clock(bool* outInstDone = nullptr);
 
+        // Clock up to maxNbCycles CPU cycles in one go, while the CPU is halted and nothing can wake it up,
+        // or while it is spinning in a busy-wait or memory copy/fill loop (see Z80Processor::IsInIdleLoop and
+        // Z80Processor::IsInMemoryLoop).
+        // It stops before the next event that could raise an interrupt (PPU mode change/LY=LYC, timer overflow,
+        // joypad), and the state is the same as calling Clock() the same number of times.
+        // Returns the number of cycles done, 0 meaning that Clock() must be used for the next cycle.
+        size_t FastForward(size_t maxNbCycles, bool* outFrameFinished = nullptr);
+
+        // Run up to maxNbCycles CPU cycles, using FastForward() when possible.
+        // Stops early when a frame is completed, when in break mode, or when audio samples are ready if
+        // stopOnAudioSamples is true (they must be consumed with APU::FillSamplesIfReady before the next call).
+        // Nothing is done if the bus is already in break mode, Clock() must be used to step.
+        RunStatus RunCycles(size_t maxNbCycles, bool stopOnAudioSamples = false);
+        // Same as RunCycles, up to a frame worth of cycles (in case the LCD is off).
+        RunStatus RunFrame(bool stopOnAudioSamples = false);
+        size_t GetNbCyclesPerFrame() const { return m_isDoubleSpeedMode ? 2 * 17556 : 17556; }
+
         // Read a single byte of data
         // Use the const version to read it or use readOnly flag to avoid alter the memory
         // (ie. some operations can "write" data while reading)
@@ -70,14 +92,33 @@ namespace GBEmulator
         void InsertCartridge(const std::shared_ptr<Cartridge>& cartridge);
         void ConnectController(const std::shared_ptr<Controller>& controller);
 
+        // Cheats, see cheats.h. Game Genie codes patch copies of the ROM pages of the cartridge (it must be
+        // inserted), GameShark codes are written in RAM each frame when entering VBlank, until another cartridge
+        // is inserted.
+        // Nothing is checked on memory accesses, so there is no cost without cheats.
+        // Returns false if the code is not valid.
+        bool AddCheat(const std::string& code);
+        void ClearCheats();
+
         const Cartridge* GetCartridge() const { return m_cartridge.get(); }
         const Z80Processor& GetCPU() const { return m_cpu; }
+        Z80Processor& GetCPU() { return m_cpu; }
         const Processor2C02& GetPPU() const { return m_ppu; }
+        Processor2C02& GetPPU() { return m_ppu; }
+        // WRAM, VRAM, OAM, HRAM and the registers holding plain data, in a single block.
+        // A copy of it can be restored with RestoreMemory(), the rest of the state (CPU, PPU rendering, APU, timer,
+        // cartridge...) is only restored with the save states.
+        const MemoryArena& GetMemory() const { return *m_memory; }
+        void RestoreMemory(const MemoryArena& memory);
         APU& GetAPU() { return m_apu; }
         void SetPC(uint16_t addr) { m_cpu.SetPC(addr); }
 
         void SaveCartridgeRAM(Utils::IWriteVisitor& visitor) const { m_cartridge->SerializeRam(visitor); }
-        void LoadCartridgeRAM(Utils::IReadVisitor& visitor) { m_cartridge->DeserializeRam(visitor); }
+        void LoadCartridgeRAM(Utils::IReadVisitor& visitor)
+        {
+            m_cartridge->DeserializeRam(visitor);
+            UpdateCartridgePages();
+        }
 
         // Change mode if possible.
         // Will reset the game
@@ -88,7 +129,73 @@ namespace GBEmulator
 
         bool IsInDoubleSpeedMode() const { return m_isDoubleSpeedMode; }
 
-    private:        
+        // Number of cycles since the reset, incremented at the start of each cycle.
+        // This is the time base of the scheduler.
+        size_t GetNbCycles() const { return m_nbCycles; }
+        Scheduler& GetScheduler() { return m_scheduler; }
+
+        // Real-time clock of the cartridge (MBC3). Emulated time by default.
+        void SetRTCMode(RTCMode mode);
+        uint64_t GetEmulatedSeconds() const override
+        {
+            return GetEmulatedTime() / GBEmulator::CPU_NB_CYCLES_PER_SECOND_DOUBLE_SPEED;
+        }
+
+        // Must be called by the PPU when the VRAM bank changes
+        void UpdateVRAMPages();
+
+    private:
+        // Give the bank and the end of the memory region of the code at a given address,
+        // for the CPU decode cache. For WRAM/HRAM, also give the index in the
+        // decode cache RAM code space.
+        // Returns false if the code at this address can't be cached.
+        bool GetCodeLocation(uint16_t addr, uint16_t& bank, uint16_t& ramIndex, uint32_t& endAddress) const;
+
+        // Memory accesses for the CPU loops run in bulk (see Z80Processor::RunMemoryLoop).
+        // Plain memory is ROM (read only), VRAM, WRAM and HRAM: no side effect and nothing else reading it
+        // while the loop runs. The range must stay in a single region.
+        bool IsPlainMemory(uint16_t addr, size_t size, bool isWrite) const;
+        // Same as reading and writing byte per byte, but mapped pages are copied directly (also used by HDMA)
+        void CopyMemory(uint16_t dst, uint16_t src, uint16_t size);
+        void FillMemory(uint16_t dst, uint8_t value, uint16_t size);
+
+        // Install the handlers of all the IO registers, for the current mode
+        void InstallIORegisters();
+
+        // Page tables, updated each time the memory mapped changes (banks, RAM enabled...)
+        void UpdateMemoryMap();
+        void UpdateCartridgePages();
+        void UpdateWRAMPages();
+
+        // Clock() specialized for the current mode, speed and debugger state, so those are not checked
+        // every cycle. UpdateClockFunction() must be called each time one of them changes.
+        template <bool IsGBC, bool IsDoubleSpeed, bool IsDebugging>
+        bool ClockImpl(bool* outInstDone);
+        void UpdateClockFunction();
+
+        // Run the events of the scheduler due at the current cycle
+        void RunScheduledEvents();
+
+        // Emulated time, in double speed cycles. It doesn't restart on reset.
+        uint64_t GetEmulatedTime() const
+        {
+            return m_emulatedTime + (m_nbCycles - m_emulatedTimeCycle) * (m_isDoubleSpeedMode ? 1 : 2);
+        }
+
+        // Write the GameShark codes in RAM
+        void ApplyGameSharkCodes();
+
+        // Stop being the RTC source of the cartridge, before it is replaced or the bus destroyed
+        void DetachCartridge();
+
+        // Clock everything but the CPU, for FastForward(). The PPU can only skip its dots if they are idle.
+        void AdvanceWithoutCPU(size_t nbCycles, bool isPPUIdle, bool* outFrameFinished);
+
+        // All the emulated memory, allocated once
+        std::unique_ptr<MemoryArena> m_memory = std::make_unique<MemoryArena>();
+        // Interrupts and WRAM bank, in the memory arena
+        BusRegisterFile& m_registers = m_memory->busRegisters;
+
         Z80Processor m_cpu;
         Processor2C02 m_ppu;
         APU m_apu;
@@ -97,24 +204,41 @@ namespace GBEmulator
 
         Mode m_mode = Mode::GB;
 
+        using ClockFunction = bool (Bus::*)(bool*);
+        ClockFunction m_clockFunction = nullptr;
+
         bool m_isPreparingForChangingSpeed = false;
-        uint16_t m_nbRemainingCyclesForChangingSpeed = 0x0000;
         bool m_isDoubleSpeedMode = false;
 
-        std::vector<uint8_t> m_WRAM;
-        uint8_t m_currentWRAMBank;
+        std::array<uint8_t, 256> m_ROM;
 
-        std::array<uint8_t, 127> m_HRAM;
+        // Memory accessed directly, by pages of 256 bytes: ROM, VRAM, external RAM and WRAM (with its echo).
+        // nullptr means that the access must go through the handlers (IO, OAM, mapper registers...).
+        // Writes in WRAM also give the index in the decode cache RAM code space of the page.
+        // Writes in VRAM must also be notified to the PPU, for its tile cache.
+        struct WritePage
+        {
+            uint8_t* data = nullptr;
+            uint16_t ramIndex = DECODE_CACHE_NO_RAM;
+            bool isVRAM = false;
+        };
+        alignas(CACHE_LINE_SIZE) std::array<const uint8_t*, 256> m_readPages;
+        alignas(CACHE_LINE_SIZE) std::array<WritePage, 256> m_writePages;
 
-        InterruptRegister m_IE;
-        InterruptRegister m_IF;
-
-        std::array<uint8_t, 256> m_ROM;
+        IORegisters m_ioRegisters;
 
         std::shared_ptr<Cartridge> m_cartridge;
         std::shared_ptr<Controller> m_controller;
-        size_t m_nbCycles;
-        size_t m_nbCyclesForSeconds;
+        size_t m_nbCycles = 0;
+
+        // Events on the m_nbCycles timeline
+        Scheduler m_scheduler;
+        // Emulated time at the cycle m_emulatedTimeCycle, updated when the speed changes
+        uint64_t m_emulatedTime = 0;
+        size_t m_emulatedTimeCycle = 0;
+        RTCMode m_rtcMode = RTCMode::Emulated;
+
+        std::vector<GameSharkCode> m_gameSharkCodes;
 
         bool m_isInBreakMode = false;
         bool m_shouldBreakOnStart = false;
@@ -6,11 +6,27 @@
 #include <cstdint>
 #include <array>
 #include <string>
+#include <unordered_map>
 
 namespace GBEmulator
 {
     class MapperBase;
 
+    // Time followed by the real-time clock of the cartridge (MBC3)
+    enum class RTCMode : uint8_t
+    {
+        Emulated, // Emulated time, deterministic (replays, tests)
+        Host,     // Host wall-clock time, the clock keeps running while the emulator is closed
+    };
+
+    class IEmulatedTimeSource
+    {
+    public:
+        virtual ~IEmulatedTimeSource() = default;
+        // Number of emulated seconds, can't go backward
+        virtual uint64_t GetEmulatedSeconds() const = 0;
+    };
+
     struct Header
     {
         std::array<uint8_t, 0x30> nintendoLogo;
@@ -40,6 +56,8 @@ namespace GBEmulator
         void SerializeTo(Utils::IWriteVisitor& visitor) const override;
         void DeserializeFrom(Utils::IReadVisitor& visitor) override;
 
+        // For the save file. It also contains the time of the real-time clock, so it keeps running
+        // between sessions in RTCMode::Host.
         void SerializeRam(Utils::IWriteVisitor& visitor) const;
         void DeserializeRam(Utils::IReadVisitor& visitor);
 
@@ -54,18 +72,44 @@ namespace GBEmulator
         void Reset();
 
         const Header& GetHeader() const { return m_header; }
+
+        // Return the ROM bank currently mapped at this address (0x0000-0x7FFF)
+        uint16_t GetROMBank(uint16_t addr) const;
         const std::string& GetSHA1() const { return m_sha1; }
 
-        // For cartridge that keep track of time, notify it that a second has passed.
-        void TickSecond();
+        // Pointer to the 256 bytes page at this address (ROM or external RAM), for the bus page tables.
+        // Returns nullptr if the accesses must go through ReadByte/WriteByte (mapper, clock registers, small RAM).
+        // Pointers are valid until the next write in the mapper registers (0x0000-0x7FFF) or RAM deserialization.
+        const uint8_t* GetROMPage(uint16_t addr) const;
+        uint8_t* GetRAMPage(uint16_t addr);
+
+        // Game Genie patches: the ROM byte at this address (0x0000-0x7FFF) reads as data, in the banks that
+        // can be mapped there (bank 0 below 0x4000, the others above) and where the byte is compare (if any).
+        // Patched pages are copies, the ROM is unchanged. Pages must be fetched again after a change.
+        void PatchROM(uint16_t addr, uint8_t data, bool hasCompare, uint8_t compare);
+        void ClearROMPatches();
+
+        // For cartridges that keep track of time. The clock registers are computed from the time source
+        // when accessed.
+        // The source must be detached (nullptr) before it is destroyed, as the cartridge can outlive it.
+        void SetRTCSource(const IEmulatedTimeSource* emulatedTimeSource, RTCMode mode);
+        const IEmulatedTimeSource* GetRTCSource() const;
+        // The clock registers are up to date at the current time (e.g. after the time source was deserialized)
+        void ResetRTCTimeBase();
 
     private:
+        // External RAM and the mapper RAM state, shared by the save file and the save states
+        void SerializeRamState(Utils::IWriteVisitor& visitor) const;
+        void DeserializeRamState(Utils::IReadVisitor& visitor);
+
         Header m_header;
 
         std::string m_sha1;
 
         std::vector<uint8_t> m_externalRAM;
         std::vector<uint8_t> m_prgData;
+        // Copies of the patched ROM pages, by page index in the ROM
+        std::unordered_map<size_t, std::array<uint8_t, 0x100>> m_patchedROMPages;
 
         MapperBase* m_mapper = nullptr;
     };
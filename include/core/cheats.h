@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace GBEmulator
+{
+// Game Genie code, "ABC-DEF" or "ABC-DEF-GHI": the ROM byte at this address reads as data.
+// With a compare value, only if the original byte is equal to it.
+struct GameGenieCode
+{
+    uint16_t address = 0x0000;
+    uint8_t data = 0x00;
+    bool hasCompare = false;
+    uint8_t compare = 0x00;
+};
+
+// GameShark code, "TTDDLLHH" (type, data, address low and high byte): the byte is written in RAM each frame.
+// The address must be in external RAM, WRAM (0xA000-0xDFFF) or HRAM (0xFF80-0xFFFE).
+// Types 0x90-0x97 select the WRAM bank for 0xD000-0xDFFF in GBC mode.
+struct GameSharkCode
+{
+    uint8_t type = 0x01;
+    uint8_t data = 0x00;
+    uint16_t address = 0x0000;
+};
+
+// Dashes and spaces are ignored. Return false if the code is not valid.
+bool ParseGameGenieCode(const std::string& code, GameGenieCode& outCode);
+bool ParseGameSharkCode(const std::string& code, GameSharkCode& outCode);
+} // namespace GBEmulator
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <vector>
 
 namespace GBEmulator 
 {
+    class Bus;
+
     class Controller
     {
     public:
@@ -31,23 +35,34 @@ namespace GBEmulator
             uint8_t reg = 0x00;
         };
 
-        Controller() = default;
+        Controller() { m_queuedInputs.reserve(64); }
         virtual ~Controller() = default;
 
-        void ToggleA(bool value) { m_buttonsStatus.A = value; }
-        void ToggleB(bool value) { m_buttonsStatus.B = value; }
-        void ToggleSelect(bool value) { m_buttonsStatus.Select = value; }
-        void ToggleStart(bool value) { m_buttonsStatus.Start = value; }
-        void ToggleUp(bool value) { m_buttonsStatus.Up = value; }
-        void ToggleDown(bool value) { m_buttonsStatus.Down = value; }
-        void ToggleLeft(bool value) { m_buttonsStatus.Left = value; }
-        void ToggleRight(bool value) { m_buttonsStatus.Right = value; }
+        void ConnectBus(Bus* bus) { m_bus = bus; }
+
+        // Buttons changes are queued, and applied by the bus on the next cycle
+        void ToggleA(bool value) { GetNextStatus().A = value; }
+        void ToggleB(bool value) { GetNextStatus().B = value; }
+        void ToggleSelect(bool value) { GetNextStatus().Select = value; }
+        void ToggleStart(bool value) { GetNextStatus().Start = value; }
+        void ToggleUp(bool value) { GetNextStatus().Up = value; }
+        void ToggleDown(bool value) { GetNextStatus().Down = value; }
+        void ToggleLeft(bool value) { GetNextStatus().Left = value; }
+        void ToggleRight(bool value) { GetNextStatus().Right = value; }
+
+        // Set all the buttons at a given bus cycle (see Bus::GetNbCycles), for deterministic replays.
+        // Changes must be queued in order. Cycles already passed are applied on the next cycle.
+        void QueueInput(size_t cycle, uint8_t buttons);
+
+        // Called by the bus when the next queued change is due: apply all the changes up to this cycle.
+        // Returns true if a button is pressed while none was (joypad interrupt).
+        bool ApplyInputs(size_t cycle);
+        // Schedule the next queued change on the bus
+        void ScheduleInput();
 
         void WriteData(uint8_t data);
         uint8_t ReadData() const;
 
-        bool HasChangedFromHighToLow() const;
-        void Update();
         void Reset();
 
         uint8_t GetButtonsStatus() const { return m_buttonsStatus.reg; }
@@ -55,7 +70,23 @@ namespace GBEmulator
     protected:
         bool IsValidSelection() const;
         ButtonsStatus m_buttonsStatus;
-        ButtonsStatus m_previousStatus;
         ButtonSelection m_buttonSelection = ButtonSelection::None;
+
+    private:
+        struct InputChange
+        {
+            size_t cycle;
+            ButtonsStatus status;
+        };
+
+        // Status after the changes queued for the current cycle. Without bus, changes are immediate.
+        ButtonsStatus& GetNextStatus();
+        bool HasQueuedInputs() const { return m_firstQueuedInput < m_queuedInputs.size(); }
+
+        Bus* m_bus = nullptr;
+        // Ordered by cycle, the ones before m_firstQueuedInput are already applied.
+        // The vector is emptied when all are applied, so it doesn't allocate while running.
+        std::vector<InputChange> m_queuedInputs;
+        size_t m_firstQueuedInput = 0;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace GBEmulator
+{
+// Size of the "RAM code space" tracked by the decode cache.
+// WRAM (all banks, 32kB) is mapped first, followed by the HRAM (rounded to a full page).
+constexpr uint16_t DECODE_CACHE_HRAM_OFFSET = 0x8000;
+constexpr uint16_t DECODE_CACHE_RAM_SIZE = DECODE_CACHE_HRAM_OFFSET + 0x0100;
+constexpr uint16_t DECODE_CACHE_NO_RAM = 0xFFFF;
+
+// Cache of pre-decoded basic blocks.
+// A block is a straight-line run of instructions, stored contiguously in a pool
+// and identified by its start address and the bank mapped at this address
+// (ROM bank for 0x0000-0x7FFF, WRAM bank for 0xC000-0xDFFF).
+// Blocks decoded from RAM are tracked per byte, and any write to one of those bytes
+// invalidates all the blocks of the 256 bytes page it belongs to.
+// Storage is allocated once. When it is full, the whole cache is flushed.
+template <typename Instruction>
+class DecodeCache
+{
+public:
+    struct Block
+    {
+        uint32_t key = EMPTY_KEY;
+        uint32_t firstInstruction = 0;
+        uint16_t nbInstructions = 0;
+        uint16_t ramPage = DECODE_CACHE_NO_RAM;
+        uint32_t generation = 0;
+        // Number of times the block was entered, used to find hot blocks
+        uint32_t nbExecutions = 0;
+        // Native code of the block, when it was compiled
+        const void* nativeCode = nullptr;
+    };
+
+    static constexpr uint32_t MakeKey(uint16_t bank, uint16_t addr) { return ((uint32_t)bank << 16) | addr; }
+
+    DecodeCache()
+    {
+        m_instructions.resize(NB_INSTRUCTIONS);
+        m_blocks.resize(NB_BLOCKS);
+        Clear();
+    }
+
+    void Clear()
+    {
+        for (Block& block : m_blocks)
+            block.key = EMPTY_KEY;
+
+        m_nbUsedInstructions = 0;
+        m_nbUsedBlocks = 0;
+        m_ramCodeBitmap.fill(0x00);
+        m_ramPageGeneration.fill(0);
+        m_epoch++;
+        m_nbFlushes++;
+    }
+
+    // Return the block starting at this key, or nullptr if it is not cached (or no longer valid)
+    Block* Find(uint32_t key)
+    {
+        for (uint32_t index = Hash(key);; index = (index + 1) & (NB_BLOCKS - 1))
+        {
+            Block& block = m_blocks[index];
+            if (block.key == key)
+            {
+                if (block.ramPage != DECODE_CACHE_NO_RAM && block.generation != m_ramPageGeneration[block.ramPage])
+                    return nullptr;
+
+                return &block;
+            }
+
+            if (block.key == EMPTY_KEY)
+                return nullptr;
+        }
+    }
+
+    // Store a newly decoded block, replacing any previous one with the same key.
+    // For blocks decoded from RAM, ramIndex is the index in the RAM code space of the first byte
+    // and nbBytes the total size of the block, that must fit in a single page.
+    Block* Insert(uint32_t key, const Instruction* instructions, uint16_t nbInstructions, uint16_t ramIndex,
+                        uint16_t nbBytes)
+    {
+        if (m_nbUsedInstructions + nbInstructions > NB_INSTRUCTIONS || m_nbUsedBlocks >= MAX_USED_BLOCKS)
+            Clear();
+
+        uint32_t index = Hash(key);
+        while (m_blocks[index].key != EMPTY_KEY && m_blocks[index].key != key)
+            index = (index + 1) & (NB_BLOCKS - 1);
+
+        Block& block = m_blocks[index];
+        if (block.key == EMPTY_KEY)
+            m_nbUsedBlocks++;
+
+        block.key = key;
+        block.firstInstruction = m_nbUsedInstructions;
+        block.nbInstructions = nbInstructions;
+        block.ramPage = DECODE_CACHE_NO_RAM;
+        block.generation = 0;
+        block.nbExecutions = 0;
+        block.nativeCode = nullptr;
+
+        std::copy_n(instructions, nbInstructions, &m_instructions[m_nbUsedInstructions]);
+        m_nbUsedInstructions += nbInstructions;
+
+        if (ramIndex != DECODE_CACHE_NO_RAM)
+        {
+            block.ramPage = ramIndex >> 8;
+            block.generation = m_ramPageGeneration[block.ramPage];
+
+            for (uint16_t i = ramIndex; i < ramIndex + nbBytes; ++i)
+                m_ramCodeBitmap[i >> 3] |= (1 << (i & 0x07));
+        }
+
+        return &block;
+    }
+
+    const Instruction* GetInstructions(const Block& block) const { return &m_instructions[block.firstInstruction]; }
+    Instruction* GetInstructions(const Block& block) { return &m_instructions[block.firstInstruction]; }
+
+    // Must be called for every write in the RAM code space.
+    void OnRAMWrite(uint16_t ramIndex)
+    {
+        if (m_ramCodeBitmap[ramIndex >> 3] & (1 << (ramIndex & 0x07)))
+            InvalidateRAMPage(ramIndex >> 8);
+    }
+
+    // Must be called when the banks mapped in memory change.
+    void OnMemoryMapChanged() { m_epoch++; }
+
+    // Epoch changes each time a block could have become invalid. Pointers to blocks
+    // retrieved with the same epoch are still valid.
+    uint32_t GetEpoch() const { return m_epoch; }
+
+    // Number of times the whole cache was flushed. All the instructions stored before
+    // a flush are dropped.
+    uint32_t GetNbFlushes() const { return m_nbFlushes; }
+
+    // One bit per byte of the RAM code space, set when the byte is part of a decoded block
+    const uint8_t* GetRAMCodeBitmap() const { return m_ramCodeBitmap.data(); }
+
+private:
+    static constexpr uint32_t EMPTY_KEY = 0xFFFFFFFF;
+    static constexpr uint32_t NB_INSTRUCTIONS = 0x8000;
+    static constexpr uint32_t NB_BLOCKS = 0x4000;
+    // Keep the hash table at most 3/4 full to keep probing short
+    static constexpr uint32_t MAX_USED_BLOCKS = NB_BLOCKS / 4 * 3;
+
+    static uint32_t Hash(uint32_t key) { return (key * 2654435761u) >> 18; }
+    static_assert(NB_BLOCKS == (1 << (32 - 18)), "Hash function must match the number of blocks");
+
+    void InvalidateRAMPage(uint16_t page)
+    {
+        m_ramPageGeneration[page]++;
+        std::memset(&m_ramCodeBitmap[page << 5], 0x00, 0x20);
+        m_epoch++;
+    }
+
+    std::vector<Instruction> m_instructions;
+    std::vector<Block> m_blocks;
+    uint32_t m_nbUsedInstructions = 0;
+    uint32_t m_nbUsedBlocks = 0;
+
+    std::array<uint8_t, DECODE_CACHE_RAM_SIZE / 8> m_ramCodeBitmap;
+    std::array<uint32_t, DECODE_CACHE_RAM_SIZE / 0x100> m_ramPageGeneration;
+
+    uint32_t m_epoch = 0;
+    uint32_t m_nbFlushes = 0;
+};
+} // namespace GBEmulator
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace GBEmulator
+{
+// Read only view of a complete frame
+struct FrameView
+{
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    // 1 for the first frame published, 0 if no frame was published yet (the buffer is cleared)
+    uint64_t sequence = 0;
+};
+
+// Triple buffering of the screen, between the emulation (producer) and a single consumer, without locks or copies.
+// The producer renders in the back buffer and publishes it when the frame is complete. The consumer
+// acquires the latest published frame, which is never written until the consumer acquires another one.
+// Neither of them ever waits: if the consumer is slow, the producer replaces the published frame.
+class FrameBuffers
+{
+public:
+    explicit FrameBuffers(size_t size)
+    {
+        for (auto& buffer : m_buffers)
+            buffer.resize(size);
+    }
+
+    // Producer side
+    uint8_t* GetBackBuffer() { return m_buffers[m_back].data(); }
+    // Last frame published, still readable by the producer until the next Publish
+    const std::vector<uint8_t>& GetLastPublished() const { return m_buffers[m_lastPublished]; }
+    uint64_t GetNbPublishedFrames() const { return m_nbPublishedFrames; }
+
+    void Publish()
+    {
+        m_sequences[m_back] = ++m_nbPublishedFrames;
+        m_lastPublished = m_back;
+        m_back = m_published.exchange(m_back | NEW_FRAME_FLAG, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Consumer side. The view stays valid until the next call.
+    FrameView Acquire()
+    {
+        if ((m_published.load(std::memory_order_relaxed) & NEW_FRAME_FLAG) != 0)
+            m_front = m_published.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+
+        return FrameView{m_buffers[m_front].data(), m_buffers[m_front].size(), m_sequences[m_front]};
+    }
+
+    // Copy the back buffer in the other ones, when the screen is cleared.
+    // Not thread safe, the consumer must not be reading.
+    void CopyBackBufferToAll()
+    {
+        for (auto& buffer : m_buffers)
+            buffer = m_buffers[m_back];
+    }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x03;
+    static constexpr uint8_t NEW_FRAME_FLAG = 0x04;
+
+    std::array<std::vector<uint8_t>, 3> m_buffers;
+    // Written by the producer before the buffer is published
+    std::array<uint64_t, 3> m_sequences{};
+
+    // Producer only
+    uint8_t m_back = 0;
+    uint8_t m_lastPublished = 1;
+    uint64_t m_nbPublishedFrames = 0;
+
+    // Index of the published frame, with NEW_FRAME_FLAG if the consumer hasn't acquired it yet
+    std::atomic<uint8_t> m_published{1};
+
+    // Consumer only
+    uint8_t m_front = 2;
+};
+} // namespace GBEmulator
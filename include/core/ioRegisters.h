@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace GBEmulator
+{
+// IO registers are between 0xFF00 and 0xFF7F
+constexpr uint16_t IO_REGISTERS_START_ADDR = 0xFF00;
+constexpr uint16_t NB_IO_REGISTERS = 0x0080;
+
+// Table of the handlers of the IO registers, one entry per register.
+// Each peripheral installs the handlers of its own registers (with itself as context),
+// so an access is a single indirect call.
+// Registers without handler (or without a handler for this direction) read 0x00 and ignore writes.
+class IORegisters
+{
+public:
+    using ReadHandler = uint8_t (*)(void* context, uint16_t addr);
+    using WriteHandler = void (*)(void* context, uint16_t addr, uint8_t data);
+
+    IORegisters() { Clear(); }
+
+    void Clear()
+    {
+        for (uint16_t addr = IO_REGISTERS_START_ADDR; addr < IO_REGISTERS_START_ADDR + NB_IO_REGISTERS; ++addr)
+            Remove(addr);
+    }
+
+    // Handlers can be nullptr for read only/write only registers
+    void Install(uint16_t addr, void* context, ReadHandler read, WriteHandler write)
+    {
+        Entry& entry = m_entries[addr & (NB_IO_REGISTERS - 1)];
+        entry.context = context;
+        entry.read = read != nullptr ? read : &ReadNothing;
+        entry.write = write != nullptr ? write : &WriteNothing;
+    }
+
+    void Remove(uint16_t addr) { Install(addr, nullptr, nullptr, nullptr); }
+
+    uint8_t Read(uint16_t addr) const
+    {
+        const Entry& entry = m_entries[addr & (NB_IO_REGISTERS - 1)];
+        return entry.read(entry.context, addr);
+    }
+
+    void Write(uint16_t addr, uint8_t data) const
+    {
+        const Entry& entry = m_entries[addr & (NB_IO_REGISTERS - 1)];
+        entry.write(entry.context, addr, data);
+    }
+
+private:
+    struct Entry
+    {
+        void* context;
+        ReadHandler read;
+        WriteHandler write;
+    };
+
+    static uint8_t ReadNothing(void* /*context*/, uint16_t /*addr*/) { return 0x00; }
+    static void WriteNothing(void* /*context*/, uint16_t /*addr*/, uint8_t /*data*/) {}
+
+    std::array<Entry, NB_IO_REGISTERS> m_entries;
+};
+} // namespace GBEmulator
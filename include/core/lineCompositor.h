@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <core/constants.h>
+#include <core/pixelFormat.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace GBEmulator
+{
+// Pixels of a line, as they come out of the pixel FIFOs (one array per attribute, for SIMD)
+struct LinePixels
+{
+    std::array<uint8_t, GB_INTERNAL_WIDTH> bgColor;
+    std::array<uint8_t, GB_INTERNAL_WIDTH> bgPalette;
+    std::array<uint8_t, GB_INTERNAL_WIDTH> bgPriority;
+    std::array<uint8_t, GB_INTERNAL_WIDTH> objColor;
+    std::array<uint8_t, GB_INTERNAL_WIDTH> objPalette;
+    std::array<uint8_t, GB_INTERNAL_WIDTH> objPriority;
+};
+
+// Final color of each palette entry, in the pixel format of the screen (see ConvertRGB888):
+// BG/window first (palette * 4 + color), then the objects from COMPOSITOR_OBJ_OFFSET.
+constexpr size_t COMPOSITOR_OBJ_OFFSET = 32;
+using CompositorPalette = std::array<uint32_t, 2 * COMPOSITOR_OBJ_OFFSET>;
+
+enum class CompositorImpl : uint8_t
+{
+    Scalar,
+    SSE2, // Selection of the colors only
+    AVX2,
+};
+
+// Best implementation supported by the CPU we are running on
+CompositorImpl GetBestCompositorImpl();
+bool IsCompositorImplSupported(CompositorImpl impl);
+
+// Merge the BG/window and object pixels [begin, end) of a line, and write them in this format
+// from out[begin * GetBytesPerPixel(format)].
+// The object wins if it is not transparent, unless the BG has priority and is not color 0.
+// On GB, the priority is given by the object. On GBC, by either of them, if bgMasterPriority is set (LCDC bit 0).
+void ComposeLine(const LinePixels& pixels, size_t begin, size_t end, const CompositorPalette& palette, bool isGBC,
+                 bool bgMasterPriority, PixelFormat format, uint8_t* out, CompositorImpl impl);
+} // namespace GBEmulator
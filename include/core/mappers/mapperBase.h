@@ -59,6 +59,11 @@ namespace GBEmulator
         }
 
         inline bool IsRamEnabled() const { return m_ramEnabled; }
+        // True if the external RAM can be read and written directly, without the mapper
+        virtual bool HasPlainRAM() const
+        {
+            return m_ramEnabled && (m_endAddrCustomRead <= 0xA000 || m_startAddrCustomRead >= 0xC000);
+        }
         inline uint16_t GetFirstROMBank() const { return m_firstRomBank; }
         inline uint16_t GetSecondROMBank() const { return m_secondRomBank; }
         inline uint8_t GetRAMBank() const { return m_ramBank; }
@@ -66,8 +71,13 @@ namespace GBEmulator
         // Specific for MBC2 
         virtual size_t GetRAMSize() const { return m_header.nbRamBanks * 0x2000; }
 
-        // For all mappers that keep track of time
-        virtual void TickSecond() {}
+        // For all mappers that keep track of time (see Cartridge::SetRTCSource)
+        virtual void SetRTCSource(const IEmulatedTimeSource* emulatedTimeSource, RTCMode mode) {}
+        virtual const IEmulatedTimeSource* GetRTCSource() const { return nullptr; }
+        virtual void ResetRTCTimeBase() {}
+        // Time of the clock registers in the save file
+        virtual void SerializeRTCTime(Utils::IWriteVisitor& visitor) const {}
+        virtual void DeserializeRTCTime(Utils::IReadVisitor& visitor) {}
 
     protected:
         const Header& m_header; 
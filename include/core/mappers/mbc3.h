@@ -30,6 +30,8 @@ namespace GBEmulator
     public:
         MBC3(const Header& header);
 
+        void SerializeTo(Utils::IWriteVisitor& visitor) const override;
+        void DeserializeFrom(Utils::IReadVisitor& visitor) override;
         void SerializeRam(Utils::IWriteVisitor& visitor) const override;
         void DeserializeRam(Utils::IReadVisitor& visitor) override;
 
@@ -38,15 +40,38 @@ namespace GBEmulator
         bool WriteByte(uint16_t addr, uint8_t data) override;
         bool ReadByte(uint16_t addr, uint8_t& data) const override;
 
-        void TickSecond() override;
+        void SetRTCSource(const IEmulatedTimeSource* emulatedTimeSource, RTCMode mode) override;
+        const IEmulatedTimeSource* GetRTCSource() const override { return m_emulatedTimeSource; }
+        void ResetRTCTimeBase() override { m_clockBaseTime = GetTime(); }
+        void SerializeRTCTime(Utils::IWriteVisitor& visitor) const override;
+        void DeserializeRTCTime(Utils::IReadVisitor& visitor) override;
 
     private:
-        uint8_t* GetClockRegister();
-        const uint8_t* GetClockRegister() const { return const_cast<MBC3*>(this)->GetClockRegister(); }
+        uint8_t* GetClockRegister(ClockCounterRegisters& registers) const;
+        const uint8_t* GetClockRegister(const ClockCounterRegisters& registers) const
+        {
+            return GetClockRegister(const_cast<ClockCounterRegisters&>(registers));
+        }
+
+        // Current time of the RTC source, in seconds
+        uint64_t GetTime() const;
+        // The clock registers are only updated when accessed, from the time elapsed since the last update
+        void SyncClock() const;
+        static void TickSecond(ClockCounterRegisters& registers);
+        // Same as calling TickSecond nbSeconds times
+        static void AdvanceClock(ClockCounterRegisters& registers, uint64_t nbSeconds);
 
         uint8_t m_currentClockRegister = 0xFF;
-        ClockCounterRegisters m_clockRegisters;
+        mutable ClockCounterRegisters m_clockRegisters;
+        // Reads return the registers copied on the last latch (0x00 then 0x01 written in 0x6000-0x7FFF),
+        // or the current ones if they were never latched
         ClockCounterRegisters m_latchedClockRegisters;
         bool m_isLatched = false;
+        uint8_t m_lastLatchData = 0xFF;
+
+        const IEmulatedTimeSource* m_emulatedTimeSource = nullptr;
+        RTCMode m_rtcMode = RTCMode::Emulated;
+        // Time when the clock registers were last updated
+        mutable uint64_t m_clockBaseTime = 0;
     };
 }
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <core/registerFiles.h>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace GBEmulator
+{
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+// Emulated memory of a console, and the registers holding plain data, in a single allocation owned by the bus.
+// Each block starts on its own cache line. The arena is plain data, it can be copied
+// with a single memcpy (rewind, cloning a state), see Bus::RestoreMemory.
+struct alignas(CACHE_LINE_SIZE) MemoryArena
+{
+    // 32kB work ram in GBC mode, limited to 8kB in GB mode
+    using WorkRAM = std::array<uint8_t, 0x8000>;
+    // 16kB video ram in GBC mode, limited to 8kB in GB mode
+    using VideoRAM = std::array<uint8_t, 0x4000>;
+    using HighRAM = std::array<uint8_t, 127>;
+    // 4 bytes per entry, 40 entries
+    using ObjectAttributeMemory = std::array<OAMEntry, 40>;
+
+    alignas(CACHE_LINE_SIZE) WorkRAM workRAM;
+    alignas(CACHE_LINE_SIZE) VideoRAM videoRAM;
+    alignas(CACHE_LINE_SIZE) ObjectAttributeMemory OAM;
+    alignas(CACHE_LINE_SIZE) HighRAM highRAM;
+
+    alignas(CACHE_LINE_SIZE) BusRegisterFile busRegisters;
+    LCDRegisterFile lcdRegisters;
+};
+
+static_assert(std::is_trivially_copyable_v<MemoryArena>, "The memory arena must be copyable with memcpy");
+} // namespace GBEmulator
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace GBEmulator
+{
+// Format of the pixels of the screen, chosen when the bus is created.
+// 16 and 32 bits formats are stored in the native byte order (like libretro expects them).
+enum class PixelFormat : uint8_t
+{
+    RGB888,   // 3 bytes: R, G, B
+    XRGB8888, // uint32_t: 0x00RRGGBB
+    RGB565,   // uint16_t
+    RGB555,   // uint16_t, 0RGB1555 with the top bit cleared
+    Y8,       // 1 byte: luminance
+    Shade,    // 1 byte: 0 (lightest) to 3 (darkest). The DMG shade, or the luminance on GBC.
+};
+
+constexpr size_t GetBytesPerPixel(PixelFormat format)
+{
+    switch (format)
+    {
+    case PixelFormat::RGB888:
+        return 3;
+    case PixelFormat::XRGB8888:
+        return 4;
+    case PixelFormat::RGB565:
+    case PixelFormat::RGB555:
+        return 2;
+    default:
+        return 1;
+    }
+}
+
+// Pixel value of this color, to write with WritePixel
+constexpr uint32_t ConvertRGB888(uint8_t r, uint8_t g, uint8_t b, PixelFormat format)
+{
+    // BT.601 luma
+    const uint32_t luminance = (77 * r + 150 * g + 29 * b) >> 8;
+
+    switch (format)
+    {
+    case PixelFormat::RGB888:
+        return r | (g << 8) | (b << 16);
+    case PixelFormat::XRGB8888:
+        return (r << 16) | (g << 8) | b;
+    case PixelFormat::RGB565:
+        return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+    case PixelFormat::RGB555:
+        return ((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3);
+    case PixelFormat::Y8:
+        return luminance;
+    case PixelFormat::Shade:
+        return 3 - (luminance >> 6);
+    }
+
+    return 0;
+}
+
+template <size_t BytesPerPixel>
+inline void WritePixel(uint32_t pixel, uint8_t* out)
+{
+    if constexpr (BytesPerPixel == 4)
+    {
+        std::memcpy(out, &pixel, 4);
+    }
+    else if constexpr (BytesPerPixel == 3)
+    {
+        out[0] = (uint8_t)pixel;
+        out[1] = (uint8_t)(pixel >> 8);
+        out[2] = (uint8_t)(pixel >> 16);
+    }
+    else if constexpr (BytesPerPixel == 2)
+    {
+        const uint16_t value = (uint16_t)pixel;
+        std::memcpy(out, &value, 2);
+    }
+    else
+    {
+        out[0] = (uint8_t)pixel;
+    }
+}
+
+inline void WritePixel(uint32_t pixel, PixelFormat format, uint8_t* out)
+{
+    switch (GetBytesPerPixel(format))
+    {
+    case 4:
+        WritePixel<4>(pixel, out);
+        break;
+    case 3:
+        WritePixel<3>(pixel, out);
+        break;
+    case 2:
+        WritePixel<2>(pixel, out);
+        break;
+    default:
+        WritePixel<1>(pixel, out);
+        break;
+    }
+}
+} // namespace GBEmulator
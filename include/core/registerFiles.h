@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+
+namespace GBEmulator
+{
+union InterruptRegister
+{
+    struct
+    {
+        uint8_t vBlank : 1;
+        uint8_t lcdStat : 1;
+        uint8_t timer : 1;
+        uint8_t serial : 1;
+        uint8_t joypad : 1;
+        uint8_t unused : 3;
+    };
+
+    uint8_t flag = 0x00;
+};
+
+union LCDRegister
+{
+    struct
+    {
+        uint8_t BGAndWindowPriority : 1;
+        uint8_t objEnable : 1;
+        uint8_t objSize : 1;
+        uint8_t bgTileMapArea : 1;
+        uint8_t BGAndWindowTileAreaData : 1;
+        uint8_t windowEnable : 1;
+        uint8_t windowTileMapArea : 1;
+        uint8_t enable : 1;
+    };
+
+    uint8_t flags = 0x00;
+};
+
+union LCDStatus
+{
+    struct
+    {
+        uint8_t mode : 2;
+        uint8_t lYcEqualLY : 1;
+        // Interrupt sources (IS)
+        uint8_t mode0HBlankIS : 1;
+        uint8_t mode1VBlankIS : 1;
+        uint8_t mode2OAMIS : 1;
+        uint8_t lYcEqualLYIS : 1;
+        uint8_t unused : 1;
+    };
+
+    uint8_t flags = 0x00;
+};
+
+union GBPaletteData
+{
+    struct
+    {
+        uint8_t color0 : 2;
+        uint8_t color1 : 2;
+        uint8_t color2 : 2;
+        uint8_t color3 : 2;
+    };
+
+    uint8_t flags = 0x00;
+};
+
+union Attributes
+{
+    struct
+    {
+        uint8_t paletteNumberGBC : 3;
+        uint8_t tileVRAMBank : 1;
+        uint8_t paletteNumberGB : 1;
+        uint8_t xFlip : 1;
+        uint8_t yFlip : 1;
+        uint8_t bgAndWindowOverObj : 1;
+    };
+
+    uint8_t flags = 0x00;
+};
+
+struct OAMEntry
+{
+    uint8_t xPosition = 0x00;
+    uint8_t yPosition = 0x00;
+    uint8_t tileIndex = 0x00;
+
+    Attributes attributes;
+};
+
+// Registers of the bus holding plain data: interrupts and WRAM bank (0xFF0F, 0xFF70 and 0xFFFF)
+struct BusRegisterFile
+{
+    InterruptRegister IE;
+    InterruptRegister IF;
+    uint8_t currentWRAMBank = 0x01;
+};
+
+// LCD registers holding plain data (0xFF40-0xFF4B, except DMA), and the VRAM bank in GBC mode
+struct LCDRegisterFile
+{
+    LCDRegister lcdRegister;
+    LCDStatus lcdStatus;
+
+    uint8_t scrollY = 0x00;
+    uint8_t scrollX = 0x00;
+    uint8_t lY = 0x00;
+    uint8_t lYC = 0x00;
+    uint8_t wY = 0x00;
+    uint8_t wX = 0x00;
+
+    GBPaletteData gbBGPalette;
+    GBPaletteData gbOBJ0Palette;
+    GBPaletteData gbOBJ1Palette;
+
+    uint8_t currentVRAMBank = 0x00;
+};
+} // namespace GBEmulator
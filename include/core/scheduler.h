@@ -0,0 +1,146 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace GBEmulator
+{
+// Events scheduled on the bus timeline
+enum class SchedulerEvent : uint8_t
+{
+    TimerOverflow,   // TIMA overflow, raises the timer interrupt
+    JoypadInput,     // Queued change of the buttons
+    SpeedSwitchDone, // CPU resumes after a speed switch
+    Count
+};
+
+// Priority queue of timestamped events, ordered by cycle (binary heap).
+// Timestamps are in bus cycles. There is at most one pending event of each type,
+// scheduling it again moves it.
+class Scheduler
+{
+public:
+    static constexpr uint64_t NEVER = UINT64_MAX;
+
+    Scheduler() { Clear(); }
+
+    void Clear()
+    {
+        m_size = 0;
+        m_positions.fill(NOT_SCHEDULED);
+    }
+
+    void Schedule(SchedulerEvent event, uint64_t cycle)
+    {
+        uint8_t pos = m_positions[(size_t)event];
+        if (pos == NOT_SCHEDULED)
+        {
+            pos = m_size++;
+            m_heap[pos] = {cycle, event};
+            m_positions[(size_t)event] = pos;
+            SiftUp(pos);
+            return;
+        }
+
+        const uint64_t previousCycle = m_heap[pos].cycle;
+        m_heap[pos].cycle = cycle;
+        if (cycle < previousCycle)
+            SiftUp(pos);
+        else
+            SiftDown(pos);
+    }
+
+    void Cancel(SchedulerEvent event)
+    {
+        const uint8_t pos = m_positions[(size_t)event];
+        if (pos == NOT_SCHEDULED)
+            return;
+
+        m_positions[(size_t)event] = NOT_SCHEDULED;
+        if (--m_size == pos)
+            return;
+
+        // Move the last entry in the hole and restore the heap
+        const SchedulerEvent moved = m_heap[m_size].event;
+        m_heap[pos] = m_heap[m_size];
+        m_positions[(size_t)moved] = pos;
+        SiftUp(pos);
+        SiftDown(m_positions[(size_t)moved]);
+    }
+
+    bool IsScheduled(SchedulerEvent event) const { return m_positions[(size_t)event] != NOT_SCHEDULED; }
+
+    uint64_t GetEventCycle(SchedulerEvent event) const
+    {
+        const uint8_t pos = m_positions[(size_t)event];
+        return pos != NOT_SCHEDULED ? m_heap[pos].cycle : NEVER;
+    }
+
+    uint64_t GetNextEventCycle() const { return m_size > 0 ? m_heap[0].cycle : NEVER; }
+
+    // Remove the next event if it is due at the given cycle
+    bool PopDueEvent(uint64_t cycle, SchedulerEvent& outEvent, uint64_t& outEventCycle)
+    {
+        if (m_size == 0 || m_heap[0].cycle > cycle)
+            return false;
+
+        outEvent = m_heap[0].event;
+        outEventCycle = m_heap[0].cycle;
+        Cancel(outEvent);
+        return true;
+    }
+
+private:
+    static constexpr uint8_t NOT_SCHEDULED = 0xFF;
+    static constexpr size_t NB_EVENTS = (size_t)SchedulerEvent::Count;
+
+    struct Entry
+    {
+        uint64_t cycle;
+        SchedulerEvent event;
+    };
+
+    void SiftUp(uint8_t pos)
+    {
+        while (pos > 0)
+        {
+            const uint8_t parent = (pos - 1) / 2;
+            if (m_heap[parent].cycle <= m_heap[pos].cycle)
+                break;
+            Swap(parent, pos);
+            pos = parent;
+        }
+    }
+
+    void SiftDown(uint8_t pos)
+    {
+        while (true)
+        {
+            const uint8_t left = 2 * pos + 1;
+            const uint8_t right = left + 1;
+            uint8_t smallest = pos;
+            if (left < m_size && m_heap[left].cycle < m_heap[smallest].cycle)
+                smallest = left;
+            if (right < m_size && m_heap[right].cycle < m_heap[smallest].cycle)
+                smallest = right;
+            if (smallest == pos)
+                break;
+            Swap(smallest, pos);
+            pos = smallest;
+        }
+    }
+
+    void Swap(uint8_t a, uint8_t b)
+    {
+        std::swap(m_heap[a], m_heap[b]);
+        m_positions[(size_t)m_heap[a].event] = a;
+        m_positions[(size_t)m_heap[b].event] = b;
+    }
+
+    std::array<Entry, NB_EVENTS> m_heap;
+    std::array<uint8_t, NB_EVENTS> m_positions;
+    uint8_t m_size;
+};
+} // namespace GBEmulator
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace GBEmulator
+{
+// Cache of the VRAM tiles (0x8000-0x97FF, both banks) decoded in color indices (0-3),
+// one byte per pixel, with a copy flipped horizontally.
+// Writes in the tile data mark the tile dirty, and it is decoded again the next time it is read.
+// Storage is allocated once.
+class TileCache
+{
+public:
+    static constexpr size_t NB_TILES_PER_BANK = 384;
+    static constexpr size_t NB_TILES = 2 * NB_TILES_PER_BANK;
+
+    TileCache()
+    {
+        m_pixels.resize(NB_TILES * TILE_SIZE);
+        InvalidateAll();
+    }
+
+    // Must be called for every write in VRAM (addr in 0x8000-0x9FFF)
+    void OnVRAMWrite(uint16_t addr, uint8_t bank)
+    {
+        const uint16_t offset = addr & 0x1FFF;
+        if (offset < 0x1800)
+            MarkDirty(bank * NB_TILES_PER_BANK + (offset >> 4));
+    }
+
+    // Same for size bytes written from addr
+    void OnVRAMWrite(uint16_t addr, uint8_t bank, uint16_t size)
+    {
+        const size_t begin = addr & 0x1FFF;
+        const size_t end = std::min<size_t>(begin + size, 0x1800);
+        for (size_t tile = begin >> 4; tile < (end + 15) >> 4; ++tile)
+            MarkDirty(bank * NB_TILES_PER_BANK + tile);
+    }
+
+    void InvalidateAll() { m_dirtyBitmap.fill(0xFF); }
+
+    // 8 pixels of the row of the tile at this address (0x8000-0x97FF, the row is given by the address),
+    // from left to right, or right to left if xFlip.
+    const uint8_t* GetRow(const uint8_t* bankData, uint16_t addr, uint8_t bank, bool xFlip)
+    {
+        const size_t tile = bank * NB_TILES_PER_BANK + ((addr & 0x1FFF) >> 4);
+        if (IsDirty(tile))
+            Decode(bankData, tile);
+
+        return &m_pixels[tile * TILE_SIZE + (xFlip ? 64 : 0) + ((addr >> 1) & 0x07) * 8];
+    }
+
+private:
+    // 8 rows of 8 pixels, then the same flipped
+    static constexpr size_t TILE_SIZE = 2 * 64;
+
+    bool IsDirty(size_t tile) const { return (m_dirtyBitmap[tile >> 3] & (1 << (tile & 0x07))) != 0; }
+    void MarkDirty(size_t tile) { m_dirtyBitmap[tile >> 3] |= (1 << (tile & 0x07)); }
+
+    // bankData is the VRAM bank of the tile
+    void Decode(const uint8_t* bankData, size_t tile)
+    {
+        const uint8_t* data = bankData + (tile % NB_TILES_PER_BANK) * 16;
+        uint8_t* pixels = &m_pixels[tile * TILE_SIZE];
+        for (size_t row = 0; row < 8; ++row)
+        {
+            const uint8_t lsb = data[2 * row];
+            const uint8_t msb = data[2 * row + 1];
+            for (size_t x = 0; x < 8; ++x)
+            {
+                const uint8_t color = (((msb >> (7 - x)) & 0x01) << 1) | ((lsb >> (7 - x)) & 0x01);
+                pixels[row * 8 + x] = color;
+                pixels[64 + row * 8 + 7 - x] = color;
+            }
+        }
+
+        m_dirtyBitmap[tile >> 3] &= ~(1 << (tile & 0x07));
+    }
+
+    std::vector<uint8_t> m_pixels;
+    std::array<uint8_t, NB_TILES / 8> m_dirtyBitmap;
+};
+} // namespace GBEmulator
@@ -1,26 +1,66 @@
 #pragma once
 
+#include <core/ioRegisters.h>
 #include <core/serializable.h>
+#include <cstddef>
 #include <cstdint>
 
 namespace GBEmulator
 {
+    class Bus;
+
+    // The timer is not clocked: DIV and TIMA are computed from the number of clocks elapsed
+    // since the last access (4 clocks per bus cycle), and the next overflow is scheduled on the bus.
     class Timer : public ISerializable
     {
     public:
         Timer();
 
-        uint8_t ReadByte(uint16_t addr, bool readOnly = false);
-        void WriteByte(uint16_t addr, uint8_t data);
+        void ConnectBus(Bus* bus) { m_bus = bus; }
+
+        // DIV, TIMA, TMA and TAC (0xFF04-0xFF07)
+        void InstallIORegisters(IORegisters& registers);
         void Reset();
 
-        // Returns true if the timer counter overflows (needs to fire an interrupt)
-        bool Clock();
+        // Bring the registers up to date with the bus
+        void Sync();
+
+        // Must be called on the scheduled overflow: reload the counter and schedule the next one
+        void OnOverflow();
+
+        // Schedule the next overflow on the bus (or cancel it if the timer is disabled)
+        void ScheduleOverflow();
+
+        // Number of clocks until the next overflow, the overflow happening on the last one.
+        // Returns SIZE_MAX if the timer is disabled.
+        size_t GetNbClocksBeforeOverflow() const;
+
+        // Number of clocks until the value of the given register changes, the change happening on the last one.
+        // Returns SIZE_MAX if it can't change. The timer must be synchronized.
+        size_t GetNbClocksBeforeChange(uint16_t addr) const;
 
         void SerializeTo(Utils::IWriteVisitor& visitor) const override;
         void DeserializeFrom(Utils::IReadVisitor& visitor) override;
 
     private:
+        void WriteTimerControl(uint8_t data);
+
+        // State of the bit of the internal counter selected by TAC (always 0 if the timer is disabled)
+        bool IsCounterBitSet() const;
+        // After a write in DIV or TAC, the timer being synchronized: increment TIMA if the bit fell,
+        // and schedule the next overflow
+        void OnCounterBitChanged(bool wasCounterBitSet);
+
+        // Current time, in timer clocks
+        size_t GetNbClocksFromBus() const;
+
+        // Same as clocking the timer nbClocks times
+        void Advance(size_t nbClocks);
+        // Increment the divider and the counter, without handling the overflow
+        void Count(size_t nbClocks);
+
+        Bus* m_bus = nullptr;
+
         uint8_t m_divider;
         uint8_t m_timerCounter;
         uint8_t m_timerModulo;
@@ -29,5 +69,8 @@ namespace GBEmulator
         bool m_enabled;
 
         size_t m_nbClocks;
+
+        // Bus time of the last synchronization, in timer clocks
+        size_t m_lastSyncClock = 0;
     };
-}
\ No newline at end of file
+}
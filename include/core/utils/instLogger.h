@@ -21,6 +21,7 @@ namespace GBEmulator
         void OpenFileVisitor(const std::string& filepath);
 
         void WriteCurrentState();
+        bool IsEnabled() const { return m_visitor != nullptr; }
         void Reset();
 
     private:
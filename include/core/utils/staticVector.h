@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+
+namespace GBEmulator
+{
+namespace Utils
+{
+// Vector with a fixed capacity, stored inline: it never allocates.
+// Same interface as std::vector for what we use (and for the visitors containers).
+template <typename T, size_t N>
+class MyStaticVector
+{
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    void push_back(const T& item)
+    {
+        assert(m_size < N && "Vector overflow");
+        m_buffer[m_size++] = item;
+    }
+
+    void resize(size_t size)
+    {
+        assert(size <= N && "Vector overflow");
+        for (size_t i = m_size; i < size; ++i)
+            m_buffer[i] = T();
+        m_size = size;
+    }
+
+    void clear() { m_size = 0; }
+
+    size_t size() const { return m_size; }
+    static constexpr size_t capacity() { return N; }
+    bool empty() const { return m_size == 0; }
+    bool full() const { return m_size == N; }
+
+    T* data() { return m_buffer.data(); }
+    const T* data() const { return m_buffer.data(); }
+
+    T& operator[](size_t index) { return m_buffer[index]; }
+    const T& operator[](size_t index) const { return m_buffer[index]; }
+    T& back() { return m_buffer[m_size - 1]; }
+    const T& back() const { return m_buffer[m_size - 1]; }
+
+    iterator begin() { return m_buffer.data(); }
+    iterator end() { return m_buffer.data() + m_size; }
+    const_iterator begin() const { return m_buffer.data(); }
+    const_iterator end() const { return m_buffer.data() + m_size; }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+private:
+    std::array<T, N> m_buffer;
+    size_t m_size = 0;
+};
+} // namespace Utils
+} // namespace GBEmulator
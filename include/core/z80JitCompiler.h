@@ -0,0 +1,186 @@
+#pragma once
+
+#include <cstddef>
+#include <core/utils/staticVector.h>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define GBEMULATOR_JIT_SUPPORTED 1
+#else
+#define GBEMULATOR_JIT_SUPPORTED 0
+#endif
+
+namespace GBEmulator
+{
+class Z80Processor;
+
+// Translate blocks of decoded instructions into native x86-64 code.
+// A whole block is compiled into a single function, run by the CPU while nothing else can happen on the bus
+// (see Z80Processor::RunCompiledCode). Registers stay in the CPU object, and flags are always computed in F.
+// ROM, WRAM, external RAM and HRAM are accessed directly through the page tables of the bus. Anything else
+// (IO registers, VRAM writes, mapper registers...) leaves the function before the instruction, so it is run
+// by the interpreter at the right cycle.
+// The function is given a number of cycles and stops before the first instruction that could go past it.
+// It returns the number of cycles done in the low 16 bits, and the number of instructions in the high bits.
+class Z80JitCompiler
+{
+public:
+    using NativeBlock = uint32_t (*)(Z80Processor&, uint32_t);
+    // Same as the instruction handlers of the CPU
+    using InstructionHandler = uint8_t (*)(Z80Processor&, uint8_t);
+
+    // Maximum number of instructions in a block
+    static constexpr uint16_t MAX_BLOCK_LENGTH = 64;
+
+    Z80JitCompiler(const Z80Processor& cpu);
+    ~Z80JitCompiler();
+
+    Z80JitCompiler(const Z80JitCompiler&) = delete;
+    Z80JitCompiler& operator=(const Z80JitCompiler&) = delete;
+
+    // Executable memory is only allocated the first time the JIT is used.
+    // Returns false if the JIT can't run on this platform.
+    bool Allocate();
+    bool IsAvailable() const { return m_code != nullptr; }
+
+    // Compile a block: BeginBlock(), then the instructions in order with CompileInstruction(), then EndBlock().
+    // CompileInstruction() returns false if the instruction can't be compiled, the block then ends before it.
+    // EndBlock() returns nullptr if nothing was compiled, or if there is no more room for code.
+    void BeginBlock();
+    bool CompileInstruction(uint16_t address, uint8_t firstByte, uint8_t opcode, uint16_t operand, uint8_t length,
+                            InstructionHandler handler);
+    NativeBlock EndBlock();
+
+    // Drop all the compiled code. Blocks previously returned must not be used anymore.
+    void Reset();
+
+    size_t GetNbCompiledInstructions() const { return m_nbCompiledInstructions; }
+
+private:
+    // Offsets of the members used by the native code, in the CPU and in the bus
+    struct Offsets
+    {
+        int32_t A;
+        int32_t F;
+        int32_t PC;
+        int32_t lazyFlagsOperation;
+        // Indexed like the 8 bits registers of the opcodes (B, C, D, E, H, L, (HL), A)
+        int32_t registers[8];
+        // Indexed like the 16 bits registers of the opcodes (BC, DE, HL, SP)
+        int32_t wordRegisters[4];
+        int32_t AF;
+        int32_t bus;
+        int32_t opcodeCount;
+        int32_t ramCodeBitmap;
+
+        int32_t readPages;
+        int32_t writePages;
+    };
+
+    // Memory operand: [base + index + displacement]
+    static constexpr uint8_t NO_INDEX = 0xFF;
+    struct Memory
+    {
+        uint8_t base;
+        int32_t displacement;
+        uint8_t index = NO_INDEX;
+    };
+
+    // Where to go when leaving the block before an instruction
+    struct Exit
+    {
+        uint16_t address;
+        uint16_t nbCycles;
+        uint16_t nbInstructions;
+    };
+
+    struct ExitJump
+    {
+        // Position of the rel32 to patch
+        size_t position;
+        uint16_t exitIndex;
+    };
+
+    // Encoding. Registers are numbered like in the instruction set (0 = rax, 8 = r8...).
+    // Operation flags: WIDE for 64 bits operands, WORD for 16 bits operands.
+    static constexpr uint8_t WIDE = 0x01;
+    static constexpr uint8_t WORD = 0x02;
+    void Emit8(uint8_t value) { m_buffer.push_back(value); }
+    void Emit16(uint16_t value);
+    void Emit32(uint32_t value);
+    void Emit64(uint64_t value);
+    // Opcode is one byte, or two bytes starting with 0x0F
+    void EmitOpcode(uint16_t opcode, uint8_t flags, uint8_t reg, uint8_t index, uint8_t base);
+    void EmitMemoryOperation(uint16_t opcode, uint8_t reg, const Memory& memory, uint8_t flags = 0);
+    void EmitRegisterOperation(uint16_t opcode, uint8_t reg, uint8_t rm, uint8_t flags = 0);
+    Memory CPU(int32_t offset) const;
+
+    // Jumps inside the block, with 8 bits displacements, and to the exit of the current instruction
+    size_t EmitShortJump(uint8_t opcode);
+    void PatchShortJump(size_t position);
+    void EmitExitJump(uint8_t condition);
+
+    // Leave the block with the given PC (if not already written), cycles and number of instructions
+    void EmitReturn(uint16_t nbCycles, uint16_t nbInstructions);
+    void EmitReturnToAddress(uint16_t address, uint16_t nbCycles, uint16_t nbInstructions);
+    // Call a static function of the CPU, with the CPU as first argument
+    void EmitCall(const void* function);
+
+    // Compute the Game Boy flags from the x86 flags of the last operation and write them to F.
+    // F = (F & keep) | (computed & use) | set
+    void EmitFlags(uint8_t use, uint8_t keep, uint8_t set);
+    // Flags of the rotations and shifts: Z from the result in AL, C from DL (0 or 1), N and H cleared
+    void EmitShiftFlags(bool zeroFlag);
+    // Make sure that F is up to date (lazy flags) before reading or writing it
+    void EmitMaterializeFlags();
+
+    // Memory accesses, for the address in r8d.
+    // Gives the host pointer in r10, and for writes the index in the decode cache RAM code space in r11d.
+    // Leaves the block if the memory can't be accessed directly.
+    void EmitResolveAddress(bool isWrite, uint8_t nbBytes);
+    // Must be called after writing the bytes, to invalidate the decoded code
+    void EmitWriteNotification(uint8_t nbBytes);
+    // Address of the operand of the instruction in r8d, for (HL), (BC), (DE), (a16) and (C)
+    void EmitLoadAddress(int32_t wordRegisterOffset);
+    // Push the 16 bits value in DX on the stack
+    void EmitPush();
+    // Pop a 16 bits value from the stack in EDX
+    void EmitPop();
+
+    // Instruction emitters. They return the number of cycles when the block continues after them,
+    // or 0 if the instruction can't be compiled.
+    uint8_t EmitInstruction(uint16_t address, uint8_t opcode, uint16_t operand, uint8_t length,
+                            InstructionHandler handler);
+    uint8_t EmitCBInstruction(uint8_t opcode);
+    uint8_t EmitALU(uint8_t operation, bool literal, uint8_t registerIndex, uint8_t operand);
+    // Jumps to PC when the condition (bits 3 and 4 of the opcode) is met. All the jumps leave the block.
+    void EmitConditionalExit(uint8_t opcode, bool isConditional, uint16_t nextAddress, uint8_t nbCyclesTaken);
+    bool EmitLoadStore(uint8_t opcode, uint16_t operand);
+
+    // Load a register or (HL) (already resolved) in AL
+    void EmitLoadOperand(uint8_t registerIndex);
+
+    const Z80Processor& m_cpu;
+    Offsets m_offsets;
+
+    // Executable memory
+    uint8_t* m_code = nullptr;
+    size_t m_codeSize = 0;
+    size_t m_codeUsed = 0;
+
+    // Block being compiled. Reserved once, so nothing is allocated while running.
+    static constexpr size_t MAX_BLOCK_CODE_SIZE = 32 * 1024;
+    // The longest instructions are around 300 bytes
+    static constexpr size_t MAX_INSTRUCTION_CODE_SIZE = 1024;
+    std::vector<uint8_t> m_buffer;
+    Utils::MyStaticVector<Exit, MAX_BLOCK_LENGTH + 1> m_exits;
+    static constexpr size_t MAX_EXIT_JUMPS = MAX_BLOCK_LENGTH * 8;
+    Utils::MyStaticVector<ExitJump, MAX_EXIT_JUMPS> m_exitJumps;
+    uint16_t m_nbCycles = 0;
+    uint16_t m_nextAddress = 0x0000;
+    bool m_isBlockTerminated = false;
+
+    size_t m_nbCompiledInstructions = 0;
+};
+} // namespace GBEmulator
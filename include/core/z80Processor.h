@@ -1,12 +1,15 @@
 #pragma once
 
 #include <array>
+#include <core/decodeCache.h>
 #include <core/serializable.h>
+#include <core/utils/staticVector.h>
 #include <core/utils/visitor.h>
+#include <core/z80JitCompiler.h>
 #include <cstdint>
-#include <map>
 #include <string>
 #include <type_traits>
+#include <utility>
 
 namespace GBEmulator
 {
@@ -80,9 +83,51 @@ union RegisterHL
     uint16_t HL = 0x0000;
 };
 
+// How decoded instructions are dispatched to their handler
+// Specialized: one handler per opcode, generated at compile time, with register
+//              selection and cycle counts resolved as constants.
+// Generic: look up the handler in the opcodes map and decode the register operand
+//          at runtime (reference implementation).
+// Jit: like specialized, but hot blocks from ROM are compiled to native code
+//      (x86-64 only, same as specialized on other platforms).
+enum class DispatchMode
+{
+    Specialized,
+    Generic,
+    Jit
+};
+
+// Operation that last changed the flags. Flags are only computed from its operands
+// when they are needed.
+enum class FlagsOperation : uint8_t
+{
+    None, // Flags are up to date in F
+    Add,  // Z, H and C from the operands, N = 0
+    Sub,  // Z, H and C from the operands, N = 1
+    And,  // Z from the result, H = 1, N = C = 0
+    Or,   // OR and XOR. Z from the result, N = H = C = 0
+    Inc,  // Z and H from the operands, N = 0, C untouched
+    Dec,  // Z and H from the operands, N = 1, C untouched
+    Bit,  // Z from the result, N = 0, H = 1, C untouched
+    Shift // Rotations and shifts. Z from the result, C is the bit shifted out, N = H = 0
+};
+
+struct LazyFlags
+{
+    FlagsOperation operation = FlagsOperation::None;
+    uint8_t left = 0;
+    uint8_t right = 0;
+    // Carry used by the operation, or carry to set for Inc/Dec/Bit/Shift
+    uint8_t carry = 0;
+    uint8_t result = 0;
+};
+
 class Z80Processor : public ISerializable
 {
 public:
+    // Needs to know where the registers are
+    friend class Z80JitCompiler;
+
     Z80Processor();
 
     void SetDump(bool value) { m_dumpEnabled = value; }
@@ -93,7 +138,12 @@ public:
     void Reset();
     bool Clock();
 
-    RegisterAF GetAFRegister() const { return m_AF; }
+    RegisterAF GetAFRegister() const
+    {
+        RegisterAF af = m_AF;
+        af.F = ComputeFlags();
+        return af;
+    }
     RegisterBC GetBCRegister() const { return m_BC; }
     RegisterDE GetDERegister() const { return m_DE; }
     RegisterHL GetHLRegister() const { return m_HL; }
@@ -115,6 +165,14 @@ public:
 
     bool IsStopped() const { return m_isStopped; }
     bool IsPaused() const { return m_isPaused; }
+    // Paused by HALT/STOP with nothing left to do on the next clocks (but check interrupts).
+    // Used by the bus to fast-forward until an interrupt wakes it up.
+    bool IsWaitingForInterrupt() const { return m_isPaused && !m_IMEScheduled; }
+
+    // Will be used by the bus each time IF or IE changes. An interrupt is pending if one is
+    // both requested and enabled (IF & IE), it is cached so Clock() doesn't have to check them.
+    void OnInterruptFlagsChanged();
+    bool IsInterruptPending() const { return m_isInterruptPending; }
 
     // Will be used by the bus to un-pause after a speed switch
     void ForceUnpause()
@@ -123,12 +181,167 @@ public:
         m_isStopped = false;
     }
 
+    // Will be used by the bus to keep the decode cache up to date.
+    // Memory map change means that the ROM or WRAM bank switched.
+    // RAM writes are indexed in the decode cache RAM code space (see decodeCache.h)
+    void OnMemoryMapChanged()
+    {
+        m_decodeCache.OnMemoryMapChanged();
+        m_loop.address = NO_LOOP;
+    }
+    void OnRAMWrite(uint16_t ramIndex) { m_decodeCache.OnRAMWrite(ramIndex); }
+
+    // Changing the dispatch mode will flush the decode cache
+    void SetDispatchMode(DispatchMode mode);
+    // Drop all the decoded instructions, when the content of the ROM changes (cheats)
+    void FlushDecodeCache();
+    DispatchMode GetDispatchMode() const { return m_dispatchMode; }
+    size_t GetNbJitCompiledInstructions() const { return m_jit.GetNbCompiledInstructions(); }
+
+    // Busy-wait loops, polling an IO register (LY, STAT, IF, joypad, timer) with no side effect.
+    // Returns true if the next instruction starts one, with the address of the polled register.
+    bool IsInIdleLoop(uint16_t& polledAddress) const
+    {
+        polledAddress = m_loop.polledAddress;
+        return IsAtLoopStart() && m_loop.kind == LoopKind::Idle;
+    }
+    // Run as many iterations of the idle loop as possible in maxNbCycles, with the polled register
+    // not changing in between. Returns the number of cycles done, 0 if the loop would exit.
+    size_t SkipIdleLoop(size_t maxNbCycles);
+    // Number of cycles per loop address, for the first MAX_TRACKED_LOOPS loops.
+    // Fixed capacity, to never allocate while running.
+    static constexpr size_t MAX_TRACKED_LOOPS = 64;
+    using LoopCycles = Utils::MyStaticVector<std::pair<uint16_t, size_t>, MAX_TRACKED_LOOPS>;
+
+    // Number of cycles skipped, per loop address
+    const LoopCycles& GetIdleLoopSkippedCycles() const { return m_idleLoopSkippedCycles; }
+
+    // Memory copy/fill loops, like "ld a,(hl+) / ld (de),a / inc de / dec bc / ld a,b / or c / jr nz"
+    // or "ld (hl+),a / dec b / jr nz".
+    // Returns true if the next instruction starts one, with the first address it will write to.
+    bool IsInMemoryLoop(uint16_t& destinationAddress) const;
+    // Run as many iterations of the memory loop as possible in maxNbCycles, as a single bulk copy/fill.
+    // Registers and flags are the same as if the loop was executed. Returns the number of cycles done,
+    // 0 if nothing was done (memory that is not plain RAM/ROM, or not enough cycles).
+    size_t RunMemoryLoop(size_t maxNbCycles);
+    // Number of cycles run in bulk, per loop address
+    const LoopCycles& GetMemoryLoopCycles() const { return m_memoryLoopCycles; }
+
+    // With lazy flags, ALU operations only store their operands, and the flags are computed
+    // when they are read (conditional jumps, PUSH AF, DAA, serialization, debugger...)
+    void EnableLazyFlags(bool value);
+    bool IsLazyFlagsEnabled() const { return m_lazyFlagsEnabled; }
+
 private:
+    using OpCall = uint8_t (Z80Processor::*)(uint8_t);
+    // Handler of a decoded instruction, called with the opcode stored in the instruction
+    using InstructionHandler = uint8_t (*)(Z80Processor&, uint8_t);
+
+    // Instruction decoded once and for all, with its operands
+    struct DecodedInstruction
+    {
+        // For CB prefixed instructions, the handler is directly the one of the second opcode
+        InstructionHandler handler = nullptr;
+        uint16_t address = 0x0000;
+        // Literal byte or word following the opcode
+        uint16_t operand = 0x0000;
+        // Opcode passed to the handler (second opcode for CB prefixed instructions)
+        uint8_t opcode = 0x00;
+        // First byte of the instruction, used for stats
+        uint8_t firstByte = 0x00;
+        uint8_t length = 1;
+    };
+
+    using InstructionCache = DecodeCache<DecodedInstruction>;
+
+    // Maximum number of instructions in a decoded block
+    static constexpr uint16_t MAX_BLOCK_LENGTH = 64;
+
+    // Return the instruction at PC, using the decode cache when possible
+    const DecodedInstruction& GetInstructionAtPC();
+    const DecodedInstruction& DecodeBlockAtPC();
+    // Decode a single instruction at the given address. Returns false if it doesn't fit before endAddress.
+    bool DecodeInstruction(uint16_t addr, uint32_t endAddress, DecodedInstruction& instruction);
+
+    // Number of times a ROM block must be entered before being compiled
+    static constexpr uint32_t JIT_THRESHOLD = 16;
+    // Replace the handlers of the block instructions by native code, when possible
+    void CompileBlock(const InstructionCache::Block& block);
+
+    // Loops detected on backward branches. The last one is kept, so it
+    // is not analyzed again while it is running.
+    static constexpr uint32_t NO_LOOP = 0x10000;
+    static constexpr uint8_t MAX_LOOP_LENGTH = 7;
+
+    enum class LoopKind : uint8_t
+    {
+        None,
+        Idle, // Polling a register
+        Copy, // Copy bytes from source to destination pointer, both incremented
+        Fill  // Write A at the destination pointer, incremented
+    };
+
+    struct DetectedLoop
+    {
+        uint32_t address = NO_LOOP;
+        LoopKind kind = LoopKind::None;
+        // Idle loops
+        uint16_t polledAddress = 0x0000;
+        // Memory loops: pointers are indexed like the 16 bits registers of the opcodes (BC, DE, HL)
+        uint8_t sourceRegister = 0;
+        uint8_t destinationRegister = 0;
+        // 8 bits register index (B, C, D, E), or 16 bits register index (BC) for a word counter
+        uint8_t counterRegister = 0;
+        bool isWordCounter = false;
+        // Cycles of an iteration where the branch is taken
+        uint8_t nbCycles = 0;
+
+        uint8_t nbInstructions = 0;
+        std::array<DecodedInstruction, MAX_LOOP_LENGTH> instructions;
+        size_t* nbSkippedCycles = nullptr;
+    };
+
+    bool IsAtLoopStart() const { return m_cycles == 0 && !m_isPaused && !m_IMEScheduled && m_PC == m_loop.address; }
+
+    // Called after a backward branch, to find out if the loop starting at PC is idle or a memory loop
+    void DetectLoop(const DecodedInstruction& branch);
+    bool IsIdleLoop();
+    LoopKind GetMemoryLoopKind();
+    // Counter of the cycles of the loop at this address in the stats
+    size_t* GetLoopCycles(LoopCycles& loops, uint16_t address);
+    // Run the instructions of the loop once
+    uint8_t RunLoopIteration();
+
+    // Handlers specialized for a given opcode. Everything is inlined, so the opcode is a constant
+    // in the whole instruction.
+    template <uint8_t Opcode>
+    static uint8_t ExecuteSpecialized(Z80Processor& cpu, uint8_t opcode);
+    template <uint8_t Opcode>
+    static uint8_t ExecuteSpecializedCB(Z80Processor& cpu, uint8_t opcode);
+    template <bool IsCB, size_t... Opcodes>
+    static constexpr std::array<InstructionHandler, 256> MakeSpecializedHandlers(std::index_sequence<Opcodes...>);
+
+    // Generic handlers, going through the opcodes map
+    static uint8_t ExecuteGeneric(Z80Processor& cpu, uint8_t opcode);
+    static uint8_t ExecuteGenericCB(Z80Processor& cpu, uint8_t opcode);
+
     uint8_t ReadByte(uint16_t addr);
     void WriteByte(uint16_t addr, uint8_t data);
 
     // Utility functions
     void SetZeroFlag(uint16_t res) { m_AF.F.Z = (res == 0); }
+
+    // Lazy flags
+    void SetFlagsFromOperation(FlagsOperation operation, uint8_t left, uint8_t right, uint8_t carry, uint8_t result);
+    uint8_t GetCarryFlag() const;
+    Flags ComputeFlags() const;
+    // Write the flags in F. Must be called before reading or partially modifying F.
+    void MaterializeFlags();
+    static void MaterializeFlagsFromJit(Z80Processor& cpu);
+
+    // Shared by ADD/ADC and SUB/SBC/CP, with the carry to use
+    uint8_t AddToAccumulator(uint8_t opcode, uint8_t carry);
+    uint8_t SubtractFromAccumulator(uint8_t opcode, uint8_t carry);
     // Will get/write the value of the register with a given index in data
     // Return true if the data was read from/write to memory (index 6)
     // indicating that we have an additional cycle
@@ -142,10 +355,9 @@ private:
     void ReadWordFromRegisterIndex(uint8_t index, uint16_t& data);
     void WriteWordToRegisterIndex(uint8_t index, uint16_t data);
 
-    // Return the number of cycles required by this opcode
-    uint8_t DecodeOpcodeAndCall(uint8_t opcode);
-
-    // Fetch data from program
+    // Fetch data from program.
+    // Literal values are read when the instruction is decoded, this returns
+    // the operand of the instruction being executed.
     uint8_t FetchByte();
     uint16_t FetchWord();
 
@@ -238,8 +450,35 @@ private:
     uint16_t m_SP;
     uint16_t m_PC;
 
+    LazyFlags m_lazyFlags;
+    bool m_lazyFlagsEnabled = true;
+
     uint8_t m_cycles = 0;
 
+    // Operand of the instruction being executed
+    uint16_t m_operand = 0x0000;
+
+    // Decode cache, and the block we are currently executing
+    InstructionCache m_decodeCache;
+    const InstructionCache::Block* m_currentBlock = nullptr;
+    const DecodedInstruction* m_currentBlockInstructions = nullptr;
+    uint16_t m_currentBlockIndex = 0;
+    uint32_t m_currentBlockEpoch = 0;
+    // Used for instructions that are not cacheable
+    DecodedInstruction m_uncachedInstruction;
+
+    DispatchMode m_dispatchMode = DispatchMode::Specialized;
+
+    // Native code is only valid as long as the decode cache is not flushed
+    Z80JitCompiler m_jit;
+    uint32_t m_jitNbFlushes = 0;
+
+    DetectedLoop m_loop;
+    LoopCycles m_idleLoopSkippedCycles;
+    LoopCycles m_memoryLoopCycles;
+    // Cycles of the loops that didn't fit in the stats
+    size_t m_untrackedLoopCycles = 0;
+
     size_t m_nbInstructionsExecuted = 0;
     std::array<size_t, 256> m_opcodeCount;
 
@@ -248,6 +487,9 @@ private:
     bool m_IMEEnabled = false;
     bool m_isPaused = false;
 
+    // IF & IE != 0
+    bool m_isInterruptPending = false;
+
     // Special stop flag
     bool m_isStopped = false;
 
@@ -257,7 +499,6 @@ private:
     // Debug
     bool m_dumpEnabled = false;
 
-    using OpCall = uint8_t (Z80Processor::*)(uint8_t);
     using Z = Z80Processor;
 
     // clang-format off
@@ -281,8 +522,40 @@ private:
         &Z::LDH,  &Z::POP,  &Z::LD,   &Z::XXX,  &Z::XXX,  &Z::PUSH, &Z::AND,  &Z::RST,  &Z::ADD,  &Z::JP,   &Z::LD,   &Z::XXX,  &Z::XXX,  &Z::XXX,  &Z::XOR,  &Z::RST, 
         &Z::LDH,  &Z::POP,  &Z::LD,   &Z::DI,   &Z::XXX,  &Z::PUSH, &Z::OR,   &Z::RST,  &Z::LDSP, &Z::LD,   &Z::LD,   &Z::EI,   &Z::XXX,  &Z::XXX,  &Z::CP,   &Z::RST, 
     };
+
+    // Number of bytes of each instruction (opcode included)
+    static constexpr std::array<uint8_t, 256> m_opcodesLength =
+    {
+        1, 3, 1, 1, 1, 1, 2, 1, 3, 1, 1, 1, 1, 1, 2, 1,
+        2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
+        2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
+        2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 3, 3, 3, 1, 2, 1, 1, 1, 3, 2, 3, 3, 2, 1,
+        1, 1, 3, 1, 3, 1, 2, 1, 1, 1, 3, 1, 3, 1, 2, 1,
+        2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1,
+        2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1,
+    };
     // clang-format on
 
+    // Specialized handlers, indexed by opcode (and by second opcode for CB prefixed instructions)
+    static const std::array<InstructionHandler, 256> m_specializedHandlers;
+    static const std::array<InstructionHandler, 256> m_specializedCBHandlers;
+
+    // Return the handler for a CB prefixed opcode
+    static constexpr OpCall GetCBOpCall(uint8_t opcode);
+
+    // Return true if this opcode always changes the flow of the program.
+    // Decoded blocks stop after such instructions.
+    static constexpr bool IsBlockTerminator(uint8_t opcode);
+
     constexpr const char* GetDebugStringForOp(uint8_t opcode);
 };
 } // namespace GBEmulator
\ No newline at end of file
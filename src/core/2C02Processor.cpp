@@ -49,6 +49,13 @@ inline uint8_t GetColorIndexFromGBPalette(const GBPaletteData& palette, uint8_t
 {
     return (palette.flags >> (index << 1)) & 0x03;
 }
+
+inline uint32_t ToOutputColor(const GBEmulator::RGB555& color, GBEmulator::PixelFormat format)
+{
+    uint8_t r, g, b;
+    GBEmulator::Utils::RGB555ToRGB888(color, r, g, b);
+    return GBEmulator::ConvertRGB888(r, g, b, format);
+}
 } // namespace
 
 inline void GBCPaletteData::Reset()
@@ -66,24 +73,21 @@ inline void GBCPaletteData::DeserializeFrom(Utils::IReadVisitor& visitor)
     std::for_each(colors.begin(), colors.end(), [&visitor](auto& item) { visitor.ReadValue(item.data); });
 }
 
-Processor2C02::Processor2C02()
+Processor2C02::Processor2C02(PixelFormat pixelFormat)
+    : m_pixelFormat(pixelFormat)
+    , m_frameBuffers(GB_NB_PIXELS * GetBytesPerPixel(pixelFormat))
 {
-    m_screen.resize(GB_NB_PIXELS * 3);
-    m_selectedOAM.reserve(10); // Max of 10 sprites selected on a single line
-
-    // 16kB video ram
-    // Will be limited to 8kB in GB mode
-    m_VRAM.resize(0x4000);
 }
 
 inline uint8_t Processor2C02::ReadVRAM(uint16_t addr, uint8_t bankNumber)
 {
-    return m_VRAM[bankNumber * 0x2000 + (addr & 0x1FFF)];
+    return (*m_VRAM)[bankNumber * 0x2000 + (addr & 0x1FFF)];
 }
 
 inline void Processor2C02::WriteVRAM(uint16_t addr, uint8_t bankNumber, uint8_t data)
 {
-    m_VRAM[bankNumber * 0x2000 + (addr & 0x1FFF)] = data;
+    (*m_VRAM)[bankNumber * 0x2000 + (addr & 0x1FFF)] = data;
+    m_tileCache.OnVRAMWrite(addr, bankNumber);
 }
 
 uint8_t Processor2C02::ReadByte(uint16_t addr, bool /*readOnly*/)
@@ -91,7 +95,7 @@ uint8_t Processor2C02::ReadByte(uint16_t addr, bool /*readOnly*/)
     uint8_t data = 0;
     if (addr >= 0x8000 && addr < 0xA000)
     {
-        data = ReadVRAM(addr, m_currentVRAMBank);
+        data = ReadVRAM(addr, m_registers->currentVRAMBank);
     }
     else if (addr >= 0xFE00 && addr <= 0xFE9F)
     {
@@ -99,7 +103,7 @@ uint8_t Processor2C02::ReadByte(uint16_t addr, bool /*readOnly*/)
         // Index is selected using the 6 msb of the address lower nibble.
         // It will be between 0 and 39 (40 entry in total)
         uint8_t index = (addr & 0x00FF) >> 2;
-        OAMEntry& entry = m_OAM[index];
+        OAMEntry& entry = (*m_OAM)[index];
 
         // Then for each entry, there are 4 bytes, determined by the 2 lsb of the address.
         switch (addr & 0x0003)
@@ -119,73 +123,6 @@ uint8_t Processor2C02::ReadByte(uint16_t addr, bool /*readOnly*/)
             break;
         }
     }
-    else if (addr == 0xFF40)
-    {
-        data = m_lcdRegister.flags;
-    }
-    else if (addr == 0xFF41)
-    {
-        data = m_lcdStatus.flags;
-    }
-    else if (addr == 0xFF42)
-    {
-        data = m_scrollY;
-    }
-    else if (addr == 0xFF43)
-    {
-        data = m_scrollX;
-    }
-    else if (addr == 0xFF44)
-    {
-        data = m_lY;
-    }
-    else if (addr == 0xFF45)
-    {
-        data = m_lYC;
-    }
-    else if (addr == 0xFF47)
-    {
-        data = m_gbBGPalette.flags;
-    }
-    else if (addr == 0xFF48)
-    {
-        data = m_gbOBJ0Palette.flags;
-    }
-    else if (addr == 0xFF49)
-    {
-        data = m_gbOBJ1Palette.flags;
-    }
-    else if (addr == 0xFF4A)
-    {
-        data = m_wY;
-    }
-    else if (addr == 0xFF4B)
-    {
-        data = m_wX;
-    }
-    else if (addr == 0xFF68)
-    {
-        // Write only to gbc GB palette access
-    }
-    else if (addr == 0xFF69)
-    {
-        data = ReadGBCPaletteData(m_gbcBGPalettes, m_gbcBGPaletteAccess);
-    }
-    else if (addr == 0xFF6A)
-    {
-        // Write only to gbc OBJ palette access
-    }
-    else if (addr == 0xFF6B)
-    {
-        data = ReadGBCPaletteData(m_gbcOBJPalettes, m_gbcOBJPaletteAccess);
-    }
-    else if (addr == 0xFF4F)
-    {
-        // VRAM bank select (GBC only)
-        // All bits are set to 1, except bit 0, which correspond to the current
-        // bank number
-        data = (0xFE | m_currentVRAMBank);
-    }
     return data;
 }
 
@@ -193,118 +130,205 @@ void Processor2C02::WriteByte(uint16_t addr, uint8_t data)
 {
     if (addr >= 0x8000 && addr < 0xA000)
     {
-        WriteVRAM(addr, m_currentVRAMBank, data);
+        WriteVRAM(addr, m_registers->currentVRAMBank, data);
     }
     else if (addr >= 0xFE00 && addr <= 0xFE9F)
     {
-        // OAM
-        // Index is selected using the 6 msb of the address lower nibble.
-        // It will be between 0 and 39 (40 entry in total)
-        uint8_t index = (addr & 0x00FF) >> 2;
-        OAMEntry& entry = m_OAM[index];
-
-        // Then for each entry, there are 4 bytes, determined by the 2 lsb of the address.
-        switch (addr & 0x0003)
-        {
-        case 0:
-            entry.yPosition = data;
-            break;
-        case 1:
-            entry.xPosition = data;
-            break;
-        case 2:
-            entry.tileIndex = data;
-            break;
-        case 3:
-        default:
-            entry.attributes.flags = data;
-            break;
-        }
-    }
-    else if (addr == 0xFF40)
-    {
-        m_lcdRegister.flags = data;
-        if (m_lcdRegister.enable == 0)
-            m_isDisabled = true;
-    }
-    else if (addr == 0xFF41)
-    {
-        m_lcdStatus.flags = data;
+        WriteOAM(addr & 0x00FF, data);
     }
-    else if (addr == 0xFF42)
-    {
-        m_scrollY = data;
-    }
-    else if (addr == 0xFF43)
-    {
-        m_scrollX = data;
-    }
-    else if (addr == 0xFF44)
-    {
-        // Read only
-    }
-    else if (addr == 0xFF45)
-    {
-        m_lYC = data;
-    }
-    else if (addr == 0xFF47)
-    {
-        m_gbBGPalette.flags = data;
-    }
-    else if (addr == 0xFF48)
-    {
-        m_gbOBJ0Palette.flags = data;
-    }
-    else if (addr == 0xFF49)
-    {
-        m_gbOBJ1Palette.flags = data;
-    }
-    else if (addr == 0xFF4A)
-    {
-        m_wY = data;
-    }
-    else if (addr == 0xFF4B)
-    {
-        m_wX = data;
-    }
-    else if (addr == 0xFF68)
-    {
-        m_gbcBGPaletteAccess.address = data & 0x3F;
-        m_gbcBGPaletteAccess.shouldIncr = (data & 0x80) > 0;
-    }
-    else if (addr == 0xFF69)
-    {
-        WriteGBCPaletteData(m_gbcBGPalettes, m_gbcBGPaletteAccess, data);
-    }
-    else if (addr == 0xFF6A)
-    {
-        m_gbcOBJPaletteAccess.address = data & 0x3F;
-        m_gbcOBJPaletteAccess.shouldIncr = (data & 0x80) > 0;
-    }
-    else if (addr == 0xFF6B)
+}
+
+void Processor2C02::WriteOAM(uint8_t offset, uint8_t data)
+{
+    // Index is selected using the 6 msb of the address lower nibble.
+    // It will be between 0 and 39 (40 entry in total)
+    uint8_t index = offset >> 2;
+    OAMEntry& entry = (*m_OAM)[index];
+
+    // Then for each entry, there are 4 bytes, determined by the 2 lsb of the address.
+    switch (offset & 0x03)
     {
-        WriteGBCPaletteData(m_gbcOBJPalettes, m_gbcOBJPaletteAccess, data);
+    case 0:
+        entry.yPosition = data;
+        break;
+    case 1:
+        entry.xPosition = data;
+        break;
+    case 2:
+        entry.tileIndex = data;
+        break;
+    case 3:
+    default:
+        entry.attributes.flags = data;
+        break;
     }
-    else if (addr == 0xFF4F)
+}
+
+void Processor2C02::InstallIORegisters(IORegisters& registers, bool isGBC)
+{
+    registers.Install(
+        0xFF40, this,
+        [](void* ppu, uint16_t) { return static_cast<Processor2C02*>(ppu)->m_registers->lcdRegister.flags; },
+        [](void* context, uint16_t, uint8_t data)
+        {
+            Processor2C02* ppu = static_cast<Processor2C02*>(context);
+            ppu->ComposePendingPixels();
+            ppu->m_registers->lcdRegister.flags = data;
+            if (ppu->m_registers->lcdRegister.enable == 0)
+                ppu->m_isDisabled = true;
+        });
+
+    registers.Install(
+        0xFF41, this,
+        [](void* ppu, uint16_t) { return static_cast<Processor2C02*>(ppu)->m_registers->lcdStatus.flags; },
+        [](void* ppu, uint16_t, uint8_t data)
+        { static_cast<Processor2C02*>(ppu)->m_registers->lcdStatus.flags = data; });
+
+    registers.Install(
+        0xFF42, this, [](void* ppu, uint16_t) { return static_cast<Processor2C02*>(ppu)->m_registers->scrollY; },
+        [](void* ppu, uint16_t, uint8_t data) { static_cast<Processor2C02*>(ppu)->m_registers->scrollY = data; });
+
+    registers.Install(
+        0xFF43, this, [](void* ppu, uint16_t) { return static_cast<Processor2C02*>(ppu)->m_registers->scrollX; },
+        [](void* ppu, uint16_t, uint8_t data) { static_cast<Processor2C02*>(ppu)->m_registers->scrollX = data; });
+
+    // Read only
+    registers.Install(
+        0xFF44, this, [](void* ppu, uint16_t) { return static_cast<Processor2C02*>(ppu)->m_registers->lY; }, nullptr);
+
+    registers.Install(
+        0xFF45, this, [](void* ppu, uint16_t) { return static_cast<Processor2C02*>(ppu)->m_registers->lYC; },
+        [](void* ppu, uint16_t, uint8_t data) { static_cast<Processor2C02*>(ppu)->m_registers->lYC = data; });
+
+    registers.Install(
+        0xFF47, this,
+        [](void* ppu, uint16_t) { return static_cast<Processor2C02*>(ppu)->m_registers->gbBGPalette.flags; },
+        [](void* context, uint16_t, uint8_t data)
+        {
+            Processor2C02* ppu = static_cast<Processor2C02*>(context);
+            ppu->ComposePendingPixels();
+            ppu->m_registers->gbBGPalette.flags = data;
+            ppu->UpdateOutputPalette(0, ppu->m_registers->gbBGPalette);
+        });
+
+    registers.Install(
+        0xFF48, this,
+        [](void* ppu, uint16_t) { return static_cast<Processor2C02*>(ppu)->m_registers->gbOBJ0Palette.flags; },
+        [](void* context, uint16_t, uint8_t data)
+        {
+            Processor2C02* ppu = static_cast<Processor2C02*>(context);
+            ppu->ComposePendingPixels();
+            ppu->m_registers->gbOBJ0Palette.flags = data;
+            ppu->UpdateOutputPalette(COMPOSITOR_OBJ_OFFSET, ppu->m_registers->gbOBJ0Palette);
+        });
+
+    registers.Install(
+        0xFF49, this,
+        [](void* ppu, uint16_t) { return static_cast<Processor2C02*>(ppu)->m_registers->gbOBJ1Palette.flags; },
+        [](void* context, uint16_t, uint8_t data)
+        {
+            Processor2C02* ppu = static_cast<Processor2C02*>(context);
+            ppu->ComposePendingPixels();
+            ppu->m_registers->gbOBJ1Palette.flags = data;
+            ppu->UpdateOutputPalette(COMPOSITOR_OBJ_OFFSET + 4, ppu->m_registers->gbOBJ1Palette);
+        });
+
+    registers.Install(
+        0xFF4A, this, [](void* ppu, uint16_t) { return static_cast<Processor2C02*>(ppu)->m_registers->wY; },
+        [](void* ppu, uint16_t, uint8_t data) { static_cast<Processor2C02*>(ppu)->m_registers->wY = data; });
+
+    registers.Install(
+        0xFF4B, this, [](void* ppu, uint16_t) { return static_cast<Processor2C02*>(ppu)->m_registers->wX; },
+        [](void* ppu, uint16_t, uint8_t data) { static_cast<Processor2C02*>(ppu)->m_registers->wX = data; });
+
+    if (!isGBC)
     {
-        // VRAM bank select (GBC only)
-        m_currentVRAMBank = (data & 0x01);
+        for (uint16_t addr : {0xFF4F, 0xFF68, 0xFF69, 0xFF6A, 0xFF6B})
+            registers.Remove(addr);
+        return;
     }
+
+    // VRAM bank select
+    // All bits are set to 1, except bit 0, which correspond to the current bank number
+    registers.Install(
+        0xFF4F, this,
+        [](void* ppu, uint16_t) -> uint8_t
+        { return 0xFE | static_cast<Processor2C02*>(ppu)->m_registers->currentVRAMBank; },
+        [](void* context, uint16_t, uint8_t data)
+        {
+            Processor2C02* ppu = static_cast<Processor2C02*>(context);
+            ppu->m_registers->currentVRAMBank = (data & 0x01);
+            ppu->m_bus->UpdateVRAMPages();
+        });
+
+    // BG palette, access register is write only
+    registers.Install(0xFF68, this, nullptr,
+                      [](void* context, uint16_t, uint8_t data)
+                      {
+                          Processor2C02* ppu = static_cast<Processor2C02*>(context);
+                          ppu->m_gbcBGPaletteAccess.address = data & 0x3F;
+                          ppu->m_gbcBGPaletteAccess.shouldIncr = (data & 0x80) > 0;
+                      });
+
+    registers.Install(
+        0xFF69, this,
+        [](void* context, uint16_t)
+        {
+            Processor2C02* ppu = static_cast<Processor2C02*>(context);
+            return ReadGBCPaletteData(ppu->m_gbcBGPalettes, ppu->m_gbcBGPaletteAccess);
+        },
+        [](void* context, uint16_t, uint8_t data)
+        {
+            Processor2C02* ppu = static_cast<Processor2C02*>(context);
+            ppu->ComposePendingPixels();
+            // Palette * 4 + color, before the address is incremented
+            const uint8_t index = ppu->m_gbcBGPaletteAccess.address >> 1;
+            WriteGBCPaletteData(ppu->m_gbcBGPalettes, ppu->m_gbcBGPaletteAccess, data);
+            ppu->m_outputPalette[index] =
+                ToOutputColor(ppu->m_gbcBGPalettes[index >> 2].colors[index & 0x03], ppu->m_pixelFormat);
+        });
+
+    // OBJ palette, access register is write only
+    registers.Install(0xFF6A, this, nullptr,
+                      [](void* context, uint16_t, uint8_t data)
+                      {
+                          Processor2C02* ppu = static_cast<Processor2C02*>(context);
+                          ppu->m_gbcOBJPaletteAccess.address = data & 0x3F;
+                          ppu->m_gbcOBJPaletteAccess.shouldIncr = (data & 0x80) > 0;
+                      });
+
+    registers.Install(
+        0xFF6B, this,
+        [](void* context, uint16_t)
+        {
+            Processor2C02* ppu = static_cast<Processor2C02*>(context);
+            return ReadGBCPaletteData(ppu->m_gbcOBJPalettes, ppu->m_gbcOBJPaletteAccess);
+        },
+        [](void* context, uint16_t, uint8_t data)
+        {
+            Processor2C02* ppu = static_cast<Processor2C02*>(context);
+            ppu->ComposePendingPixels();
+            // Palette * 4 + color, before the address is incremented
+            const uint8_t index = ppu->m_gbcOBJPaletteAccess.address >> 1;
+            WriteGBCPaletteData(ppu->m_gbcOBJPalettes, ppu->m_gbcOBJPaletteAccess, data);
+            ppu->m_outputPalette[COMPOSITOR_OBJ_OFFSET + index] =
+                ToOutputColor(ppu->m_gbcOBJPalettes[index >> 2].colors[index & 0x03], ppu->m_pixelFormat);
+        });
 }
 
 void Processor2C02::SerializeTo(Utils::IWriteVisitor& visitor) const
 {
-    visitor.WriteValue(m_lcdRegister.flags);
-    visitor.WriteValue(m_lcdStatus.flags);
-    visitor.WriteValue(m_scrollY);
-    visitor.WriteValue(m_scrollX);
-    visitor.WriteValue(m_lY);
-    visitor.WriteValue(m_lYC);
-    visitor.WriteValue(m_wY);
-    visitor.WriteValue(m_wX);
-    visitor.WriteValue(m_gbBGPalette);
-    visitor.WriteValue(m_gbOBJ0Palette);
-    visitor.WriteValue(m_gbOBJ1Palette);
+    visitor.WriteValue(m_registers->lcdRegister.flags);
+    visitor.WriteValue(m_registers->lcdStatus.flags);
+    visitor.WriteValue(m_registers->scrollY);
+    visitor.WriteValue(m_registers->scrollX);
+    visitor.WriteValue(m_registers->lY);
+    visitor.WriteValue(m_registers->lYC);
+    visitor.WriteValue(m_registers->wY);
+    visitor.WriteValue(m_registers->wX);
+    visitor.WriteValue(m_registers->gbBGPalette);
+    visitor.WriteValue(m_registers->gbOBJ0Palette);
+    visitor.WriteValue(m_registers->gbOBJ1Palette);
 
     std::for_each(m_gbcBGPalettes.begin(), m_gbcBGPalettes.end(),
                   [&visitor](auto& item) { item.SerializeTo(visitor); });
@@ -332,26 +356,26 @@ void Processor2C02::SerializeTo(Utils::IWriteVisitor& visitor) const
     visitor.WriteValue(m_isDisabled);
     visitor.WriteValue(m_currentNbPixelsToRender);
 
-    visitor.WriteContainer(m_OAM);
+    visitor.WriteContainer(*m_OAM);
     visitor.WriteContainer(m_selectedOAM);
 
-    visitor.WriteContainer(m_VRAM);
-    visitor.WriteValue(m_currentVRAMBank);
+    visitor.WriteContainer(*m_VRAM);
+    visitor.WriteValue(m_registers->currentVRAMBank);
 }
 
 void Processor2C02::DeserializeFrom(Utils::IReadVisitor& visitor)
 {
-    visitor.ReadValue(m_lcdRegister.flags);
-    visitor.ReadValue(m_lcdStatus.flags);
-    visitor.ReadValue(m_scrollY);
-    visitor.ReadValue(m_scrollX);
-    visitor.ReadValue(m_lY);
-    visitor.ReadValue(m_lYC);
-    visitor.ReadValue(m_wY);
-    visitor.ReadValue(m_wX);
-    visitor.ReadValue(m_gbBGPalette);
-    visitor.ReadValue(m_gbOBJ0Palette);
-    visitor.ReadValue(m_gbOBJ1Palette);
+    visitor.ReadValue(m_registers->lcdRegister.flags);
+    visitor.ReadValue(m_registers->lcdStatus.flags);
+    visitor.ReadValue(m_registers->scrollY);
+    visitor.ReadValue(m_registers->scrollX);
+    visitor.ReadValue(m_registers->lY);
+    visitor.ReadValue(m_registers->lYC);
+    visitor.ReadValue(m_registers->wY);
+    visitor.ReadValue(m_registers->wX);
+    visitor.ReadValue(m_registers->gbBGPalette);
+    visitor.ReadValue(m_registers->gbOBJ0Palette);
+    visitor.ReadValue(m_registers->gbOBJ1Palette);
 
     std::for_each(m_gbcBGPalettes.begin(), m_gbcBGPalettes.end(),
                   [&visitor](auto& item) { item.DeserializeFrom(visitor); });
@@ -369,6 +393,8 @@ void Processor2C02::DeserializeFrom(Utils::IReadVisitor& visitor)
     visitor.ReadValue(m_lineDots);
     visitor.ReadValue(m_scanlines);
     visitor.ReadValue(m_currentLinePixel);
+    // The screen isn't saved, neither are the pixels not composed yet
+    m_nbComposedPixels = m_currentLinePixel;
     visitor.ReadValue(m_initialBGXScroll);
     visitor.ReadValue(m_currentX);
 
@@ -379,28 +405,36 @@ void Processor2C02::DeserializeFrom(Utils::IReadVisitor& visitor)
     visitor.ReadValue(m_isDisabled);
     visitor.ReadValue(m_currentNbPixelsToRender);
 
-    visitor.ReadContainer(m_OAM);
+    visitor.ReadContainer(*m_OAM);
     visitor.ReadContainer(m_selectedOAM);
 
-    visitor.ReadContainer(m_VRAM);
-    visitor.ReadValue(m_currentVRAMBank);
+    visitor.ReadContainer(*m_VRAM);
+    visitor.ReadValue(m_registers->currentVRAMBank);
+    OnMemoryRestored();
+}
+
+void Processor2C02::OnMemoryRestored()
+{
+    // The VRAM and the palette registers were overwritten
+    m_tileCache.InvalidateAll();
+    UpdateOutputPalettes();
 }
 
 void Processor2C02::Reset()
 {
-    m_lcdRegister.flags = 0x00;
-    m_lcdStatus.flags = 0x00;
-    m_scrollY = 0x00;
-    m_scrollX = 0x00;
-    m_lY = 0x00;
-    m_lYC = 0x00;
-    m_wX = 0x00;
-    m_wY = 0x00;
+    m_registers->lcdRegister.flags = 0x00;
+    m_registers->lcdStatus.flags = 0x00;
+    m_registers->scrollY = 0x00;
+    m_registers->scrollX = 0x00;
+    m_registers->lY = 0x00;
+    m_registers->lYC = 0x00;
+    m_registers->wX = 0x00;
+    m_registers->wY = 0x00;
     m_windowStalling = 0x00;
 
-    m_gbBGPalette.flags = 0x00;
-    m_gbOBJ0Palette.flags = 0x00;
-    m_gbOBJ1Palette.flags = 0x00;
+    m_registers->gbBGPalette.flags = 0x00;
+    m_registers->gbOBJ0Palette.flags = 0x00;
+    m_registers->gbOBJ1Palette.flags = 0x00;
 
     std::for_each(m_gbcBGPalettes.begin(), m_gbcBGPalettes.end(), [](auto& item) { item.Reset(); });
     std::for_each(m_gbcOBJPalettes.begin(), m_gbcOBJPalettes.end(), [](auto& item) { item.Reset(); });
@@ -414,8 +448,10 @@ void Processor2C02::Reset()
     m_lineDots = 0;
     m_scanlines = 0;
     m_currentLinePixel = 0;
+    m_nbComposedPixels = 0;
     m_currentX = 0;
-    std::memset(m_screen.data(), 0, m_screen.size());
+    FillScreen(0x00, 0x00, 0x00);
+    m_frameBuffers.CopyBackBufferToAll();
     m_isFrameComplete = false;
 
     m_currentStagePixelFetcher = 0;
@@ -423,17 +459,20 @@ void Processor2C02::Reset()
     m_initialBGXScroll = 0;
     m_currentNbPixelsToRender = 0;
 
-    m_OAM.fill(OAMEntry());
+    m_OAM->fill(OAMEntry());
     m_selectedOAM.clear();
 
-    std::fill(m_VRAM.begin(), m_VRAM.end(), 0x00);
+    m_VRAM->fill(0x00);
+    m_tileCache.InvalidateAll();
 
     // By default, we point on the first VRAM bank (won't move in GB mode)
     // Each VRAM bank is 8kB size
-    m_currentVRAMBank = 0;
+    m_registers->currentVRAMBank = 0;
 
     if (m_bus)
         m_isGBC = m_bus->GetMode() == Mode::GBC;
+
+    UpdateOutputPalettes();
 }
 
 inline void Processor2C02::DebugRenderNoise()
@@ -442,18 +481,16 @@ inline void Processor2C02::DebugRenderNoise()
     // rendering is working
 
     unsigned index = m_scanlines * GB_INTERNAL_WIDTH + m_currentLinePixel;
+    uint8_t r = 0, g = 0, b = 0;
     if ((float)rand() / (float)RAND_MAX > 0.5)
     {
-        m_screen[3 * index] = (uint8_t)((float)rand() / (float)RAND_MAX * 255.0f);
-        m_screen[3 * index + 1] = (uint8_t)((float)rand() / (float)RAND_MAX * 255.0f);
-        m_screen[3 * index + 2] = (uint8_t)((float)rand() / (float)RAND_MAX * 255.0f);
-    }
-    else
-    {
-        m_screen[3 * index] = 0;
-        m_screen[3 * index + 1] = 0;
-        m_screen[3 * index + 2] = 0;
+        r = (uint8_t)((float)rand() / (float)RAND_MAX * 255.0f);
+        g = (uint8_t)((float)rand() / (float)RAND_MAX * 255.0f);
+        b = (uint8_t)((float)rand() / (float)RAND_MAX * 255.0f);
     }
+
+    WritePixel(ConvertRGB888(r, g, b, m_pixelFormat), m_pixelFormat,
+               m_frameBuffers.GetBackBuffer() + index * GetBytesPerPixel(m_pixelFormat));
 }
 
 inline void Processor2C02::DebugRenderTileIds()
@@ -469,7 +506,7 @@ inline void Processor2C02::DebugRenderTileIds()
     unsigned columnIndex = m_currentLinePixel / 5;
     unsigned rowIndex = m_scanlines / 4;
 
-    uint16_t baseAddress = m_lcdRegister.bgTileMapArea == 0 ? 0x9800 : 0x9C00;
+    uint16_t baseAddress = m_registers->lcdRegister.bgTileMapArea == 0 ? 0x9800 : 0x9C00;
     uint16_t tileMapAddress = baseAddress + rowIndex * 32 + columnIndex;
 
     uint8_t data = ReadVRAM(tileMapAddress, 0);
@@ -502,9 +539,8 @@ inline void Processor2C02::DebugRenderTileIds()
         b = 255;
     }
 
-    m_screen[screenIndex * 3] = r;
-    m_screen[screenIndex * 3 + 1] = g;
-    m_screen[screenIndex * 3 + 2] = b;
+    WritePixel(ConvertRGB888(r, g, b, m_pixelFormat), m_pixelFormat,
+               m_frameBuffers.GetBackBuffer() + screenIndex * GetBytesPerPixel(m_pixelFormat));
 }
 
 inline void Processor2C02::RenderPixelFifos()
@@ -524,61 +560,114 @@ inline void Processor2C02::RenderPixelFifos()
         objPixel = m_objFifo.Pop();
     }
 
-    unsigned screenIndex = 3 * (m_scanlines * GB_INTERNAL_WIDTH + m_currentLinePixel);
+    // Colors are resolved when the pixels are composed, for the whole line or until the palettes change
+    m_linePixels.bgColor[m_currentLinePixel] = bgPixel.color;
+    m_linePixels.bgPalette[m_currentLinePixel] = bgPixel.palette;
+    m_linePixels.bgPriority[m_currentLinePixel] = bgPixel.bgPriority;
+    m_linePixels.objColor[m_currentLinePixel] = objPixel.color;
+    m_linePixels.objPalette[m_currentLinePixel] = objPixel.palette;
+    m_linePixels.objPriority[m_currentLinePixel] = objPixel.bgPriority;
 
-    const auto& gbPalette = GB_ORIGINAL_PALETTE;
+    m_currentLinePixel++;
+    if (m_currentLinePixel == GB_INTERNAL_WIDTH)
+        ComposePendingPixels();
+}
 
-    // We can render either the BG pixel, or the OBJ pixel
-    // BG: If the OBJ color is 0 (transparent) or BG over OBJ flag is on
-    const RGB555* pixelColor = nullptr;
-    bool bgPriority = false;
-    const bool noObjColor = objPixel.color == 0;
-    if (m_isGBC)
-    {
-        // On GBC, BGAndWindowPriority cleared mean that the bg/window will never have priority.
-        // Otherwise, it's driven by either the bgPixel/objPixel attribute.
-        bgPriority = m_lcdRegister.BGAndWindowPriority != 0 && (bgPixel.bgPriority == 1 || objPixel.bgPriority == 1);
+void Processor2C02::ComposePendingPixels()
+{
+    if (m_nbComposedPixels >= m_currentLinePixel)
+        return;
+
+    ComposeLine(m_linePixels, m_nbComposedPixels, m_currentLinePixel, m_outputPalette, m_isGBC,
+                m_registers->lcdRegister.BGAndWindowPriority != 0, m_pixelFormat,
+                m_frameBuffers.GetBackBuffer() + m_scanlines * GB_INTERNAL_WIDTH * GetBytesPerPixel(m_pixelFormat),
+                m_compositorImpl);
+    m_nbComposedPixels = m_currentLinePixel;
+    m_nbRenderedPixels[m_scanlines] = (uint8_t)m_currentLinePixel;
+}
+
+void Processor2C02::PublishFrame()
+{
+    // Pixels that were not rendered in this frame keep their previous value, like with a single screen buffer
+    // (LCD enabled in the middle of a frame).
+    const size_t bytesPerPixel = GetBytesPerPixel(m_pixelFormat);
+    const uint8_t* previous = m_frameBuffers.GetLastPublished().data();
+    uint8_t* screen = m_frameBuffers.GetBackBuffer();
+    for (size_t line = 0; line < GB_INTERNAL_HEIGHT; ++line)
+    {
+        const size_t nbRenderedPixels = m_nbRenderedPixels[line];
+        if (nbRenderedPixels < GB_INTERNAL_WIDTH)
+        {
+            const size_t offset = (line * GB_INTERNAL_WIDTH + nbRenderedPixels) * bytesPerPixel;
+            std::memcpy(screen + offset, previous + offset, (GB_INTERNAL_WIDTH - nbRenderedPixels) * bytesPerPixel);
+        }
     }
-    else
+
+    m_nbRenderedPixels.fill(0);
+    m_frameBuffers.Publish();
+}
+
+void Processor2C02::UpdateOutputPalette(size_t offset, GBPaletteData palette)
+{
+    // GBC palettes are used instead in GBC mode
+    if (m_isGBC)
+        return;
+
+    for (uint8_t color = 0; color < 4; ++color)
     {
-        // On GB, it is only driven by the objPixel attribute
-        bgPriority = objPixel.bgPriority == 1;
+        const uint8_t shade = GetColorIndexFromGBPalette(palette, color);
+        m_outputPalette[offset + color] =
+            m_pixelFormat == PixelFormat::Shade ? shade : ToOutputColor(GB_ORIGINAL_PALETTE[shade], m_pixelFormat);
     }
+}
 
-    if (noObjColor || (bgPriority && bgPixel.color != 0))
+void Processor2C02::UpdateOutputPalettes()
+{
+    m_outputPalette.fill(0);
+    if (m_isGBC)
     {
-        // Draw BG pixel
-        if (!m_isGBC)
-        {
-            pixelColor = &gbPalette[GetColorIndexFromGBPalette(m_gbBGPalette, bgPixel.color)];
-        }
-        else
+        for (size_t i = 0; i < 8; ++i)
         {
-            pixelColor = &(m_gbcBGPalettes[bgPixel.palette].colors[bgPixel.color]);
+            for (size_t color = 0; color < 4; ++color)
+            {
+                m_outputPalette[i * 4 + color] = ToOutputColor(m_gbcBGPalettes[i].colors[color], m_pixelFormat);
+                m_outputPalette[COMPOSITOR_OBJ_OFFSET + i * 4 + color] =
+                    ToOutputColor(m_gbcOBJPalettes[i].colors[color], m_pixelFormat);
+            }
         }
     }
     else
     {
-        // Draw OBJ pixel
-        if (!m_isGBC)
-        {
-            pixelColor = &gbPalette[GetColorIndexFromGBPalette(
-                objPixel.palette == 0 ? m_gbOBJ0Palette : m_gbOBJ1Palette, objPixel.color)];
-        }
-        else
-        {
-            pixelColor = &(m_gbcOBJPalettes[objPixel.palette].colors[objPixel.color]);
-        }
+        UpdateOutputPalette(0, m_registers->gbBGPalette);
+        UpdateOutputPalette(COMPOSITOR_OBJ_OFFSET, m_registers->gbOBJ0Palette);
+        UpdateOutputPalette(COMPOSITOR_OBJ_OFFSET + 4, m_registers->gbOBJ1Palette);
     }
+}
 
-    Utils::RGB555ToRGB888(*pixelColor, m_screen[screenIndex], m_screen[screenIndex + 1], m_screen[screenIndex + 2]);
-    m_currentLinePixel++;
+bool Processor2C02::SetCompositorImpl(CompositorImpl impl)
+{
+    if (!IsCompositorImplSupported(impl))
+        return false;
+
+    m_compositorImpl = impl;
+    return true;
+}
+
+void Processor2C02::FillScreen(uint8_t r, uint8_t g, uint8_t b)
+{
+    // The first pixel, copied in chunks twice as big each time
+    m_nbRenderedPixels.fill(GB_INTERNAL_WIDTH);
+    uint8_t* screen = m_frameBuffers.GetBackBuffer();
+    const size_t screenSize = GB_NB_PIXELS * GetBytesPerPixel(m_pixelFormat);
+    WritePixel(ConvertRGB888(r, g, b, m_pixelFormat), m_pixelFormat, screen);
+    for (size_t size = GetBytesPerPixel(m_pixelFormat); size < screenSize; size *= 2)
+        std::memcpy(screen + size, screen, std::min(size, screenSize - size));
 }
 
 inline void Processor2C02::RenderDisabledLCD()
 {
     // White screen
-    std::memset(m_screen.data(), 0xFF, m_screen.size());
+    FillScreen(0xFF, 0xFF, 0xFF);
 }
 
 void Processor2C02::SetInteruptFlag(InteruptSource is)
@@ -591,13 +680,13 @@ void Processor2C02::SetInteruptFlag(InteruptSource is)
     {
     case InteruptSource::VBlank:
         ifRegister.vBlank = 1;
-        if (m_lcdStatus.mode1VBlankIS)
+        if (m_registers->lcdStatus.mode1VBlankIS)
             ifRegister.lcdStat = 1;
         changed = true;
         break;
 
     case InteruptSource::HBlank:
-        if (m_lcdStatus.mode0HBlankIS)
+        if (m_registers->lcdStatus.mode0HBlankIS)
         {
             ifRegister.lcdStat = 1;
             changed = true;
@@ -605,7 +694,7 @@ void Processor2C02::SetInteruptFlag(InteruptSource is)
         break;
 
     case InteruptSource::OAM:
-        if (m_lcdStatus.mode2OAMIS)
+        if (m_registers->lcdStatus.mode2OAMIS)
         {
             ifRegister.lcdStat = 1;
             changed = true;
@@ -613,7 +702,7 @@ void Processor2C02::SetInteruptFlag(InteruptSource is)
         break;
 
     case InteruptSource::LYC:
-        if (m_lcdStatus.lYcEqualLYIS)
+        if (m_registers->lcdStatus.lYcEqualLYIS)
         {
             ifRegister.lcdStat = 1;
             changed = true;
@@ -663,12 +752,12 @@ void Processor2C02::OriginalPixelFetcher()
 
         // We need to take into account that wX range is [0, 166], therefore
         // values of wX between 0 and 7 means that the full screen will be covered by the window
-        uint8_t realWX = m_wX < 7 ? 0 : m_wX - 7;
+        uint8_t realWX = m_registers->wX < 7 ? 0 : m_registers->wX - 7;
 
-        if (m_lcdRegister.windowEnable)
+        if (m_registers->lcdRegister.windowEnable)
         {
             // Check Y
-            if (m_scanlines > m_wY)
+            if (m_scanlines > m_registers->wY)
             {
                 // Check X
                 if (m_currentX >= realWX)
@@ -693,8 +782,8 @@ void Processor2C02::OriginalPixelFetcher()
             // Compute the address of the BG tile using the lcd control register to
             // know where the tile map is in memory.
             uint16_t tileCoordinate = (Y / 8) * 32 + (X / 8);
-            uint8_t tileMapAreaRegister =
-                m_isWindowRendering ? m_lcdRegister.windowTileMapArea : m_lcdRegister.bgTileMapArea;
+            uint8_t tileMapAreaRegister = m_isWindowRendering ? m_registers->lcdRegister.windowTileMapArea
+                                                              : m_registers->lcdRegister.bgTileMapArea;
             uint16_t tileAddress = tileMapAreaRegister == 0 ? 0x9800 : 0x9C00;
             tileAddress += tileCoordinate;
 
@@ -707,9 +796,9 @@ void Processor2C02::OriginalPixelFetcher()
             // Finally, compute the address of the tile data to read from in the next stage
             // If tileAreaData is 0, the starting address is 0x9000 and the tileId is a signed integer
             // Otherwise, the starting address is 0x8000 and the tileId is an unsigned integer
-            m_BGWindowTileAddress = m_lcdRegister.BGAndWindowTileAreaData == 0 ? 0x9000 : 0x8000;
+            m_BGWindowTileAddress = m_registers->lcdRegister.BGAndWindowTileAreaData == 0 ? 0x9000 : 0x8000;
             int16_t realTileId = 0x0000;
-            if (m_lcdRegister.BGAndWindowTileAreaData == 0)
+            if (m_registers->lcdRegister.BGAndWindowTileAreaData == 0)
             {
                 int8_t temp = (int8_t)(tileId);
                 realTileId = temp;
@@ -728,8 +817,8 @@ void Processor2C02::OriginalPixelFetcher()
         // From there, we either try to render window or BG
         if (m_isWindowRendering)
         {
-            uint8_t Y = m_scanlines - m_wY;
-            // For X, we need to be a bit more careful, because m_wX range is [0, 166]
+            uint8_t Y = m_scanlines - m_registers->wY;
+            // For X, we need to be a bit more careful, because m_registers->wX range is [0, 166]
             // so we need to offset it.
             uint8_t X = m_currentX - realWX;
             fetchTileAddress(X, Y, 8);
@@ -740,8 +829,8 @@ void Processor2C02::OriginalPixelFetcher()
             // For horizontal scrolling, we only update the 5 msb bits of the scroll X register.
             // the 3 lsb one are fixed during the whole scanline.
             // If we exceed 256, it wraps around.
-            uint8_t currentBGY = m_scrollY + m_scanlines;
-            uint8_t scrollBGX = (m_scrollX & 0xF8) + m_initialBGXScroll;
+            uint8_t currentBGY = m_registers->scrollY + m_scanlines;
+            uint8_t scrollBGX = (m_registers->scrollX & 0xF8) + m_initialBGXScroll;
             uint8_t currentBGX = scrollBGX + m_currentX;
 
             fetchTileAddress(currentBGX, currentBGY, maxNbBGPixels);
@@ -802,7 +891,8 @@ void Processor2C02::SimplifiedPixelFetcher()
         // Compute the address of the BG tile using the lcd control register to
         // know where the tile map is in memory.
         uint16_t tileCoordinate = (Y / 8) * 32 + (X / 8);
-        uint8_t tileMapAreaRegister = isWindow ? m_lcdRegister.windowTileMapArea : m_lcdRegister.bgTileMapArea;
+        uint8_t tileMapAreaRegister =
+            isWindow ? m_registers->lcdRegister.windowTileMapArea : m_registers->lcdRegister.bgTileMapArea;
         uint16_t tileAddress = tileMapAreaRegister == 0 ? 0x9800 : 0x9C00;
         tileAddress += tileCoordinate;
 
@@ -816,9 +906,9 @@ void Processor2C02::SimplifiedPixelFetcher()
         // Finally, compute the address of the tile data to read from in the next stage
         // If tileAreaData is 0, the starting address is 0x9000 and the tileId is a signed integer
         // Otherwise, the starting address is 0x8000 and the tileId is an unsigned integer
-        uint16_t addr = m_lcdRegister.BGAndWindowTileAreaData == 0 ? 0x9000 : 0x8000;
+        uint16_t addr = m_registers->lcdRegister.BGAndWindowTileAreaData == 0 ? 0x9000 : 0x8000;
         int16_t realTileId = 0x0000;
-        if (m_lcdRegister.BGAndWindowTileAreaData == 0)
+        if (m_registers->lcdRegister.BGAndWindowTileAreaData == 0)
         {
             int8_t temp = (int8_t)(tileId);
             realTileId = temp;
@@ -847,36 +937,18 @@ void Processor2C02::SimplifiedPixelFetcher()
         // VRAM bank is always 0 in GB.
         const uint8_t VRAMBank = m_isGBC ? attributes.tileVRAMBank : 0;
 
-        uint8_t tileLsb = ReadVRAM(addr, VRAMBank);
-        uint8_t tileMsb = ReadVRAM(addr + 1, VRAMBank);
-
-        auto reverseByte = [](uint8_t b) -> uint8_t
-        {
-            b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
-            b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
-            b = (b & 0xAA) >> 1 | (b & 0x55) << 1;
-            return b;
-        };
-
-        // In case of xFilp, reverse the bits
-        if (attributes.xFlip)
-        {
-            tileLsb = reverseByte(tileLsb);
-            tileMsb = reverseByte(tileMsb);
-        }
+        // Decoded row, already flipped if needed
+        const uint8_t* row = m_tileCache.GetRow(&(*m_VRAM)[VRAMBank * 0x2000], addr, VRAMBank, attributes.xFlip);
 
+        // Only the last pixels of the row if the tile is cut
         uint8_t nbPixelsToRender = endIndex - startIndex;
-        tileLsb <<= (8 - nbPixelsToRender);
-        tileMsb <<= (8 - nbPixelsToRender);
+        const uint8_t firstPixel = 8 - nbPixelsToRender;
         for (auto i = 0; i < nbPixelsToRender; ++i)
         {
-            uint8_t color = ((tileMsb & 0x80) >> 6) | ((tileLsb & 0x80) >> 7);
+            uint8_t color = row[firstPixel + i];
             if (color != 0)
                 pixelArray[startIndex + i].color = color;
 
-            tileMsb <<= 1;
-            tileLsb <<= 1;
-
             if (!isSprite || color != 0)
             {
                 pixelArray[startIndex + i].bgPriority = attributes.bgAndWindowOverObj;
@@ -886,13 +958,13 @@ void Processor2C02::SimplifiedPixelFetcher()
         }
     };
 
-    bool BGWindowEnabled = !m_isGBC ? m_lcdRegister.BGAndWindowPriority > 0 : true;
+    bool BGWindowEnabled = !m_isGBC ? m_registers->lcdRegister.BGAndWindowPriority > 0 : true;
 
     Attributes BGAttributes{};
     Attributes WindowAttributes{};
 
     // First fetch all the pixel colors for the BG
-    uint8_t yBG = m_scanlines + m_scrollY;
+    uint8_t yBG = m_scanlines + m_registers->scrollY;
 
     // There can be at most 167 pixels fetched (fetch more even if we don't use them)
     std::array<PixelFIFO, 167> bgPixels;
@@ -900,7 +972,7 @@ void Processor2C02::SimplifiedPixelFetcher()
     {
         for (uint8_t x = 0; x < 160;)
         {
-            uint8_t realX = x + (m_scrollX & 0xF8) + m_initialBGXScroll;
+            uint8_t realX = x + (m_registers->scrollX & 0xF8) + m_initialBGXScroll;
             uint8_t startX = x;
 
             if (x == 0 && m_initialBGXScroll != 0)
@@ -919,12 +991,13 @@ void Processor2C02::SimplifiedPixelFetcher()
 
     // Do the same for the window, only if it is enabled
     std::array<PixelFIFO, 167> windowPixels;
-    bool shouldDrawWindow = m_lcdRegister.windowEnable && (m_scanlines >= m_wY) && BGWindowEnabled;
+    bool shouldDrawWindow =
+        m_registers->lcdRegister.windowEnable && (m_scanlines >= m_registers->wY) && BGWindowEnabled;
 
     if (shouldDrawWindow)
     {
         // Check also that we are in the right wX range. If not, we stall the window
-        if (m_wX > 166)
+        if (m_registers->wX > 166)
         {
             m_windowStalling++;
             shouldDrawWindow = false;
@@ -932,13 +1005,13 @@ void Processor2C02::SimplifiedPixelFetcher()
         else
         {
             uint8_t xWindow = 0;
-            uint8_t yWindow = m_scanlines - m_wY - m_windowStalling;
-            uint8_t nbWindowTiles = (uint8_t)std::ceil((166 - m_wX) / 8.f);
+            uint8_t yWindow = m_scanlines - m_registers->wY - m_windowStalling;
+            uint8_t nbWindowTiles = (uint8_t)std::ceil((166 - m_registers->wX) / 8.f);
             for (uint8_t i = 0; i < nbWindowTiles; ++i)
             {
                 uint16_t tileAddr = fetchTileAddress(xWindow, yWindow, true, WindowAttributes, m_isGBC);
 
-                uint8_t endX = (i == 0 && m_wX < 7) ? 7 - m_wX : xWindow + 8;
+                uint8_t endX = (i == 0 && m_registers->wX < 7) ? 7 - m_registers->wX : xWindow + 8;
 
                 pixelFetch(tileAddr, windowPixels, xWindow, endX, WindowAttributes, false);
                 xWindow = endX;
@@ -949,10 +1022,10 @@ void Processor2C02::SimplifiedPixelFetcher()
     // And merge it into the pixel FIFO
     for (uint8_t i = 0; i < 160; ++i)
     {
-        if (shouldDrawWindow && i + 7 >= m_wX)
+        if (shouldDrawWindow && i + 7 >= m_registers->wX)
         {
             // Window pixel
-            m_bgFifo.Push(windowPixels[i + 7 - m_wX]);
+            m_bgFifo.Push(windowPixels[i + 7 - m_registers->wX]);
         }
         else if (BGWindowEnabled)
         {
@@ -969,19 +1042,19 @@ void Processor2C02::SimplifiedPixelFetcher()
     // Then redo the same thing for the sprites
     // Do it in reverse, for the highest priority sprite to override the lowest one
     std::array<PixelFIFO, 167> spritePixels;
-    bool shouldDrawObj = m_lcdRegister.objEnable && !m_selectedOAM.empty();
+    bool shouldDrawObj = m_registers->lcdRegister.objEnable && !m_selectedOAM.empty();
     if (shouldDrawObj)
     {
         for (auto it = m_selectedOAM.rbegin(); it != m_selectedOAM.rend(); ++it)
         {
-            const OAMEntry& entry = m_OAM[*it];
+            const OAMEntry& entry = (*m_OAM)[*it];
 
             // A position of 0 or more than 168 is hidden
             if (entry.xPosition == 0 || entry.xPosition >= 168)
                 continue;
 
             uint16_t tileAddress = 0x8000;
-            uint8_t objSize = m_lcdRegister.objSize == 0 ? 8 : 16;
+            uint8_t objSize = m_registers->lcdRegister.objSize == 0 ? 8 : 16;
             uint8_t yOffset = m_scanlines + 16 - entry.yPosition;
             if (entry.attributes.yFlip)
             {
@@ -989,7 +1062,7 @@ void Processor2C02::SimplifiedPixelFetcher()
                 yOffset = objSize - yOffset - 1;
             }
 
-            if (m_lcdRegister.objSize == 0)
+            if (m_registers->lcdRegister.objSize == 0)
             {
                 // 8x8 sprites
                 tileAddress += (entry.tileIndex * 16) + yOffset * 2;
@@ -1025,11 +1098,11 @@ void Processor2C02::SimplifiedPixelFetcher()
 void Processor2C02::Clock()
 {
     // Only set the interrupt once, the exact cycle it becomes true.
-    if (m_lY == m_lYC && m_lcdStatus.lYcEqualLY == 0)
+    if (m_registers->lY == m_registers->lYC && m_registers->lcdStatus.lYcEqualLY == 0)
         SetInteruptFlag(InteruptSource::LYC);
 
     // Update the status
-    m_lcdStatus.lYcEqualLY = m_lY == m_lYC;
+    m_registers->lcdStatus.lYcEqualLY = m_registers->lY == m_registers->lYC;
 
     m_isFrameComplete = false;
     if (m_scanlines <= 143)
@@ -1037,7 +1110,7 @@ void Processor2C02::Clock()
         if (m_lineDots == 0)
         {
             // The 3 lsb of the scrollX register are fixed for the scanline
-            m_initialBGXScroll = m_scrollX & 0x07;
+            m_initialBGXScroll = m_registers->scrollX & 0x07;
         }
 
         // Drawing mode
@@ -1046,13 +1119,13 @@ void Processor2C02::Clock()
         {
             // Only do stuff on even numbers and if the OBJ are enabled and if we didn't reach the limit of 10 selected
             // sprites
-            if (m_lineDots % 2 == 0 && m_lcdRegister.objEnable == 1 && m_selectedOAM.size() < 10)
+            if (m_lineDots % 2 == 0 && m_registers->lcdRegister.objEnable == 1 && !m_selectedOAM.full())
             {
                 // Get the current entry
                 uint8_t index = m_lineDots >> 1;
-                const OAMEntry& entry = m_OAM[index];
+                const OAMEntry& entry = (*m_OAM)[index];
 
-                uint8_t objSize = m_lcdRegister.objSize == 0 ? 8 : 16;
+                uint8_t objSize = m_registers->lcdRegister.objSize == 0 ? 8 : 16;
 
                 // A sprite is selected if the current scanline (+ 16) is between the y position and the y position +
                 // its size (8 or 16)
@@ -1068,13 +1141,14 @@ void Processor2C02::Clock()
             if (m_lineDots == 79 && !m_selectedOAM.empty() && !m_isGBC)
             {
                 std::sort(m_selectedOAM.begin(), m_selectedOAM.end(),
-                          [this](uint8_t a, uint8_t b) -> bool { return m_OAM[a].xPosition < m_OAM[b].xPosition; });
+                          [this](uint8_t a, uint8_t b) -> bool
+                          { return (*m_OAM)[a].xPosition < (*m_OAM)[b].xPosition; });
             }
         }
         else
         {
             // We can be in Drawing pixels (Mode 3) or Horizontal Blank (Mode 0)
-            if (m_lcdStatus.mode == 3)
+            if (m_registers->lcdStatus.mode == 3)
             {
                 // Drawing pixels
                 constexpr bool useSimplified = true;
@@ -1093,7 +1167,7 @@ void Processor2C02::Clock()
                 // if (m_lineDots == 368) // Max
                 if (m_lineDots == 251)
                 {
-                    m_lcdStatus.mode = 0;
+                    m_registers->lcdStatus.mode = 0;
                     SetInteruptFlag(InteruptSource::HBlank);
                 }
             }
@@ -1127,10 +1201,14 @@ void Processor2C02::Clock()
         case RenderMode::DEBUG_RANDOM_NOISE:
             DebugRenderNoise();
             m_currentLinePixel++;
+            m_nbRenderedPixels[m_scanlines] = (uint8_t)m_currentLinePixel;
+            m_nbComposedPixels = m_currentLinePixel;
             break;
         case RenderMode::DEBUG_TILE_ID:
             DebugRenderTileIds();
             m_currentLinePixel++;
+            m_nbRenderedPixels[m_scanlines] = (uint8_t)m_currentLinePixel;
+            m_nbComposedPixels = m_currentLinePixel;
             break;
         case RenderMode::NORMAL:
             // m_currentLinePixel will be incremented if a pixel was emitted from the FIFO
@@ -1140,18 +1218,26 @@ void Processor2C02::Clock()
         case RenderMode::DISABLED:
             RenderDisabledLCD();
             m_currentLinePixel++;
+            m_nbComposedPixels = m_currentLinePixel;
             break;
         }
+
+        // Last pixel of the frame
+        if (m_currentLinePixel == 160 && m_scanlines == 143)
+            PublishFrame();
     }
 
     ++m_lineDots;
     if (m_lineDots == 456)
     {
+        // The line may have been cut short
+        ComposePendingPixels();
+
         ++m_scanlines;
         if (m_scanlines == 144)
         {
             // Vertical blank mode (mode 1)
-            m_lcdStatus.mode = 1;
+            m_registers->lcdStatus.mode = 1;
 
             // Set the IF register bit for VBlank to 1
             SetInteruptFlag(InteruptSource::VBlank);
@@ -1163,13 +1249,13 @@ void Processor2C02::Clock()
             m_windowStalling = 0;
 
             // Re-enable the LCD at a start of a new frame, if it is enabled.
-            m_isDisabled = m_lcdRegister.enable == 0;
+            m_isDisabled = m_registers->lcdRegister.enable == 0;
         }
 
         if (m_scanlines >= 0 && m_scanlines < 144)
         {
             // OAM scan
-            m_lcdStatus.mode = 2;
+            m_registers->lcdStatus.mode = 2;
             SetInteruptFlag(InteruptSource::OAM);
             m_selectedOAM.clear();
         }
@@ -1177,18 +1263,71 @@ void Processor2C02::Clock()
         m_lineDots = 0;
         m_currentX = 0;
 
-        m_lY = (uint8_t)m_scanlines;
+        m_registers->lY = (uint8_t)m_scanlines;
         m_currentStagePixelFetcher = 0;
     }
     else if (m_lineDots == 80 && m_scanlines < 144)
     {
         // OAM scan is done, go to mode 3.
         // Also clear the FIFOs
-        m_lcdStatus.mode = 3;
+        m_registers->lcdStatus.mode = 3;
         m_bgFifo.Clear();
         m_objFifo.Clear();
         m_currentLinePixel = 0;
+        m_nbComposedPixels = 0;
+    }
+
+    m_isFrameComplete = m_currentLinePixel == 160 && m_scanlines == 143;
+}
+unsigned Processor2C02::GetNbIdleDots() const
+{
+    // LYC interrupt will be raised on the next dot
+    if (m_registers->lY == m_registers->lYC && m_registers->lcdStatus.lYcEqualLY == 0)
+        return 0;
+
+    if (m_scanlines <= 143)
+    {
+        // Only HBlank is idle, once HBlank interrupt has been raised (on dot 251)
+        if (m_registers->lcdStatus.mode != 0 || m_lineDots <= 251)
+            return 0;
+
+        // And only if there is no pixel left to render
+        const bool isRendering =
+            m_currentLinePixel < 160 && (m_isDisabled || !m_bgFifo.Empty() || !m_objFifo.Empty());
+        if (isRendering)
+            return 0;
     }
 
+    // The last dot of the line is not idle, the next line starts there.
+    return 455 - m_lineDots;
+}
+
+void Processor2C02::SkipIdleDots(unsigned nbDots)
+{
+    if (nbDots == 0)
+        return;
+
+    m_registers->lcdStatus.lYcEqualLY = m_registers->lY == m_registers->lYC;
+    m_lineDots += nbDots;
     m_isFrameComplete = m_currentLinePixel == 160 && m_scanlines == 143;
-}
\ No newline at end of file
+}
+
+unsigned Processor2C02::GetNbDotsBeforeNextEvent() const
+{
+    // LY=LYC flag (and its interrupt) will be updated on the next dot
+    if (m_registers->lcdStatus.lYcEqualLY != (m_registers->lY == m_registers->lYC))
+        return 0;
+
+    if (m_scanlines <= 143)
+    {
+        // Mode 3 starts on dot 79, and HBlank on dot 251
+        if (m_lineDots < 80)
+            return 79 - m_lineDots;
+
+        if (m_registers->lcdStatus.mode == 3 && m_lineDots <= 251)
+            return 251 - m_lineDots;
+    }
+
+    // Next line starts on dot 455
+    return 455 - m_lineDots;
+}
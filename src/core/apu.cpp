@@ -130,116 +130,131 @@ void APU::Clock()
     ++m_nbCycles;
 }
 
-void APU::WriteByte(uint16_t addr, uint8_t data)
+void APU::InstallIORegisters(IORegisters& registers)
 {
-    if (!m_allSoundsOn && addr != 0xFF26)
+    // Can't write any register (except status) if sound is disabled
+    for (uint16_t addr = 0xFF10; addr <= 0xFF14; ++addr)
     {
-        // Can't access any register (except status) if sound is disabled
-        return;
+        registers.Install(
+            addr, this,
+            [](void* apu, uint16_t addr) { return static_cast<APU*>(apu)->m_channel1.ReadByte(addr - 0xFF10); },
+            [](void* context, uint16_t addr, uint8_t data)
+            {
+                APU* apu = static_cast<APU*>(context);
+                if (apu->m_allSoundsOn)
+                    apu->m_channel1.WriteByte(addr - 0xFF10, data, apu);
+            });
     }
 
-    if (addr >= 0xFF10 && addr <= 0xFF14)
-    {
-        m_channel1.WriteByte(addr - 0xFF10, data, this);
-    }
-    else if (addr >= 0xFF15 && addr <= 0xFF19)
-    {
-        m_channel2.WriteByte(addr - 0xFF15, data, this);
-    }
-    else if ((addr >= 0xFF1A && addr <= 0xFF1E) || (addr >= 0xFF30 && addr <= 0xFF3F))
+    for (uint16_t addr = 0xFF15; addr <= 0xFF19; ++addr)
     {
-        m_channel3.WriteByte(addr, data);
-    }
-    else if (addr >= 0xFF1F && addr <= 0xFF23)
-    {
-        m_channel4.WriteByte(addr, data);
+        registers.Install(
+            addr, this,
+            [](void* apu, uint16_t addr) { return static_cast<APU*>(apu)->m_channel2.ReadByte(addr - 0xFF15); },
+            [](void* context, uint16_t addr, uint8_t data)
+            {
+                APU* apu = static_cast<APU*>(context);
+                if (apu->m_allSoundsOn)
+                    apu->m_channel2.WriteByte(addr - 0xFF15, data, apu);
+            });
     }
-    else if (addr == 0xFF24)
+
+    auto readChannel3 = [](void* apu, uint16_t addr) { return static_cast<APU*>(apu)->m_channel3.ReadByte(addr); };
+    auto writeChannel3 = [](void* context, uint16_t addr, uint8_t data)
     {
-        m_vinRegister.reg = data;
-    }
-    else if (addr == 0xFF25)
+        APU* apu = static_cast<APU*>(context);
+        if (apu->m_allSoundsOn)
+            apu->m_channel3.WriteByte(addr, data);
+    };
+    for (uint16_t addr = 0xFF1A; addr <= 0xFF1E; ++addr)
+        registers.Install(addr, this, readChannel3, writeChannel3);
+    // Wave RAM
+    for (uint16_t addr = 0xFF30; addr <= 0xFF3F; ++addr)
+        registers.Install(addr, this, readChannel3, writeChannel3);
+
+    for (uint16_t addr = 0xFF1F; addr <= 0xFF23; ++addr)
     {
-        m_outputTerminalRegister.reg = data;
+        registers.Install(
+            addr, this, [](void* apu, uint16_t addr) { return static_cast<APU*>(apu)->m_channel4.ReadByte(addr); },
+            [](void* context, uint16_t addr, uint8_t data)
+            {
+                APU* apu = static_cast<APU*>(context);
+                if (apu->m_allSoundsOn)
+                    apu->m_channel4.WriteByte(addr, data);
+            });
     }
-    else if (addr == 0xFF26)
-    {
-        bool allSoundsOn = (data & 0x80) > 0;
 
-        if (allSoundsOn != m_allSoundsOn)
+    registers.Install(
+        0xFF24, this, [](void* apu, uint16_t) { return static_cast<APU*>(apu)->m_vinRegister.reg; },
+        [](void* context, uint16_t, uint8_t data)
         {
-            if (allSoundsOn)
-            {
-                m_circularBuffer.Reset();
-            }
-            else
-            {
-                m_circularBuffer.Stop();
-            }
-        }
-
-        m_allSoundsOn = allSoundsOn;
-
-        if (!m_allSoundsOn)
+            APU* apu = static_cast<APU*>(context);
+            if (apu->m_allSoundsOn)
+                apu->m_vinRegister.reg = data;
+        });
+
+    registers.Install(
+        0xFF25, this, [](void* apu, uint16_t) { return static_cast<APU*>(apu)->m_outputTerminalRegister.reg; },
+        [](void* context, uint16_t, uint8_t data)
         {
-            m_channel1.Reset();
-            m_channel2.Reset();
-            m_channel3.Reset();
-            m_channel4.Reset();
-            m_vinRegister.reg = 0x00;
-            m_outputTerminalRegister.reg = 0x00;
-        }
-    }
+            APU* apu = static_cast<APU*>(context);
+            if (apu->m_allSoundsOn)
+                apu->m_outputTerminalRegister.reg = data;
+        });
+
+    registers.Install(
+        0xFF26, this, [](void* apu, uint16_t) { return static_cast<APU*>(apu)->ReadSoundControl(); },
+        [](void* apu, uint16_t, uint8_t data) { static_cast<APU*>(apu)->WriteSoundControl(data); });
+
+    // Unused
+    for (uint16_t addr = 0xFF27; addr <= 0xFF2F; ++addr)
+        registers.Install(addr, this, [](void*, uint16_t) -> uint8_t { return 0xFF; }, nullptr);
 }
 
-uint8_t APU::ReadByte(uint16_t addr) const
+void APU::WriteSoundControl(uint8_t data)
 {
-    if (addr >= 0xFF10 && addr <= 0xFF14)
-    {
-        return m_channel1.ReadByte(addr - 0xFF10);
-    }
-    else if (addr >= 0xFF15 && addr <= 0xFF19)
-    {
-        return m_channel2.ReadByte(addr - 0xFF15);
-    }
-    else if ((addr >= 0xFF1A && addr <= 0xFF1E) || (addr >= 0xFF30 && addr <= 0xFF3F))
-    {
-        return m_channel3.ReadByte(addr);
-    }
-    else if (addr >= 0xFF1F && addr <= 0xFF23)
-    {
-        return m_channel4.ReadByte(addr);
-    }
-    else if (addr == 0xFF24)
-    {
-        return m_vinRegister.reg;
-    }
-    else if (addr == 0xFF25)
-    {
-        return m_outputTerminalRegister.reg;
-    }
-    else if (addr == 0xFF26)
+    bool allSoundsOn = (data & 0x80) > 0;
+
+    if (allSoundsOn != m_allSoundsOn)
     {
-        uint8_t res = 0x70;
-        if (m_channel1.IsEnabled())
-            res |= 0x01;
-        if (m_channel2.IsEnabled())
-            res |= 0x02;
-        if (m_channel3.IsEnabled())
-            res |= 0x04;
-        if (m_channel4.IsEnabled())
-            res |= 0x08;
-        if (m_allSoundsOn)
-            res |= 0x80;
-
-        return res;
+        if (allSoundsOn)
+        {
+            m_circularBuffer.Reset();
+        }
+        else
+        {
+            m_circularBuffer.Stop();
+        }
     }
-    else if (addr >= 0xFF27 && addr <= 0xFF2F)
+
+    m_allSoundsOn = allSoundsOn;
+
+    if (!m_allSoundsOn)
     {
-        return 0xFF;
+        m_channel1.Reset();
+        m_channel2.Reset();
+        m_channel3.Reset();
+        m_channel4.Reset();
+        m_vinRegister.reg = 0x00;
+        m_outputTerminalRegister.reg = 0x00;
     }
+}
 
-    return 0x00;
+uint8_t APU::ReadSoundControl() const
+{
+    uint8_t res = 0x70;
+    if (m_channel1.IsEnabled())
+        res |= 0x01;
+    if (m_channel2.IsEnabled())
+        res |= 0x02;
+    if (m_channel3.IsEnabled())
+        res |= 0x04;
+    if (m_channel4.IsEnabled())
+        res |= 0x08;
+    if (m_allSoundsOn)
+        res |= 0x80;
+
+    return res;
 }
 
 void APU::FillSamples(float* outData, unsigned int numFrames, unsigned int numChannels)
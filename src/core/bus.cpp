@@ -3,33 +3,39 @@
 #include <core/utils/utils.h>
 #include <core/z80Processor.h>
 #include <cstdint>
+#include <cstring>
 
 using GBEmulator::Bus;
 
 constexpr bool enableLogger = false;
 
-Bus::Bus()
+Bus::Bus(PixelFormat pixelFormat)
+    : m_ppu(pixelFormat)
 {
-    // 32kB work ram (in GBC mode). Will be limited to
-    // 8kB in GB mode.
-    m_WRAM.resize(0x8000);
-
     // TODO: Fill the rom with the right data
     m_ROM.fill(0x00);
 
     // Connect to the cpu and ppu
     m_cpu.ConnectBus(this);
     m_ppu.ConnectBus(this);
+    m_ppu.ConnectMemory(*m_memory);
+    m_timer.ConnectBus(this);
 
     m_instLogger = std::make_unique<GBEmulator::InstructionLogger>(*this);
 
     Reset();
 }
 
+Bus::~Bus() { DetachCartridge(); }
+
 uint8_t Bus::ReadByte(uint16_t addr) const { return const_cast<Bus*>(this)->ReadByte(addr, true); }
 
 uint8_t Bus::ReadByte(uint16_t addr, bool readOnly)
 {
+    // Plain memory, read directly
+    if (const uint8_t* page = m_readPages[addr >> 8])
+        return page[addr & 0x00FF];
+
     uint8_t data = 0;
 
     // VRAM zone
@@ -50,9 +56,9 @@ uint8_t Bus::ReadByte(uint16_t addr, bool readOnly)
         // Get the WRAM bank
         // Between 0xC000 and 0xCFFF it's bank 0
         // Between 0xD000 and 0xDFFF it's bank switchable
-        uint8_t wramBank = (addr & 0x1000) ? m_currentWRAMBank : 0;
+        uint8_t wramBank = (addr & 0x1000) ? m_registers.currentWRAMBank : 0;
         // WRAM banks are 4kB in size
-        data = m_WRAM[wramBank * 0x1000 + (addr & 0x0FFF)];
+        data = m_memory->workRAM[wramBank * 0x1000 + (addr & 0x0FFF)];
     }
     // Sprite attribute table (OAM)
     else if (addr >= 0xFE00 && addr <= 0xFE9F)
@@ -64,111 +70,20 @@ uint8_t Bus::ReadByte(uint16_t addr, bool readOnly)
     {
         // TODO
     }
-    // Misc zone
-    else if (addr == 0xFF00)
-    {
-        // Controller
-        data = m_controller ? m_controller->ReadData() : 0xFF;
-    }
-    else if (addr == 0xFF01 || addr == 0xFF02)
-    {
-        // Communication
-        // TODO
-    }
-    else if (addr >= 0xFF04 && addr <= 0xFF07)
-    {
-        // Divider and timer
-        data = m_timer.ReadByte(addr, readOnly);
-    }
-    else if (addr == IF_REG_ADDR)
-    {
-        // IF - Interupt flag
-        data = m_IF.flag;
-    }
-    else if (addr >= 0xFF10 && addr <= 0xFF3F)
-    {
-        // Sound and Waveform RAM
-        data = m_apu.ReadByte(addr);
-    }
-    else if (addr == 0xFF46)
-    {
-        // DMA
-        // Write only
-    }
-    else if (addr >= 0xFF40 && addr <= 0xFF4B)
-    {
-        // LCD
-        data = m_ppu.ReadByte(addr, readOnly);
-    }
-    else if (addr == 0xFF4D)
-    {
-        if (m_mode == Mode::GBC)
-        {
-            // Switching speed (GBC only)
-            if (m_isDoubleSpeedMode)
-            {
-                data |= 0x80;
-            }
-
-            if (m_isPreparingForChangingSpeed)
-            {
-                data |= 0x01;
-            }
-        }
-        else
-        {
-            data = 0xff;
-        }
-    }
-    else if (addr == 0xFF4F && m_mode == Mode::GBC)
-    {
-        // VRAM bank select (GBC only)
-        data = m_ppu.ReadByte(addr, readOnly);
-    }
-    else if (addr == 0xFF50)
-    {
-        // Set to non-zero to disable boot ROM
-        // Not used in Read
-    }
-    else if (addr == 0xFF55 && m_mode == Mode::GBC)
-    {
-        // VRAM DMA (GBC only)
-        // Only 0xFF55 is readable
-        // 0xFF means the transfer is done. Otherwise, returns the number of $10 blocks
-        // remaining.
-        // If DMA was stopped, write 1 to bit 7
-        if (m_DMABlocksRemainingGBC == 0)
-        {
-            data = 0xFF;
-        }
-        else
-        {
-            data = (m_DMABlocksRemainingGBC >> 4) - 1;
-            if (m_DMAWasStoppedGBC)
-            {
-                data = data | 0x80;
-            }
-        }
-    }
-    else if (addr >= 0xFF68 && addr <= 0xFF6B && m_mode == Mode::GBC)
+    // IO registers
+    else if (addr >= IO_REGISTERS_START_ADDR && addr < IO_REGISTERS_START_ADDR + NB_IO_REGISTERS)
     {
-        // BG/OBJ palettes (GBC only)
-        data = m_ppu.ReadByte(addr, readOnly);
-    }
-    else if (addr == 0xFF70 && m_mode == Mode::GBC)
-    {
-        // WRAM Bank select (GBC only)
-        data = m_currentWRAMBank;
+        data = m_ioRegisters.Read(addr);
     }
     else if (addr >= 0xFF80 && addr <= 0xFFFE)
     {
         // High RAM
-        data = m_HRAM[addr - 0xFF80];
+        data = m_memory->highRAM[addr - 0xFF80];
     }
     else if (addr == IE_REG_ADDR)
     {
         // Interupt Enable Register (IE)
-        data = m_IE.flag;
+        data = m_registers.IE.flag;
     }
     // Try to read from the cartridge, if it returns true, it's done
     else if (m_cartridge && m_cartridge->ReadByte(addr, data, readOnly))
@@ -181,6 +96,18 @@ uint8_t Bus::ReadByte(uint16_t addr, bool readOnly)
 
 void Bus::WriteByte(uint16_t addr, uint8_t data)
 {
+    // Plain memory, written directly
+    const WritePage& page = m_writePages[addr >> 8];
+    if (page.data != nullptr)
+    {
+        page.data[addr & 0x00FF] = data;
+        if (page.ramIndex != GBEmulator::DECODE_CACHE_NO_RAM)
+            m_cpu.OnRAMWrite(page.ramIndex | (addr & 0x00FF));
+        else if (page.isVRAM)
+            m_ppu.OnVRAMPageWrite(addr, 1);
+        return;
+    }
+
     // VRAM zone
     if (addr >= 0x8000 && addr < 0xA000)
     {
@@ -199,9 +126,11 @@ void Bus::WriteByte(uint16_t addr, uint8_t data)
         // Get the WRAM bank
         // Between 0xC000 and 0xCFFF it's bank 0
         // Between 0xD000 and 0xDFFF it's bank switchable
-        uint8_t wramBank = (addr & 0x1000) ? m_currentWRAMBank : 0;
+        uint8_t wramBank = (addr & 0x1000) ? m_registers.currentWRAMBank : 0;
         // WRAM banks are 4kB in size
-        m_WRAM[wramBank * 0x1000 + (addr & 0x0FFF)] = data;
+        const uint16_t wramIndex = wramBank * 0x1000 + (addr & 0x0FFF);
+        m_memory->workRAM[wramIndex] = data;
+        m_cpu.OnRAMWrite(wramIndex);
     }
     // Sprite attribute table (OAM)
     else if (addr >= 0xFE00 && addr <= 0xFE9F)
@@ -213,131 +142,275 @@ void Bus::WriteByte(uint16_t addr, uint8_t data)
     {
         // TODO
     }
-    // Misc zone
-    else if (addr == 0xFF00)
-    {
-        // Controller
-        if (m_controller)
-            m_controller->WriteData(data);
-    }
-    else if (addr == 0xFF01 || addr == 0xFF02)
-    {
-        // Communication
-        // TODO
-    }
-    else if (addr >= 0xFF04 && addr <= 0xFF07)
+    // IO registers
+    else if (addr >= IO_REGISTERS_START_ADDR && addr < IO_REGISTERS_START_ADDR + NB_IO_REGISTERS)
     {
-        // Divider and timer
-        m_timer.WriteByte(addr, data);
+        m_ioRegisters.Write(addr, data);
     }
-    else if (addr == IF_REG_ADDR)
+    else if (addr >= 0xFF80 && addr <= 0xFFFE)
     {
-        // IF - Interupt flag
-        m_IF.flag = data & 0x1F;
+        // High RAM
+        m_memory->highRAM[addr - 0xFF80] = data;
+        m_cpu.OnRAMWrite(GBEmulator::DECODE_CACHE_HRAM_OFFSET + (addr - 0xFF80));
     }
-    else if (addr >= 0xFF10 && addr <= 0xFF3F)
+    else if (addr == IE_REG_ADDR)
     {
-        // Sound and Waveform RAM
-        m_apu.WriteByte(addr, data);
+        // Interupt Enable Register (IE)
+        m_registers.IE.flag = data & 0x1F;
+        m_cpu.OnInterruptFlagsChanged();
     }
-    else if (addr == 0xFF46)
+    // try to write from to cartridge, if it returns true, it's done
+    else if (m_cartridge && m_cartridge->WriteByte(addr, data))
     {
-        // DMA
-        m_isInDMA = true;
-        // Address can't be higher than 0xE000, so force it there (even if it shouldn't happen)
-        m_currentDMAAddress = (uint16_t)(data % 0xE0) << 8;
+        // Nothing to do
     }
-    else if (addr >= 0xFF40 && addr <= 0xFF4B)
+
+    // Writing in the ROM zone is talking to the mapper, banks might have changed
+    if (addr < 0x8000)
     {
-        // LCD
-        m_ppu.WriteByte(addr, data);
+        UpdateCartridgePages();
+        m_cpu.OnMemoryMapChanged();
     }
-    else if (addr == 0xFF4D && m_mode == Mode::GBC)
-    {
-        // Switching speed (GBC Only)
-        if (!!(data & 0x01))
+}
+
+void Bus::InstallIORegisters()
+{
+    m_ioRegisters.Clear();
+
+    const bool isGBC = m_mode == Mode::GBC;
+    m_timer.InstallIORegisters(m_ioRegisters);
+    m_apu.InstallIORegisters(m_ioRegisters);
+    m_ppu.InstallIORegisters(m_ioRegisters, isGBC);
+
+    // Controller
+    m_ioRegisters.Install(
+        0xFF00, this,
+        [](void* context, uint16_t) -> uint8_t
         {
-            m_isPreparingForChangingSpeed = true;
-        }
-    }
-    else if (addr == 0xFF4F && m_mode == Mode::GBC)
-    {
-        // VRAM bank select (GBC only)
-        m_ppu.WriteByte(addr, data);
-    }
-    else if (addr == 0xFF50)
+            Bus* bus = static_cast<Bus*>(context);
+            return bus->m_controller ? bus->m_controller->ReadData() : 0xFF;
+        },
+        [](void* context, uint16_t, uint8_t data)
+        {
+            Bus* bus = static_cast<Bus*>(context);
+            if (bus->m_controller)
+                bus->m_controller->WriteData(data);
+        });
+
+    // IF - Interupt flag
+    m_ioRegisters.Install(
+        IF_REG_ADDR, this, [](void* bus, uint16_t) { return static_cast<Bus*>(bus)->m_registers.IF.flag; },
+        [](void* context, uint16_t, uint8_t data)
+        {
+            Bus* bus = static_cast<Bus*>(context);
+            bus->m_registers.IF.flag = data & 0x1F;
+            bus->m_cpu.OnInterruptFlagsChanged();
+        });
+
+    // DMA, write only
+    m_ioRegisters.Install(0xFF46, this, nullptr,
+                          [](void* context, uint16_t, uint8_t data)
+                          {
+                              Bus* bus = static_cast<Bus*>(context);
+                              bus->m_isInDMA = true;
+                              // Address can't be higher than 0xE000, so force it there (even if it shouldn't happen)
+                              bus->m_currentDMAAddress = (uint16_t)(data % 0xE0) << 8;
+                          });
+
+    if (!isGBC)
     {
-        // Set to non-zero to disable boot ROM
-        // TODO
+        // Switching speed is GBC only
+        m_ioRegisters.Install(0xFF4D, this, [](void*, uint16_t) -> uint8_t { return 0xFF; }, nullptr);
+        return;
     }
-    else if (addr >= 0xFF51 && addr <= 0xFF55 && m_mode == Mode::GBC)
+
+    // Switching speed (GBC only)
+    m_ioRegisters.Install(
+        0xFF4D, this,
+        [](void* context, uint16_t)
+        {
+            Bus* bus = static_cast<Bus*>(context);
+            uint8_t data = 0x00;
+            if (bus->m_isDoubleSpeedMode)
+                data |= 0x80;
+
+            if (bus->m_isPreparingForChangingSpeed)
+                data |= 0x01;
+
+            return data;
+        },
+        [](void* context, uint16_t, uint8_t data)
+        {
+            if (!!(data & 0x01))
+                static_cast<Bus*>(context)->m_isPreparingForChangingSpeed = true;
+        });
+
+    // VRAM DMA (GBC only)
+    auto writeVRAMDMA = [](void* context, uint16_t addr, uint8_t data)
     {
-        // VRAM DMA (GBC only)
+        Bus* bus = static_cast<Bus*>(context);
         switch (addr)
         {
         case 0xFF51:
             // High address source
-            m_DMASourceAddrGBC = ((uint16_t)data << 8) | (m_DMASourceAddrGBC & 0x00FF);
+            bus->m_DMASourceAddrGBC = ((uint16_t)data << 8) | (bus->m_DMASourceAddrGBC & 0x00FF);
             break;
         case 0xFF52:
             // Low address source, 4 lower bits ignored
-            m_DMASourceAddrGBC = (m_DMASourceAddrGBC & 0xFF00) | (data & 0xF0);
+            bus->m_DMASourceAddrGBC = (bus->m_DMASourceAddrGBC & 0xFF00) | (data & 0xF0);
             break;
         case 0xFF53:
         {
             // High address dest, 3 higher bits ignored. Will be between 0x8000 and 0x9FF0
             uint16_t highAddress = (uint16_t)(data & 0x1F);
             highAddress <<= 8;
-            m_DMADestAddrGBC = 0x8000 | highAddress | (m_DMADestAddrGBC & 0x00FF);
+            bus->m_DMADestAddrGBC = 0x8000 | highAddress | (bus->m_DMADestAddrGBC & 0x00FF);
             break;
         }
         case 0xFF54:
             // Low address dest, 4 lower bits ignored
-            m_DMADestAddrGBC = (m_DMADestAddrGBC & 0xFF00) | (data & 0xF0);
+            bus->m_DMADestAddrGBC = (bus->m_DMADestAddrGBC & 0xFF00) | (data & 0xF0);
             break;
         case 0xFF55:
             // If DMA is not active (no remaining blocks) writing to this starts a new DMA
-            if (m_DMABlocksRemainingGBC == 0 || m_DMAWasStoppedGBC)
+            if (bus->m_DMABlocksRemainingGBC == 0 || bus->m_DMAWasStoppedGBC)
             {
-                m_isDMAHBlankModeGBC = (data & 0x80) > 0;
-                m_DMABlocksRemainingGBC = ((data & 0x7F) + 1) << 4;
-                m_DMAWasStoppedGBC = false;
+                bus->m_isDMAHBlankModeGBC = (data & 0x80) > 0;
+                bus->m_DMABlocksRemainingGBC = ((data & 0x7F) + 1) << 4;
+                bus->m_DMAWasStoppedGBC = false;
             }
             else
             {
                 // Otherwise, if we are in HBlank mode, and bit 7 is 0, stop the transfer
-                m_DMAWasStoppedGBC = ((data & 0x80) == 0) && m_isDMAHBlankModeGBC;
+                bus->m_DMAWasStoppedGBC = ((data & 0x80) == 0) && bus->m_isDMAHBlankModeGBC;
             }
         }
+    };
+    for (uint16_t addr = 0xFF51; addr <= 0xFF54; ++addr)
+        m_ioRegisters.Install(addr, this, nullptr, writeVRAMDMA);
+
+    // Only 0xFF55 is readable
+    // 0xFF means the transfer is done. Otherwise, returns the number of $10 blocks
+    // remaining.
+    // If DMA was stopped, write 1 to bit 7
+    m_ioRegisters.Install(
+        0xFF55, this,
+        [](void* context, uint16_t) -> uint8_t
+        {
+            Bus* bus = static_cast<Bus*>(context);
+            if (bus->m_DMABlocksRemainingGBC == 0)
+                return 0xFF;
+
+            uint8_t data = (bus->m_DMABlocksRemainingGBC >> 4) - 1;
+            if (bus->m_DMAWasStoppedGBC)
+                data = data | 0x80;
+
+            return data;
+        },
+        writeVRAMDMA);
+
+    // WRAM Bank select (GBC only)
+    m_ioRegisters.Install(
+        0xFF70, this, [](void* bus, uint16_t) { return static_cast<Bus*>(bus)->m_registers.currentWRAMBank; },
+        [](void* context, uint16_t, uint8_t data)
+        {
+            Bus* bus = static_cast<Bus*>(context);
+            // A bank of 0 will select bank 1
+            bus->m_registers.currentWRAMBank = (data & 0x07);
+            if (bus->m_registers.currentWRAMBank == 0)
+                bus->m_registers.currentWRAMBank = 1;
+
+            bus->UpdateWRAMPages();
+            bus->m_cpu.OnMemoryMapChanged();
+        });
+}
+
+void Bus::UpdateMemoryMap()
+{
+    // Everything else (OAM, IO, HRAM) goes through the handlers
+    m_readPages.fill(nullptr);
+    m_writePages.fill(WritePage());
+
+    UpdateCartridgePages();
+    UpdateVRAMPages();
+    UpdateWRAMPages();
+}
+
+void Bus::UpdateCartridgePages()
+{
+    // ROM is read only, writes go to the mapper
+    for (uint16_t page = 0x00; page < 0x80; ++page)
+        m_readPages[page] = m_cartridge ? m_cartridge->GetROMPage(page << 8) : nullptr;
+
+    for (uint16_t page = 0xA0; page < 0xC0; ++page)
+    {
+        uint8_t* data = m_cartridge ? m_cartridge->GetRAMPage(page << 8) : nullptr;
+        m_readPages[page] = data;
+        m_writePages[page].data = data;
     }
-    else if (addr >= 0xFF68 && addr <= 0xFF6B && m_mode == Mode::GBC)
+}
+
+void Bus::UpdateVRAMPages()
+{
+    // Writes are notified to the PPU, for its tile cache
+    for (uint16_t page = 0x80; page < 0xA0; ++page)
     {
-        // BG/OBJ palettes (GBC only)
-        m_ppu.WriteByte(addr, data);
+        m_readPages[page] = m_ppu.GetVRAMPage(page << 8);
+        m_writePages[page].data = m_ppu.GetVRAMPage(page << 8);
+        m_writePages[page].isVRAM = true;
     }
-    else if (addr == 0xFF70 && m_mode == Mode::GBC)
+}
+
+void Bus::UpdateWRAMPages()
+{
+    // 0xC000-0xCFFF is bank 0, 0xD000-0xDFFF is the switchable bank.
+    // 0xE000-0xFDFF echoes 0xC000-0xDDFF.
+    for (uint16_t page = 0xC0; page < 0xFE; ++page)
     {
-        // WRAM Bank select (GBC only)
-        // A bank of 0 will select bank 1
-        m_currentWRAMBank = (data & 0x07);
-        if (m_currentWRAMBank == 0)
-            m_currentWRAMBank = 1;
+        const uint16_t wramPage = page >= 0xE0 ? page - 0x20 : page;
+        const uint8_t wramBank = (wramPage & 0x10) ? m_registers.currentWRAMBank : 0;
+        const uint16_t wramIndex = wramBank * 0x1000 + ((wramPage << 8) & 0x0F00);
+
+        m_readPages[page] = &m_memory->workRAM[wramIndex];
+        m_writePages[page].data = &m_memory->workRAM[wramIndex];
+        m_writePages[page].ramIndex = wramIndex;
     }
-    else if (addr >= 0xFF80 && addr <= 0xFFFE)
+}
+
+bool Bus::GetCodeLocation(uint16_t addr, uint16_t& bank, uint16_t& ramIndex, uint32_t& endAddress) const
+{
+    // ROM zone, first and second bank
+    if (addr < 0x8000)
     {
-        // High RAM
-        m_HRAM[addr - 0xFF80] = data;
+        if (!m_cartridge)
+            return false;
+
+        bank = m_cartridge->GetROMBank(addr);
+        ramIndex = GBEmulator::DECODE_CACHE_NO_RAM;
+        endAddress = (addr & 0x4000) ? 0x8000 : 0x4000;
+        return true;
     }
-    else if (addr == IE_REG_ADDR)
+
+    // WRAM zone, without the echo
+    // Blocks in RAM are limited to a single page of 256 bytes.
+    if (addr >= 0xC000 && addr < 0xE000)
     {
-        // Interupt Enable Register (IE)
-        m_IE.flag = data & 0x1F;
+        bank = (addr & 0x1000) ? m_registers.currentWRAMBank : 0;
+        ramIndex = bank * 0x1000 + (addr & 0x0FFF);
+        endAddress = (addr & 0xFF00) + 0x100;
+        return true;
     }
-    // try to write from to cartridge, if it returns true, it's done
-    else if (m_cartridge && m_cartridge->WriteByte(addr, data))
+
+    // High RAM
+    if (addr >= 0xFF80 && addr <= 0xFFFE)
     {
-        // Nothing to do
+        bank = 0;
+        ramIndex = GBEmulator::DECODE_CACHE_HRAM_OFFSET + (addr - 0xFF80);
+        endAddress = 0xFFFF;
+        return true;
     }
+
+    return false;
 }
 
 // Return true if the PPU finished a frame during the clock.
@@ -347,14 +420,29 @@ bool Bus::Clock(bool* outInstDone)
     if (!m_cartridge)
         return false;
 
-    if (m_nbRemainingCyclesForChangingSpeed > 0 && --m_nbRemainingCyclesForChangingSpeed == 0)
-    {
-        m_cpu.ForceUnpause();
-    }
+    return (this->*m_clockFunction)(outInstDone);
+}
+
+void Bus::UpdateClockFunction()
+{
+    // Double speed is only available in GBC mode
+    const bool isDebugging = m_runToAddress != 0xFFFFFFFF || m_instLogger->IsEnabled();
+    if (m_mode == Mode::GB)
+        m_clockFunction = isDebugging ? &Bus::ClockImpl<false, false, true> : &Bus::ClockImpl<false, false, false>;
+    else if (!m_isDoubleSpeedMode)
+        m_clockFunction = isDebugging ? &Bus::ClockImpl<true, false, true> : &Bus::ClockImpl<true, false, false>;
+    else
+        m_clockFunction = isDebugging ? &Bus::ClockImpl<true, true, true> : &Bus::ClockImpl<true, true, false>;
+}
+
+template <bool IsGBC, bool IsDoubleSpeed, bool IsDebugging>
+bool Bus::ClockImpl(bool* outInstDone)
+{
+    m_nbCycles++;
 
     bool frameFinished = false;
 
-    const unsigned numberOfPPUClocks = m_isDoubleSpeedMode ? 2 : 4;
+    constexpr unsigned numberOfPPUClocks = IsDoubleSpeed ? 2 : 4;
 
     // Clock the PPU 4 times in single speed, 2 times in double speed.
     for (auto i = 0u; i < numberOfPPUClocks; ++i)
@@ -363,38 +451,31 @@ bool Bus::Clock(bool* outInstDone)
         frameFinished |= m_ppu.IsFrameComplete();
     }
 
+    if (frameFinished && !m_gameSharkCodes.empty())
+        ApplyGameSharkCodes();
+
     // APU is clocked every cpu cycle in single speed,
     // and every 2 cycles in double speed.
-    if (!m_isDoubleSpeedMode || (m_nbCycles & 0x1) == 0)
+    if (!IsDoubleSpeed || (m_nbCycles & 0x1) == 1)
     {
         m_apu.Clock();
     }
 
-    // Update the controller and the interrupt
-    if (m_controller)
-    {
-        if (m_controller->HasChangedFromHighToLow())
-        {
-            m_IF.joypad = 1;
-        }
-        m_controller->Update();
-    }
+    // Events due at this cycle (timer overflow, joypad input, end of speed switch), before the CPU sees them
+    if (m_nbCycles >= m_scheduler.GetNextEventCycle())
+        RunScheduledEvents();
 
-    // Clock the timer always 4 times
-    // So in double speed mode it will be twice as fast
-    for (auto i = 0; i < 4; ++i)
+    // If we are in DMA, copy data. CPU is still clocked.
+    // The copy is progressive, as the PPU reads OAM and the CPU can change the source in between.
+    if (m_isInDMA)
     {
-        if (m_timer.Clock())
+        // Only the first 0xA0 bytes are in OAM, the rest is not usable
+        const uint8_t offset = m_currentDMAAddress & 0x00FF;
+        if (offset < 0xA0)
         {
-            m_IF.timer = 1;
+            const uint8_t* srcPage = m_readPages[m_currentDMAAddress >> 8];
+            m_ppu.WriteOAM(offset, srcPage != nullptr ? srcPage[offset] : ReadByte(m_currentDMAAddress));
         }
-    }
-
-    // If we are in DMA, copy data. CPU is still clocked
-    if (m_isInDMA)
-    {
-        uint16_t destAddress = 0xFE00 | (m_currentDMAAddress & 0x00FF);
-        WriteByte(destAddress, ReadByte(m_currentDMAAddress));
         m_currentDMAAddress++;
         if ((m_currentDMAAddress & 0x00FF) == 0xE0)
         {
@@ -405,29 +486,31 @@ bool Bus::Clock(bool* outInstDone)
     // But in VRAM DMA (only GBC), the CPU is stopped during the transfer
     // Transfer everything (when in general purpose mode) or a single block (in hblank mode)
     // in one clock.
-    if (m_DMABlocksRemainingGBC != 0 && !m_DMAHBlankWasHandled && !m_DMAWasStoppedGBC)
+    if constexpr (IsGBC)
     {
-        if (!m_isDMAHBlankModeGBC || m_ppu.IsInHBlank())
+        if (m_DMABlocksRemainingGBC != 0 && !m_DMAHBlankWasHandled && !m_DMAWasStoppedGBC)
         {
-            const uint16_t nbBytesToTransfer = m_isDMAHBlankModeGBC ? 0x10 : m_DMABlocksRemainingGBC;
-            for (uint16_t i = 0; i < nbBytesToTransfer; ++i)
+            if (!m_isDMAHBlankModeGBC || m_ppu.IsInHBlank())
             {
-                WriteByte(m_DMADestAddrGBC++, ReadByte(m_DMASourceAddrGBC++));
-            }
+                const uint16_t nbBytesToTransfer = m_isDMAHBlankModeGBC ? 0x10 : m_DMABlocksRemainingGBC;
+                CopyMemory(m_DMADestAddrGBC, m_DMASourceAddrGBC, nbBytesToTransfer);
+                m_DMADestAddrGBC += nbBytesToTransfer;
+                m_DMASourceAddrGBC += nbBytesToTransfer;
 
-            m_DMABlocksRemainingGBC -= nbBytesToTransfer;
+                m_DMABlocksRemainingGBC -= nbBytesToTransfer;
 
-            if (m_isDMAHBlankModeGBC)
-            {
-                m_DMAHBlankWasHandled = true;
+                if (m_isDMAHBlankModeGBC)
+                {
+                    m_DMAHBlankWasHandled = true;
+                }
             }
         }
-    }
 
-    // When we exit HBlank, reset this flag
-    if (!m_ppu.IsInHBlank() && m_DMAHBlankWasHandled)
-    {
-        m_DMAHBlankWasHandled = false;
+        // When we exit HBlank, reset this flag
+        if (!m_ppu.IsInHBlank() && m_DMAHBlankWasHandled)
+        {
+            m_DMAHBlankWasHandled = false;
+        }
     }
 
     if (m_cpu.Clock())
@@ -435,35 +518,312 @@ bool Bus::Clock(bool* outInstDone)
         if (outInstDone != nullptr)
             *outInstDone = true;
 
-        m_instLogger->WriteCurrentState();
+        if constexpr (IsDebugging)
+            m_instLogger->WriteCurrentState();
     }
 
     // Check if we need to change speed
+    if constexpr (IsGBC)
+    {
+        if (m_isPreparingForChangingSpeed && m_cpu.IsStopped())
+        {
+            m_isPreparingForChangingSpeed = false;
+
+            // Emulated time runs at the new speed from the next cycle
+            m_emulatedTime = GetEmulatedTime();
+            m_emulatedTimeCycle = m_nbCycles;
+
+            m_isDoubleSpeedMode = !m_isDoubleSpeedMode;
+            m_scheduler.Schedule(SchedulerEvent::SpeedSwitchDone, m_nbCycles + 2050); // Taken from PanDocs
+            UpdateClockFunction();
+        }
+    }
+
+    if constexpr (IsDebugging)
+    {
+        if (m_runToAddress != 0xFFFFFFFF && (uint32_t)m_cpu.GetPC() == m_runToAddress)
+        {
+            m_runToAddress = 0xFFFFFFFF;
+            m_isInBreakMode = true;
+            UpdateClockFunction();
+        }
+    }
+
+    return frameFinished;
+}
+
+void Bus::RunScheduledEvents()
+{
+    SchedulerEvent event;
+    uint64_t eventCycle;
+    while (m_scheduler.PopDueEvent(m_nbCycles, event, eventCycle))
+    {
+        switch (event)
+        {
+        case SchedulerEvent::TimerOverflow:
+            m_timer.OnOverflow();
+            m_registers.IF.timer = 1;
+            m_cpu.OnInterruptFlagsChanged();
+            break;
+        case SchedulerEvent::JoypadInput:
+            if (m_controller && m_controller->ApplyInputs(m_nbCycles))
+            {
+                m_registers.IF.joypad = 1;
+                m_cpu.OnInterruptFlagsChanged();
+            }
+            break;
+        case SchedulerEvent::SpeedSwitchDone:
+            m_cpu.ForceUnpause();
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+GBEmulator::RunStatus Bus::RunCycles(size_t maxNbCycles, bool stopOnAudioSamples)
+{
+    RunStatus status;
+    status.isInBreak = m_isInBreakMode;
+    status.areAudioSamplesReady = stopOnAudioSamples && m_apu.AreSamplesReady();
+    if (!m_cartridge || status.isInBreak || status.areAudioSamplesReady)
+        return status;
+
+    // Fast-forward stops at the end of each line when checking audio samples,
+    // so there is at most one audio buffer filled at a time.
+    const size_t maxNbFastForwardCycles = stopOnAudioSamples ? 114 : maxNbCycles;
+
+    while (status.nbCycles < maxNbCycles)
+    {
+        bool frameFinished = false;
+        size_t nbCycles =
+            FastForward(std::min(maxNbCycles - status.nbCycles, maxNbFastForwardCycles), &frameFinished);
+        if (nbCycles == 0)
+        {
+            frameFinished = (this->*m_clockFunction)(nullptr);
+            nbCycles = 1;
+        }
+        status.nbCycles += nbCycles;
+
+        status.frameFinished = frameFinished;
+        status.isInBreak = m_isInBreakMode;
+        status.areAudioSamplesReady = stopOnAudioSamples && m_apu.AreSamplesReady();
+        if (status.frameFinished || status.isInBreak || status.areAudioSamplesReady)
+            break;
+    }
+
+    return status;
+}
+
+GBEmulator::RunStatus Bus::RunFrame(bool stopOnAudioSamples)
+{
+    return RunCycles(GetNbCyclesPerFrame(), stopOnAudioSamples);
+}
+
+size_t Bus::FastForward(size_t maxNbCycles, bool* outFrameFinished)
+{
+    if (!m_cartridge)
+        return 0;
+
+    // Anything that is not a simple counter is done by Clock()
+    if (m_isInDMA)
+        return 0;
+
+    if (m_DMABlocksRemainingGBC != 0 && !m_DMAHBlankWasHandled && !m_DMAWasStoppedGBC &&
+        (!m_isDMAHBlankModeGBC || m_ppu.IsInHBlank()))
+        return 0;
+
     if (m_mode == Mode::GBC && m_isPreparingForChangingSpeed && m_cpu.IsStopped())
+        return 0;
+
+    if (m_runToAddress != 0xFFFFFFFF)
+        return 0;
+
+    // Find the next event
+    size_t nbCycles = maxNbCycles;
+
+    // Stop before the next scheduled event (timer overflow, joypad input, end of speed switch)
+    nbCycles = std::min<size_t>(nbCycles, (size_t)(m_scheduler.GetNextEventCycle() - m_nbCycles - 1));
+
+    const unsigned numberOfPPUClocks = m_isDoubleSpeedMode ? 2 : 4;
+
+    // CPU halted: nothing to do until an interrupt wakes it up.
+    // The PPU can skip its idle dots.
+    if (m_cpu.IsWaitingForInterrupt())
     {
-        m_isPreparingForChangingSpeed = false;
-        m_isDoubleSpeedMode = !m_isDoubleSpeedMode;
-        m_nbRemainingCyclesForChangingSpeed = 2050; // Taken from PanDocs
+        if (m_cpu.IsInterruptPending())
+            return 0;
+
+        nbCycles = std::min<size_t>(nbCycles, m_ppu.GetNbIdleDots() / numberOfPPUClocks);
+        if (nbCycles == 0)
+            return 0;
+
+        AdvanceWithoutCPU(nbCycles, true, outFrameFinished);
+        return nbCycles;
     }
 
-    if (m_runToAddress != 0xFFFFFFFF && (uint32_t)m_cpu.GetPC() == m_runToAddress)
+    // CPU in a loop that can be run in bulk: a busy-wait loop, where iterations are the same as long as the
+    // polled register doesn't change, or a memory copy/fill loop.
+    // The PPU is still clocked, but it must not change its registers.
+    uint16_t polledAddress = 0x0000;
+    uint16_t destinationAddress = 0x0000;
+    const bool isInIdleLoop = m_cpu.IsInIdleLoop(polledAddress);
+    if ((!isInIdleLoop && !m_cpu.IsInMemoryLoop(destinationAddress)) || m_instLogger->IsEnabled())
+        return 0;
+
+    if (m_cpu.IsIMEEnabled() && m_cpu.IsInterruptPending())
+        return 0;
+
+    nbCycles = std::min<size_t>(nbCycles, m_ppu.GetNbDotsBeforeNextEvent() / numberOfPPUClocks);
+
+    if (isInIdleLoop)
     {
-        m_runToAddress = 0xFFFFFFFF;
-        m_isInBreakMode = true;
+        m_timer.Sync();
+        nbCycles = std::min<size_t>(nbCycles, (m_timer.GetNbClocksBeforeChange(polledAddress) - 1) / 4);
+        nbCycles = m_cpu.SkipIdleLoop(nbCycles);
     }
+    else
+    {
+        // VRAM is written before the PPU is clocked, so the PPU must not read it in between
+        if (destinationAddress >= 0x8000 && destinationAddress < 0xA000 && m_ppu.IsReadingVRAMOnNextDot())
+            return 0;
 
-    m_nbCycles++;
+        nbCycles = m_cpu.RunMemoryLoop(nbCycles);
+    }
+
+    if (nbCycles == 0)
+        return 0;
 
-    const size_t nbCyclesToCheck = m_isDoubleSpeedMode ? GBEmulator::CPU_NB_CYCLES_PER_SECOND_DOUBLE_SPEED
-                                                       : GBEmulator::CPU_NB_CYCLES_PER_SECOND_SINGLE_SPEED;
-    if (++m_nbCyclesForSeconds >= nbCyclesToCheck)
+    AdvanceWithoutCPU(nbCycles, false, outFrameFinished);
+    return nbCycles;
+}
+
+bool Bus::IsPlainMemory(uint16_t addr, size_t size, bool isWrite) const
+{
+    const size_t end = (size_t)addr + size;
+    auto isInside = [addr, end](size_t regionBegin, size_t regionEnd)
+    { return addr >= regionBegin && end <= regionEnd; };
+
+    // ROM is read only, writes go to the MBC
+    if (!isWrite && isInside(0x0000, 0x8000))
+        return true;
+
+    // VRAM, WRAM and HRAM
+    return isInside(0x8000, 0xA000) || isInside(0xC000, 0xE000) || isInside(0xFF80, 0xFFFF);
+}
+
+void Bus::CopyMemory(uint16_t dst, uint16_t src, uint16_t size)
+{
+    // Copied by chunks staying in a single page for both the source and the destination.
+    // Memory without page (OAM, IO, HRAM, mapper registers...) and overlapping chunks are copied
+    // byte per byte, in the same order than the CPU, so they give the same result.
+    while (size > 0)
     {
-        m_nbCyclesForSeconds -= nbCyclesToCheck;
-        m_cartridge->TickSecond();
-        //std::cout << "Second" << std::endl;
+        const uint16_t chunkSize =
+            std::min<uint16_t>({size, (uint16_t)(0x100 - (dst & 0x00FF)), (uint16_t)(0x100 - (src & 0x00FF))});
+
+        const uint8_t* srcPage = m_readPages[src >> 8];
+        const WritePage& dstPage = m_writePages[dst >> 8];
+        const uint8_t* srcData = srcPage != nullptr ? srcPage + (src & 0x00FF) : nullptr;
+        uint8_t* dstData = dstPage.data != nullptr ? dstPage.data + (dst & 0x00FF) : nullptr;
+
+        const bool isMapped = srcData != nullptr && dstData != nullptr;
+        if (isMapped && (dstData >= srcData + chunkSize || srcData >= dstData + chunkSize))
+        {
+            std::memcpy(dstData, srcData, chunkSize);
+            if (dstPage.ramIndex != GBEmulator::DECODE_CACHE_NO_RAM)
+            {
+                for (uint16_t i = 0; i < chunkSize; ++i)
+                    m_cpu.OnRAMWrite(dstPage.ramIndex | ((dst + i) & 0x00FF));
+            }
+            else if (dstPage.isVRAM)
+            {
+                m_ppu.OnVRAMPageWrite(dst, chunkSize);
+            }
+        }
+        else
+        {
+            for (uint16_t i = 0; i < chunkSize; ++i)
+                WriteByte(dst + i, ReadByte(src + i));
+        }
+
+        dst += chunkSize;
+        src += chunkSize;
+        size -= chunkSize;
     }
+}
 
-    return frameFinished;
+void Bus::FillMemory(uint16_t dst, uint8_t value, uint16_t size)
+{
+    while (size > 0)
+    {
+        const uint16_t chunkSize = std::min<uint16_t>(size, 0x100 - (dst & 0x00FF));
+
+        const WritePage& dstPage = m_writePages[dst >> 8];
+        if (dstPage.data != nullptr)
+        {
+            std::memset(dstPage.data + (dst & 0x00FF), value, chunkSize);
+            if (dstPage.ramIndex != GBEmulator::DECODE_CACHE_NO_RAM)
+            {
+                for (uint16_t i = 0; i < chunkSize; ++i)
+                    m_cpu.OnRAMWrite(dstPage.ramIndex | ((dst + i) & 0x00FF));
+            }
+            else if (dstPage.isVRAM)
+            {
+                m_ppu.OnVRAMPageWrite(dst, chunkSize);
+            }
+        }
+        else
+        {
+            for (uint16_t i = 0; i < chunkSize; ++i)
+                WriteByte(dst + i, value);
+        }
+
+        dst += chunkSize;
+        size -= chunkSize;
+    }
+}
+
+void Bus::AdvanceWithoutCPU(size_t nbCycles, bool isPPUIdle, bool* outFrameFinished)
+{
+    const unsigned numberOfPPUClocks = m_isDoubleSpeedMode ? 2 : 4;
+    const unsigned nbDots = (unsigned)nbCycles * numberOfPPUClocks;
+
+    bool frameFinished = false;
+    if (isPPUIdle)
+    {
+        m_ppu.SkipIdleDots(nbDots);
+        frameFinished = m_ppu.IsFrameComplete();
+    }
+    else
+    {
+        for (auto i = 0u; i < nbDots; ++i)
+        {
+            m_ppu.Clock();
+            frameFinished |= m_ppu.IsFrameComplete();
+        }
+    }
+
+    if (frameFinished && !m_gameSharkCodes.empty())
+        ApplyGameSharkCodes();
+
+    if (outFrameFinished != nullptr)
+        *outFrameFinished = frameFinished;
+
+    for (size_t i = 0; i < nbCycles; ++i)
+    {
+        if (!m_isDoubleSpeedMode || ((m_nbCycles + i) & 0x1) == 0)
+        {
+            m_apu.Clock();
+        }
+    }
+
+    if (!m_ppu.IsInHBlank() && m_DMAHBlankWasHandled)
+    {
+        m_DMAHBlankWasHandled = false;
+    }
+
+    m_nbCycles += nbCycles;
 }
 
 void Bus::SerializeTo(Utils::IWriteVisitor& visitor) const
@@ -479,22 +839,28 @@ void Bus::SerializeTo(Utils::IWriteVisitor& visitor) const
 
     visitor.WriteValue(m_mode);
 
-    visitor.WriteContainer(m_WRAM);
-    visitor.WriteValue(m_currentWRAMBank);
+    visitor.WriteContainer(m_memory->workRAM);
+    visitor.WriteValue(m_registers.currentWRAMBank);
     visitor.WriteValue(m_nbCycles);
-    visitor.WriteValue(m_nbCyclesForSeconds);
+    visitor.WriteValue(GetEmulatedTime());
 
-    visitor.WriteContainer(m_HRAM);
-    visitor.WriteValue(m_IE.flag);
-    visitor.WriteValue(m_IF.flag);
+    visitor.WriteContainer(m_memory->highRAM);
+    visitor.WriteValue(m_registers.IE.flag);
+    visitor.WriteValue(m_registers.IF.flag);
 
     m_timer.SerializeTo(visitor);
 
     visitor.WriteValue(m_isInDMA);
     visitor.WriteValue(m_currentDMAAddress);
 
+    // Cycles before the CPU resumes, counting the cycle where it does
+    uint16_t nbRemainingCyclesForChangingSpeed = 0x0000;
+    if (m_scheduler.IsScheduled(SchedulerEvent::SpeedSwitchDone))
+        nbRemainingCyclesForChangingSpeed =
+            (uint16_t)(m_scheduler.GetEventCycle(SchedulerEvent::SpeedSwitchDone) - m_nbCycles);
+
     visitor.WriteValue(m_isPreparingForChangingSpeed);
-    visitor.WriteValue(m_nbRemainingCyclesForChangingSpeed);
+    visitor.WriteValue(nbRemainingCyclesForChangingSpeed);
     visitor.WriteValue(m_isDoubleSpeedMode);
 
     visitor.WriteValue(m_DMASourceAddrGBC);
@@ -505,6 +871,17 @@ void Bus::SerializeTo(Utils::IWriteVisitor& visitor) const
     visitor.WriteValue(m_DMAHBlankWasHandled);
 }
 
+void Bus::RestoreMemory(const MemoryArena& memory)
+{
+    *m_memory = memory;
+
+    // Nothing went through the handlers, update everything depending on the memory and the registers
+    m_cpu.OnInterruptFlagsChanged();
+    m_cpu.FlushDecodeCache();
+    m_ppu.OnMemoryRestored();
+    UpdateMemoryMap();
+}
+
 void Bus::DeserializeFrom(Utils::IReadVisitor& visitor)
 {
     // If we have no cartridge, nothing to do
@@ -518,22 +895,25 @@ void Bus::DeserializeFrom(Utils::IReadVisitor& visitor)
 
     visitor.ReadValue(m_mode);
 
-    visitor.ReadContainer(m_WRAM);
-    visitor.ReadValue(m_currentWRAMBank);
+    visitor.ReadContainer(m_memory->workRAM);
+    visitor.ReadValue(m_registers.currentWRAMBank);
     visitor.ReadValue(m_nbCycles);
-    visitor.ReadValue(m_nbCyclesForSeconds);
+    visitor.ReadValue(m_emulatedTime);
+    m_emulatedTimeCycle = m_nbCycles;
 
-    visitor.ReadContainer(m_HRAM);
-    visitor.ReadValue(m_IE.flag);
-    visitor.ReadValue(m_IF.flag);
+    visitor.ReadContainer(m_memory->highRAM);
+    visitor.ReadValue(m_registers.IE.flag);
+    visitor.ReadValue(m_registers.IF.flag);
+    m_cpu.OnInterruptFlagsChanged();
 
     m_timer.DeserializeFrom(visitor);
 
     visitor.ReadValue(m_isInDMA);
     visitor.ReadValue(m_currentDMAAddress);
 
+    uint16_t nbRemainingCyclesForChangingSpeed = 0x0000;
     visitor.ReadValue(m_isPreparingForChangingSpeed);
-    visitor.ReadValue(m_nbRemainingCyclesForChangingSpeed);
+    visitor.ReadValue(nbRemainingCyclesForChangingSpeed);
     visitor.ReadValue(m_isDoubleSpeedMode);
 
     visitor.ReadValue(m_DMASourceAddrGBC);
@@ -542,6 +922,20 @@ void Bus::DeserializeFrom(Utils::IReadVisitor& visitor)
     visitor.ReadValue(m_isDMAHBlankModeGBC);
     visitor.ReadValue(m_DMAWasStoppedGBC);
     visitor.ReadValue(m_DMAHBlankWasHandled);
+
+    m_scheduler.Clear();
+    m_timer.ScheduleOverflow();
+    if (m_controller)
+        m_controller->ScheduleInput();
+    if (nbRemainingCyclesForChangingSpeed > 0)
+        m_scheduler.Schedule(SchedulerEvent::SpeedSwitchDone, m_nbCycles + nbRemainingCyclesForChangingSpeed);
+
+    // Clock registers were saved up to date
+    m_cartridge->ResetRTCTimeBase();
+
+    InstallIORegisters();
+    UpdateMemoryMap();
+    UpdateClockFunction();
 }
 
 void Bus::Reset()
@@ -556,24 +950,27 @@ void Bus::Reset()
     // We set all the RAM to 0 but it could be nice to
     // fill it with random values, as it often appears to be the case when
     // you boot a Gameboy
-    std::fill(m_WRAM.begin(), m_WRAM.end(), 0x00);
-    m_HRAM.fill(0x00);
+    m_memory->workRAM.fill(0x00);
+    m_memory->highRAM.fill(0x00);
 
     // By default, we point on the second WRAM bank (won't move in GB mode)
     // Each WRAM bank is 4kB in size and two banks can be "mapped" at the same time.
     // The first one (always) and another one (switchable in GBC mode, fixed to second bank in GB mode)
-    m_currentWRAMBank = 1;
+    m_registers.currentWRAMBank = 1;
 
-    m_IE.flag = 0x00;
-    m_IF.flag = 0x00;
+    m_registers.IE.flag = 0x00;
+    m_registers.IF.flag = 0x00;
+    m_cpu.OnInterruptFlagsChanged();
 
     if (m_controller)
     {
         m_controller->Reset();
     }
 
+    m_emulatedTime = GetEmulatedTime();
+    m_emulatedTimeCycle = 0;
     m_nbCycles = 0;
-    m_nbCyclesForSeconds = 0;
+    m_scheduler.Clear();
 
     m_timer.Reset();
 
@@ -589,6 +986,10 @@ void Bus::Reset()
     m_isDMAHBlankModeGBC = false;
     m_DMAWasStoppedGBC = false;
     m_DMAHBlankWasHandled = false;
+
+    InstallIORegisters();
+    UpdateMemoryMap();
+    UpdateClockFunction();
 }
 
 void Bus::ChangeMode(Mode newMode)
@@ -597,12 +998,28 @@ void Bus::ChangeMode(Mode newMode)
         return;
 
     m_mode = newMode;
+    InstallIORegisters();
+    UpdateClockFunction();
 
     // No need to reset if we have no game loaded.
     if (m_cartridge)
         Reset();
 }
 
+void Bus::SetRTCMode(RTCMode mode)
+{
+    m_rtcMode = mode;
+    if (m_cartridge)
+        m_cartridge->SetRTCSource(this, m_rtcMode);
+}
+
+void Bus::DetachCartridge()
+{
+    // The cartridge can outlive the bus, or be inserted in another one since
+    if (m_cartridge && m_cartridge->GetRTCSource() == this)
+        m_cartridge->SetRTCSource(nullptr, m_rtcMode);
+}
+
 bool Bus::IsGBModeAvailable() const
 {
     // Return true if we have no cartridge to allow the user to change it
@@ -622,7 +1039,12 @@ void Bus::InsertCartridge(const std::shared_ptr<Cartridge>& cartridge)
     if (!cartridge)
         return;
 
+    DetachCartridge();
     m_cartridge = cartridge;
+    m_cartridge->SetRTCSource(this, m_rtcMode);
+
+    // GameShark codes are for the previous game. Game Genie patches stay with their cartridge.
+    m_gameSharkCodes.clear();
 
     // If the game supports both modes, let it. Otherwise, set it to the supported mode.
     if (!IsGBModeAvailable())
@@ -642,11 +1064,66 @@ void Bus::InsertCartridge(const std::shared_ptr<Cartridge>& cartridge)
 void Bus::ConnectController(const std::shared_ptr<Controller>& controller)
 {
     m_controller = controller;
+    m_controller->ConnectBus(this);
     m_controller->Reset();
 }
 
+bool Bus::AddCheat(const std::string& code)
+{
+    GameSharkCode gameSharkCode;
+    if (ParseGameSharkCode(code, gameSharkCode))
+    {
+        m_gameSharkCodes.push_back(gameSharkCode);
+        return true;
+    }
+
+    GameGenieCode gameGenieCode;
+    if (!m_cartridge || !ParseGameGenieCode(code, gameGenieCode))
+        return false;
+
+    m_cartridge->PatchROM(gameGenieCode.address, gameGenieCode.data, gameGenieCode.hasCompare,
+                          gameGenieCode.compare);
+    // Instructions already decoded from the ROM are not valid anymore
+    UpdateCartridgePages();
+    m_cpu.FlushDecodeCache();
+    return true;
+}
+
+void Bus::ClearCheats()
+{
+    m_gameSharkCodes.clear();
+
+    if (m_cartridge)
+    {
+        m_cartridge->ClearROMPatches();
+        UpdateCartridgePages();
+        m_cpu.FlushDecodeCache();
+    }
+}
+
+void Bus::ApplyGameSharkCodes()
+{
+    for (const GameSharkCode& code : m_gameSharkCodes)
+    {
+        // Write in a given WRAM bank, whatever the one currently mapped
+        const bool isWRAMBankCode = (code.type & 0xF8) == 0x90;
+        if (isWRAMBankCode && m_mode == Mode::GBC && code.address >= 0xD000 && code.address < 0xE000)
+        {
+            const uint8_t bank = std::max<uint8_t>(code.type & 0x07, 1);
+            const uint16_t wramIndex = bank * 0x1000 + (code.address & 0x0FFF);
+            m_memory->workRAM[wramIndex] = code.data;
+            m_cpu.OnRAMWrite(wramIndex);
+        }
+        else
+        {
+            WriteByte(code.address, code.data);
+        }
+    }
+}
+
 void Bus::SetRunToAddress(uint16_t address)
 {
     m_runToAddress = address;
     m_isInBreakMode = false;
+    UpdateClockFunction();
 }
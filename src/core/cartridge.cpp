@@ -107,33 +107,49 @@ Cartridge::Cartridge(Utils::IReadVisitor& visitor)
 
 Cartridge::~Cartridge() { delete m_mapper; }
 
-void Cartridge::SerializeRam(Utils::IWriteVisitor& visitor) const 
-{ 
+void Cartridge::SerializeRamState(Utils::IWriteVisitor& visitor) const
+{
     visitor.WriteContainer(m_externalRAM);
 
     if (m_mapper)
         m_mapper->SerializeRam(visitor);
 }
 
+void Cartridge::SerializeRam(Utils::IWriteVisitor& visitor) const
+{
+    SerializeRamState(visitor);
+
+    if (m_mapper)
+        m_mapper->SerializeRTCTime(visitor);
+}
+
 void Cartridge::SerializeTo(Utils::IWriteVisitor& visitor) const
 {
-    SerializeRam(visitor);
+    SerializeRamState(visitor);
 
     if (m_mapper)
         m_mapper->SerializeTo(visitor);
 }
 
-void Cartridge::DeserializeRam(Utils::IReadVisitor& visitor)
-{ 
+void Cartridge::DeserializeRamState(Utils::IReadVisitor& visitor)
+{
     visitor.ReadContainer(m_externalRAM);
 
     if (m_mapper)
         m_mapper->DeserializeRam(visitor);
 }
 
+void Cartridge::DeserializeRam(Utils::IReadVisitor& visitor)
+{
+    DeserializeRamState(visitor);
+
+    if (m_mapper)
+        m_mapper->DeserializeRTCTime(visitor);
+}
+
 void Cartridge::DeserializeFrom(Utils::IReadVisitor& visitor)
 {
-    DeserializeRam(visitor);
+    DeserializeRamState(visitor);
 
     if (m_mapper)
         m_mapper->DeserializeFrom(visitor);
@@ -148,10 +164,84 @@ void Cartridge::Reset()
         m_mapper->Reset();
 }
 
-void Cartridge::TickSecond()
+void Cartridge::SetRTCSource(const IEmulatedTimeSource* emulatedTimeSource, RTCMode mode)
+{
+    if (m_mapper)
+        m_mapper->SetRTCSource(emulatedTimeSource, mode);
+}
+
+const GBEmulator::IEmulatedTimeSource* Cartridge::GetRTCSource() const
+{
+    return m_mapper ? m_mapper->GetRTCSource() : nullptr;
+}
+
+void Cartridge::ResetRTCTimeBase()
 {
     if (m_mapper)
-        m_mapper->TickSecond();
+        m_mapper->ResetRTCTimeBase();
+}
+
+uint16_t Cartridge::GetROMBank(uint16_t addr) const
+{
+    if (m_mapper == nullptr)
+        return 0;
+
+    return (addr & 0x4000) ? m_mapper->GetSecondROMBank() : m_mapper->GetFirstROMBank();
+}
+
+const uint8_t* Cartridge::GetROMPage(uint16_t addr) const
+{
+    if (m_mapper == nullptr || addr >= 0x8000 || m_mapper->HasCustomReadWrite(addr))
+        return nullptr;
+
+    const size_t index = (size_t)GetROMBank(addr) * 0x4000 + (addr & 0x3F00);
+    if (index >= m_prgData.size())
+        return nullptr;
+
+    if (!m_patchedROMPages.empty())
+    {
+        auto it = m_patchedROMPages.find(index >> 8);
+        if (it != m_patchedROMPages.end())
+            return it->second.data();
+    }
+
+    return &m_prgData[index];
+}
+
+void Cartridge::PatchROM(uint16_t addr, uint8_t data, bool hasCompare, uint8_t compare)
+{
+    const size_t nbBanks = m_prgData.size() / 0x4000;
+    const size_t firstBank = addr < 0x4000 ? 0 : 1;
+    const size_t lastBank = addr < 0x4000 ? 0 : nbBanks - 1;
+    for (size_t bank = firstBank; bank <= lastBank; ++bank)
+    {
+        const size_t index = bank * 0x4000 + (addr & 0x3FFF);
+        if (hasCompare && m_prgData[index] != compare)
+            continue;
+
+        // Copy the page on the first patch
+        auto it = m_patchedROMPages.find(index >> 8);
+        if (it == m_patchedROMPages.end())
+        {
+            it = m_patchedROMPages.emplace(index >> 8, std::array<uint8_t, 0x100>()).first;
+            std::copy_n(&m_prgData[index & ~(size_t)0xFF], 0x100, it->second.begin());
+        }
+
+        it->second[index & 0xFF] = data;
+    }
+}
+
+void Cartridge::ClearROMPatches() { m_patchedROMPages.clear(); }
+
+uint8_t* Cartridge::GetRAMPage(uint16_t addr)
+{
+    // Smaller RAM is mirrored, keep it in ReadByte/WriteByte
+    if (m_mapper == nullptr || addr < 0xA000 || addr >= 0xC000 || !m_mapper->HasPlainRAM() ||
+        m_externalRAM.size() < 0x2000)
+        return nullptr;
+
+    const size_t index = (size_t)m_mapper->GetRAMBank() * 0x2000 + (addr & 0x1F00);
+    return index < m_externalRAM.size() ? &m_externalRAM[index] : nullptr;
 }
 
 bool Cartridge::ReadByte(uint16_t addr, uint8_t& data, bool /*readOnly*/)
@@ -173,7 +263,14 @@ bool Cartridge::ReadByte(uint16_t addr, uint8_t& data, bool /*readOnly*/)
         // between 0x4000 and 0x7FFF it is the switchable one.
         uint32_t prgDataBank = (addr & 0x4000) ? m_mapper->GetSecondROMBank() : m_mapper->GetFirstROMBank();
         // ROM Banks are 16kB in size.
-        data = m_prgData[prgDataBank * 0x4000 + (addr & 0x3FFF)];
+        const size_t index = prgDataBank * 0x4000 + (addr & 0x3FFF);
+        data = m_prgData[index];
+        if (!m_patchedROMPages.empty())
+        {
+            auto it = m_patchedROMPages.find(index >> 8);
+            if (it != m_patchedROMPages.end())
+                data = it->second[index & 0xFF];
+        }
         return true;
     }
     // RAM zone
@@ -0,0 +1,63 @@
+#include <core/cheats.h>
+#include <vector>
+
+namespace
+{
+// Hexadecimal digits of the code, false if there is any other character
+bool GetDigits(const std::string& code, std::vector<uint8_t>& outDigits)
+{
+    outDigits.clear();
+    for (char c : code)
+    {
+        if (c >= '0' && c <= '9')
+            outDigits.push_back((uint8_t)(c - '0'));
+        else if (c >= 'A' && c <= 'F')
+            outDigits.push_back((uint8_t)(c - 'A' + 10));
+        else if (c >= 'a' && c <= 'f')
+            outDigits.push_back((uint8_t)(c - 'a' + 10));
+        else if (c != '-' && c != ' ')
+            return false;
+    }
+
+    return true;
+}
+} // namespace
+
+bool GBEmulator::ParseGameGenieCode(const std::string& code, GameGenieCode& outCode)
+{
+    std::vector<uint8_t> digits;
+    if (!GetDigits(code, digits) || (digits.size() != 6 && digits.size() != 9))
+        return false;
+
+    // ABC-DEF-GHI: AB is the data, FCDE the address with F inverted,
+    // GI the compare value rotated left by 2 and xored with 0xBA. H is not used.
+    outCode.data = (uint8_t)((digits[0] << 4) | digits[1]);
+    outCode.address = (uint16_t)(((digits[5] ^ 0xF) << 12) | (digits[2] << 8) | (digits[3] << 4) | digits[4]);
+    if (outCode.address >= 0x8000)
+        return false;
+
+    outCode.hasCompare = digits.size() == 9;
+    if (outCode.hasCompare)
+    {
+        const uint8_t value = (uint8_t)((digits[6] << 4) | digits[8]);
+        outCode.compare = (uint8_t)(((value >> 2) | (value << 6)) ^ 0xBA);
+    }
+
+    return true;
+}
+
+bool GBEmulator::ParseGameSharkCode(const std::string& code, GameSharkCode& outCode)
+{
+    std::vector<uint8_t> digits;
+    if (!GetDigits(code, digits) || digits.size() != 8)
+        return false;
+
+    outCode.type = (uint8_t)((digits[0] << 4) | digits[1]);
+    outCode.data = (uint8_t)((digits[2] << 4) | digits[3]);
+    outCode.address = (uint16_t)((digits[6] << 12) | (digits[7] << 8) | (digits[4] << 4) | digits[5]);
+
+    // Only RAM: written every frame, anything else could have side effects (mapper, IO registers)
+    const bool isExternalOrWorkRAM = outCode.address >= 0xA000 && outCode.address < 0xE000;
+    const bool isHRAM = outCode.address >= 0xFF80 && outCode.address < 0xFFFF;
+    return isExternalOrWorkRAM || isHRAM;
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <core/bus.h>
 #include <core/controller.h>
 
 using GBEmulator::Controller;
@@ -39,22 +41,76 @@ uint8_t Controller::ReadData() const
 }
 
 
-bool Controller::HasChangedFromHighToLow() const
+Controller::ButtonsStatus& Controller::GetNextStatus()
 {
-    if (m_buttonSelection != ButtonSelection::ActionSelection && m_buttonSelection != ButtonSelection::DirectionSelection)
+    if (m_bus == nullptr)
+        return m_buttonsStatus;
+
+    const size_t cycle = m_bus->GetNbCycles();
+    if (!HasQueuedInputs() || m_queuedInputs.back().cycle != cycle)
+        QueueInput(cycle, HasQueuedInputs() ? m_queuedInputs.back().status.reg : m_buttonsStatus.reg);
+
+    return m_queuedInputs.back().status;
+}
+
+void Controller::QueueInput(size_t cycle, uint8_t buttons)
+{
+    ButtonsStatus status;
+    status.reg = buttons;
+
+    // Drop the applied changes rather than growing
+    if (m_queuedInputs.size() == m_queuedInputs.capacity() && m_firstQueuedInput > 0)
+    {
+        m_queuedInputs.erase(m_queuedInputs.begin(), m_queuedInputs.begin() + m_firstQueuedInput);
+        m_firstQueuedInput = 0;
+    }
+
+    m_queuedInputs.push_back({cycle, status});
+    ScheduleInput();
+}
+
+bool Controller::ApplyInputs(size_t cycle)
+{
+    const ButtonsStatus previousStatus = m_buttonsStatus;
+    while (HasQueuedInputs() && m_queuedInputs[m_firstQueuedInput].cycle <= cycle)
+        m_buttonsStatus = m_queuedInputs[m_firstQueuedInput++].status;
+
+    if (!HasQueuedInputs())
+    {
+        m_queuedInputs.clear();
+        m_firstQueuedInput = 0;
+    }
+
+    ScheduleInput();
+
+    if (!IsValidSelection())
         return false;
 
-    return m_buttonsStatus.reg > 0 && m_previousStatus.reg == 0;
+    return m_buttonsStatus.reg > 0 && previousStatus.reg == 0;
 }
 
-void Controller::Update()
+void Controller::ScheduleInput()
 {
-    m_previousStatus = m_buttonsStatus;
+    if (m_bus == nullptr)
+        return;
+
+    Scheduler& scheduler = m_bus->GetScheduler();
+    if (!HasQueuedInputs())
+    {
+        scheduler.Cancel(SchedulerEvent::JoypadInput);
+        return;
+    }
+
+    // Applied at the start of the cycle, so the next one at the earliest
+    const size_t cycle = std::max(m_queuedInputs[m_firstQueuedInput].cycle, m_bus->GetNbCycles() + 1);
+    scheduler.Schedule(SchedulerEvent::JoypadInput, cycle);
 }
 
 void Controller::Reset()
 {
     m_buttonSelection = ButtonSelection::None;
     m_buttonsStatus.reg = 0x00;
-    m_previousStatus.reg = 0x00;
+    m_queuedInputs.clear();
+    m_firstQueuedInput = 0;
+    ScheduleInput();
 }
\ No newline at end of file
@@ -0,0 +1,287 @@
+#include <array>
+#include <core/lineCompositor.h>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define GBEMULATOR_SIMD_SUPPORTED 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define GBEMULATOR_SIMD_SUPPORTED 0
+#endif
+
+// AVX2 functions are compiled for AVX2 without enabling it for the whole project. They are only called
+// when the CPU supports it.
+#if defined(__GNUC__) || defined(__clang__)
+#define GBEMULATOR_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define GBEMULATOR_TARGET_AVX2
+#endif
+
+using GBEmulator::CompositorImpl;
+using GBEmulator::CompositorPalette;
+using GBEmulator::LinePixels;
+
+namespace
+{
+inline uint8_t GetPaletteIndex(const LinePixels& pixels, size_t i, bool isGBC, bool bgMasterPriority)
+{
+    const bool bgPriority = isGBC ? bgMasterPriority && (pixels.bgPriority[i] | pixels.objPriority[i]) != 0
+                                  : pixels.objPriority[i] != 0;
+    const bool drawBG = pixels.objColor[i] == 0 || (bgPriority && pixels.bgColor[i] != 0);
+    return drawBG ? pixels.bgPalette[i] * 4 + pixels.bgColor[i]
+                  : (uint8_t)GBEmulator::COMPOSITOR_OBJ_OFFSET + pixels.objPalette[i] * 4 + pixels.objColor[i];
+}
+
+template <size_t BytesPerPixel>
+void ComposeScalar(const LinePixels& pixels, size_t begin, size_t end, const CompositorPalette& palette, bool isGBC,
+                   bool bgMasterPriority, uint8_t* out)
+{
+    for (size_t i = begin; i < end; ++i)
+        GBEmulator::WritePixel<BytesPerPixel>(palette[GetPaletteIndex(pixels, i, isGBC, bgMasterPriority)],
+                                              out + BytesPerPixel * i);
+}
+
+#if GBEMULATOR_SIMD_SUPPORTED
+using LineArray = std::array<uint8_t, GBEmulator::GB_INTERNAL_WIDTH>;
+
+inline __m128i LoadSSE2(const LineArray& array, size_t i)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(&array[i]));
+}
+
+GBEMULATOR_TARGET_AVX2 inline __m256i LoadAVX2(const LineArray& array, size_t i)
+{
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&array[i]));
+}
+
+// Same as GetPaletteIndex, for 16 pixels from i
+inline __m128i GetPaletteIndicesSSE2(const LinePixels& pixels, size_t i, bool isGBC, bool bgMasterPriority)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    const __m128i bgColor = LoadSSE2(pixels.bgColor, i);
+    const __m128i objColor = LoadSSE2(pixels.objColor, i);
+    const __m128i objPriority = LoadSSE2(pixels.objPriority, i);
+
+    __m128i priority = objPriority;
+    if (isGBC)
+        priority = bgMasterPriority ? _mm_or_si128(LoadSSE2(pixels.bgPriority, i), objPriority) : zero;
+
+    // drawBG = objColor == 0 || (priority != 0 && bgColor != 0)
+    const __m128i noBGPriority = _mm_or_si128(_mm_cmpeq_epi8(priority, zero), _mm_cmpeq_epi8(bgColor, zero));
+    const __m128i drawBG = _mm_or_si128(_mm_cmpeq_epi8(objColor, zero), _mm_xor_si128(noBGPriority, _mm_set1_epi8(-1)));
+
+    // palette * 4 + color, there is no 8 bits shift
+    __m128i bgIndex = LoadSSE2(pixels.bgPalette, i);
+    bgIndex = _mm_add_epi8(bgIndex, bgIndex);
+    bgIndex = _mm_add_epi8(_mm_add_epi8(bgIndex, bgIndex), bgColor);
+    __m128i objIndex = LoadSSE2(pixels.objPalette, i);
+    objIndex = _mm_add_epi8(objIndex, objIndex);
+    objIndex = _mm_add_epi8(_mm_add_epi8(objIndex, objIndex), objColor);
+    objIndex = _mm_add_epi8(objIndex, _mm_set1_epi8((char)GBEmulator::COMPOSITOR_OBJ_OFFSET));
+
+    return _mm_or_si128(_mm_and_si128(drawBG, bgIndex), _mm_andnot_si128(drawBG, objIndex));
+}
+
+template <size_t BytesPerPixel>
+void ComposeSSE2(const LinePixels& pixels, size_t begin, size_t end, const CompositorPalette& palette, bool isGBC,
+                 bool bgMasterPriority, uint8_t* out)
+{
+    // No gather in SSE2, colors are read one by one
+    alignas(16) uint8_t indices[16];
+    size_t i = begin;
+    for (; i + 16 <= end; i += 16)
+    {
+        _mm_store_si128(reinterpret_cast<__m128i*>(indices),
+                        GetPaletteIndicesSSE2(pixels, i, isGBC, bgMasterPriority));
+        for (size_t j = 0; j < 16; ++j)
+            GBEmulator::WritePixel<BytesPerPixel>(palette[indices[j]], out + BytesPerPixel * (i + j));
+    }
+
+    ComposeScalar<BytesPerPixel>(pixels, i, end, palette, isGBC, bgMasterPriority, out);
+}
+
+// Same as GetPaletteIndex, for 32 pixels from i
+GBEMULATOR_TARGET_AVX2 inline __m256i GetPaletteIndicesAVX2(const LinePixels& pixels, size_t i, bool isGBC,
+                                                            bool bgMasterPriority)
+{
+    const __m256i zero = _mm256_setzero_si256();
+
+    const __m256i bgColor = LoadAVX2(pixels.bgColor, i);
+    const __m256i objColor = LoadAVX2(pixels.objColor, i);
+    const __m256i objPriority = LoadAVX2(pixels.objPriority, i);
+
+    __m256i priority = objPriority;
+    if (isGBC)
+        priority = bgMasterPriority ? _mm256_or_si256(LoadAVX2(pixels.bgPriority, i), objPriority) : zero;
+
+    const __m256i noBGPriority = _mm256_or_si256(_mm256_cmpeq_epi8(priority, zero), _mm256_cmpeq_epi8(bgColor, zero));
+    const __m256i drawBG =
+        _mm256_or_si256(_mm256_cmpeq_epi8(objColor, zero), _mm256_xor_si256(noBGPriority, _mm256_set1_epi8(-1)));
+
+    __m256i bgIndex = LoadAVX2(pixels.bgPalette, i);
+    bgIndex = _mm256_add_epi8(bgIndex, bgIndex);
+    bgIndex = _mm256_add_epi8(_mm256_add_epi8(bgIndex, bgIndex), bgColor);
+    __m256i objIndex = LoadAVX2(pixels.objPalette, i);
+    objIndex = _mm256_add_epi8(objIndex, objIndex);
+    objIndex = _mm256_add_epi8(_mm256_add_epi8(objIndex, objIndex), objColor);
+    objIndex = _mm256_add_epi8(objIndex, _mm256_set1_epi8((char)GBEmulator::COMPOSITOR_OBJ_OFFSET));
+
+    return _mm256_blendv_epi8(objIndex, bgIndex, drawBG);
+}
+
+// Shuffle keeping the first BytesPerPixel bytes of each 32 bits color, 4 colors per 128 bits lane
+template <size_t BytesPerPixel>
+constexpr std::array<int8_t, 32> MakePackMask()
+{
+    std::array<int8_t, 32> mask{};
+    for (size_t i = 0; i < mask.size(); ++i)
+        mask[i] = -1;
+
+    for (size_t lane = 0; lane < 2; ++lane)
+    {
+        for (size_t color = 0; color < 4; ++color)
+        {
+            for (size_t byte = 0; byte < BytesPerPixel; ++byte)
+                mask[lane * 16 + color * BytesPerPixel + byte] = (int8_t)(color * 4 + byte);
+        }
+    }
+
+    return mask;
+}
+
+template <size_t BytesPerPixel>
+GBEMULATOR_TARGET_AVX2 void ComposeAVX2(const LinePixels& pixels, size_t begin, size_t end,
+                                        const CompositorPalette& palette, bool isGBC, bool bgMasterPriority,
+                                        uint8_t* out)
+{
+    static constexpr std::array<int8_t, 32> PACK_MASK = MakePackMask<BytesPerPixel>();
+    constexpr size_t LANE_SIZE = 4 * BytesPerPixel;
+    const __m256i pack = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(PACK_MASK.data()));
+    const int* colors = reinterpret_cast<const int*>(palette.data());
+
+    alignas(32) uint8_t indices[32];
+    alignas(32) uint8_t packed[32];
+    size_t i = begin;
+    for (; i + 32 <= end; i += 32)
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(indices),
+                           GetPaletteIndicesAVX2(pixels, i, isGBC, bgMasterPriority));
+
+        // 8 colors at a time
+        for (size_t j = 0; j < 32; j += 8)
+        {
+            const __m256i colorIndices =
+                _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&indices[j])));
+            const __m256i colors8 = _mm256_i32gather_epi32(colors, colorIndices, 4);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(packed), _mm256_shuffle_epi8(colors8, pack));
+
+            uint8_t* dst = out + BytesPerPixel * (i + j);
+            std::memcpy(dst, packed, LANE_SIZE);
+            std::memcpy(dst + LANE_SIZE, packed + 16, LANE_SIZE);
+        }
+    }
+
+    ComposeSSE2<BytesPerPixel>(pixels, i, end, palette, isGBC, bgMasterPriority, out);
+}
+
+bool IsAVX2Supported()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    // The OS must also save the AVX registers
+    __cpuid(info, 1);
+    const bool hasOSXSave = (info[2] & (1 << 27)) != 0;
+    const bool hasAVX = (info[2] & (1 << 28)) != 0;
+    if (!hasOSXSave || !hasAVX || (_xgetbv(0) & 0x06) != 0x06)
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+} // namespace
+
+bool GBEmulator::IsCompositorImplSupported(CompositorImpl impl)
+{
+    switch (impl)
+    {
+#if GBEMULATOR_SIMD_SUPPORTED
+    case CompositorImpl::SSE2:
+        return true;
+    case CompositorImpl::AVX2:
+    {
+        static const bool isAVX2Supported = IsAVX2Supported();
+        return isAVX2Supported;
+    }
+#endif
+    case CompositorImpl::Scalar:
+        return true;
+    default:
+        return false;
+    }
+}
+
+CompositorImpl GBEmulator::GetBestCompositorImpl()
+{
+    for (CompositorImpl impl : {CompositorImpl::AVX2, CompositorImpl::SSE2})
+    {
+        if (IsCompositorImplSupported(impl))
+            return impl;
+    }
+
+    return CompositorImpl::Scalar;
+}
+
+namespace
+{
+template <size_t BytesPerPixel>
+void Compose(const LinePixels& pixels, size_t begin, size_t end, const CompositorPalette& palette, bool isGBC,
+             bool bgMasterPriority, uint8_t* out, CompositorImpl impl)
+{
+    switch (impl)
+    {
+#if GBEMULATOR_SIMD_SUPPORTED
+    case CompositorImpl::AVX2:
+        ComposeAVX2<BytesPerPixel>(pixels, begin, end, palette, isGBC, bgMasterPriority, out);
+        break;
+    case CompositorImpl::SSE2:
+        ComposeSSE2<BytesPerPixel>(pixels, begin, end, palette, isGBC, bgMasterPriority, out);
+        break;
+#endif
+    default:
+        ComposeScalar<BytesPerPixel>(pixels, begin, end, palette, isGBC, bgMasterPriority, out);
+        break;
+    }
+}
+} // namespace
+
+void GBEmulator::ComposeLine(const LinePixels& pixels, size_t begin, size_t end, const CompositorPalette& palette,
+                             bool isGBC, bool bgMasterPriority, PixelFormat format, uint8_t* out, CompositorImpl impl)
+{
+    switch (GetBytesPerPixel(format))
+    {
+    case 4:
+        Compose<4>(pixels, begin, end, palette, isGBC, bgMasterPriority, out, impl);
+        break;
+    case 3:
+        Compose<3>(pixels, begin, end, palette, isGBC, bgMasterPriority, out, impl);
+        break;
+    case 2:
+        Compose<2>(pixels, begin, end, palette, isGBC, bgMasterPriority, out, impl);
+        break;
+    default:
+        Compose<1>(pixels, begin, end, palette, isGBC, bgMasterPriority, out, impl);
+        break;
+    }
+}
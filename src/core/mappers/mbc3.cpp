@@ -1,4 +1,5 @@
 #include <cassert>
+#include <chrono>
 #include <core/mappers/mbc3.h>
 
 using GBEmulator::MBC3;
@@ -11,10 +12,27 @@ MBC3::MBC3(const Header& header)
     assert(header.nbRamBanks <= 0x04 && "There are too many ram banks, exceeding MBC3 limitation");
 }
 
+void MBC3::SerializeTo(Utils::IWriteVisitor& visitor) const
+{
+    MapperBase::SerializeTo(visitor);
+    visitor.WriteValue(m_latchedClockRegisters);
+    visitor.WriteValue(m_isLatched);
+    visitor.WriteValue(m_lastLatchData);
+}
+
+void MBC3::DeserializeFrom(Utils::IReadVisitor& visitor)
+{
+    MapperBase::DeserializeFrom(visitor);
+    visitor.ReadValue(m_latchedClockRegisters);
+    visitor.ReadValue(m_isLatched);
+    visitor.ReadValue(m_lastLatchData);
+}
+
 void MBC3::SerializeRam(Utils::IWriteVisitor& visitor) const
 {
     MapperBase::SerializeRam(visitor);
 
+    SyncClock();
     visitor.WriteValue(m_currentClockRegister);
     visitor.WriteValue(m_clockRegisters);
 }
@@ -25,12 +43,70 @@ void MBC3::DeserializeRam(Utils::IReadVisitor& visitor)
 
     visitor.ReadValue(m_currentClockRegister);
     visitor.ReadValue(m_clockRegisters);
+    m_clockBaseTime = GetTime();
+}
+
+void MBC3::SerializeRTCTime(Utils::IWriteVisitor& visitor) const
+{
+    // Clock registers were just updated
+    visitor.WriteValue(m_rtcMode);
+    visitor.WriteValue(m_clockBaseTime);
+}
+
+void MBC3::DeserializeRTCTime(Utils::IReadVisitor& visitor)
+{
+    // Old save files don't have it
+    if (visitor.Remaining() < sizeof(RTCMode) + sizeof(uint64_t))
+        return;
+
+    RTCMode mode = RTCMode::Emulated;
+    uint64_t time = 0;
+    visitor.ReadValue(mode);
+    visitor.ReadValue(time);
+
+    // Host time keeps running while the emulator is closed. The elapsed time is added on the next access.
+    if (mode == RTCMode::Host && m_rtcMode == RTCMode::Host)
+        m_clockBaseTime = time;
+}
+
+void MBC3::SetRTCSource(const IEmulatedTimeSource* emulatedTimeSource, RTCMode mode)
+{
+    // Count the time elapsed with the previous source, unless it is another emulated one:
+    // it may be already destroyed, as a cartridge can outlive the buses it was inserted in.
+    if (m_rtcMode == RTCMode::Host || emulatedTimeSource == m_emulatedTimeSource)
+        SyncClock();
+
+    m_emulatedTimeSource = emulatedTimeSource;
+    m_rtcMode = mode;
+    m_clockBaseTime = GetTime();
+}
+
+uint64_t MBC3::GetTime() const
+{
+    if (m_rtcMode == RTCMode::Host)
+    {
+        const auto now = std::chrono::system_clock::now().time_since_epoch();
+        return (uint64_t)std::chrono::duration_cast<std::chrono::seconds>(now).count();
+    }
+
+    return m_emulatedTimeSource != nullptr ? m_emulatedTimeSource->GetEmulatedSeconds() : 0;
+}
+
+void MBC3::SyncClock() const
+{
+    // Host time can go backward if the host clock changes, ignore it
+    const uint64_t time = GetTime();
+    if (time > m_clockBaseTime)
+        AdvanceClock(m_clockRegisters, time - m_clockBaseTime);
+    m_clockBaseTime = time;
 }
 
 void MBC3::Reset()
 {
     MapperBase::Reset();
     m_currentClockRegister = 0xFF;
+    m_isLatched = false;
+    m_lastLatchData = 0xFF;
 }
 
 bool MBC3::WriteByte(uint16_t addr, uint8_t data)
@@ -59,6 +135,7 @@ bool MBC3::WriteByte(uint16_t addr, uint8_t data)
         {
             m_ramBank = data & 0x03;
             // No more custom read if we map a ram bank
+            m_currentClockRegister = 0xFF;
             m_startAddrCustomRead = 0x0000;
             m_endAddrCustomRead = 0x0000;
         }
@@ -75,8 +152,14 @@ bool MBC3::WriteByte(uint16_t addr, uint8_t data)
 
     if (addr <= 0x7FFF)
     {
-        // Latch clock data
-        // TODO
+        // Latch clock data, when 0x00 then 0x01 are written
+        if (m_lastLatchData == 0x00 && data == 0x01)
+        {
+            SyncClock();
+            m_latchedClockRegisters = m_clockRegisters;
+            m_isLatched = true;
+        }
+        m_lastLatchData = data;
 
         return true;
     }
@@ -84,7 +167,8 @@ bool MBC3::WriteByte(uint16_t addr, uint8_t data)
     // If we are mapped to a clock register
     if (m_currentClockRegister != 0xFF && addr >= 0xA000 && addr < 0xC000)
     {
-        *GetClockRegister() = data;
+        SyncClock();
+        *GetClockRegister(m_clockRegisters) = data;
     }
 
     return false;
@@ -95,37 +179,44 @@ bool MBC3::ReadByte(uint16_t addr, uint8_t& data) const
     if (m_currentClockRegister == 0xFF)
         return false;
 
-    data = *GetClockRegister();
+    if (m_isLatched)
+    {
+        data = *GetClockRegister(m_latchedClockRegisters);
+        return true;
+    }
+
+    SyncClock();
+    data = *GetClockRegister(m_clockRegisters);
 
     return true;
 }
 
-void GBEmulator::MBC3::TickSecond() 
+void MBC3::TickSecond(ClockCounterRegisters& registers)
 {
-    m_clockRegisters.seconds++;
-    if (m_clockRegisters.seconds >= 60)
+    registers.seconds++;
+    if (registers.seconds >= 60)
     {
-        m_clockRegisters.seconds = 0;
-        m_clockRegisters.minutes++;
-        if (m_clockRegisters.minutes >= 60)
+        registers.seconds = 0;
+        registers.minutes++;
+        if (registers.minutes >= 60)
         {
-            m_clockRegisters.minutes = 0;
-            m_clockRegisters.hours++;
-            if (m_clockRegisters.hours >= 24)
+            registers.minutes = 0;
+            registers.hours++;
+            if (registers.hours >= 24)
             {
-                m_clockRegisters.hours = 0;
-                m_clockRegisters.lowerDayCounter++;
-                if (m_clockRegisters.lowerDayCounter == 0x00)
+                registers.hours = 0;
+                registers.lowerDayCounter++;
+                if (registers.lowerDayCounter == 0x00)
                 {
-                    m_clockRegisters.lowerDayCounter = 0;
-                    if (m_clockRegisters.extra.msbDayCounter == 0x01)
+                    registers.lowerDayCounter = 0;
+                    if (registers.extra.msbDayCounter == 0x01)
                     {
-                        m_clockRegisters.extra.msbDayCounter = 0;
-                        m_clockRegisters.extra.dayCounterCarry = 1;
+                        registers.extra.msbDayCounter = 0;
+                        registers.extra.dayCounterCarry = 1;
                     }
                     else
                     {
-                        m_clockRegisters.extra.msbDayCounter = 1;
+                        registers.extra.msbDayCounter = 1;
                     }
                 }
             }
@@ -133,7 +224,37 @@ void GBEmulator::MBC3::TickSecond()
     }
 }
 
-uint8_t* MBC3::GetClockRegister()
+void MBC3::AdvanceClock(ClockCounterRegisters& registers, uint64_t nbSeconds)
+{
+    // Registers can be written with out of range values, and then behave differently:
+    // tick them one by one until they are back in range
+    while (nbSeconds > 0 && (registers.seconds >= 60 || registers.minutes >= 60 || registers.hours >= 24))
+    {
+        TickSecond(registers);
+        nbSeconds--;
+    }
+
+    if (nbSeconds == 0)
+        return;
+
+    uint64_t days = registers.lowerDayCounter | ((uint64_t)registers.extra.msbDayCounter << 8);
+    uint64_t time = ((days * 24 + registers.hours) * 60 + registers.minutes) * 60 + registers.seconds + nbSeconds;
+
+    registers.seconds = (uint8_t)(time % 60);
+    time /= 60;
+    registers.minutes = (uint8_t)(time % 60);
+    time /= 60;
+    registers.hours = (uint8_t)(time % 24);
+    days = time / 24;
+
+    // Day counter is 9 bits, the carry stays set until it is written
+    if (days >= 0x200)
+        registers.extra.dayCounterCarry = 1;
+    registers.lowerDayCounter = (uint8_t)(days & 0xFF);
+    registers.extra.msbDayCounter = (uint8_t)((days >> 8) & 0x01);
+}
+
+uint8_t* MBC3::GetClockRegister(ClockCounterRegisters& registers) const
 {
     if (m_currentClockRegister == 0xFF)
         return nullptr;
@@ -141,15 +262,15 @@ uint8_t* MBC3::GetClockRegister()
     switch (m_currentClockRegister)
     {
     case 0:
-        return &m_clockRegisters.seconds;
+        return &registers.seconds;
     case 1:
-        return &m_clockRegisters.minutes;
+        return &registers.minutes;
     case 2:
-        return &m_clockRegisters.hours;
+        return &registers.hours;
     case 3:
-        return &m_clockRegisters.lowerDayCounter;
+        return &registers.lowerDayCounter;
     case 4:
-        return &m_clockRegisters.extra.reg;
+        return &registers.extra.reg;
     }
 
     return nullptr;
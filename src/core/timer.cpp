@@ -1,5 +1,7 @@
 #include <core/timer.h>
+#include <core/bus.h>
 #include <core/constants.h>
+#include <cstdint>
 
 using GBEmulator::Timer;
 
@@ -8,98 +10,184 @@ Timer::Timer()
     Reset();
 }
 
-uint8_t Timer::ReadByte(uint16_t addr, bool /*readOnly*/)
+void Timer::InstallIORegisters(IORegisters& registers)
 {
-    uint8_t data = 0x00;
+    registers.Install(
+        0xFF04, this,
+        [](void* timer, uint16_t) {
+            static_cast<Timer*>(timer)->Sync();
+            return static_cast<Timer*>(timer)->m_divider;
+        },
+        // Any write to the divider register resets it, with the internal counter.
+        [](void* timer, uint16_t, uint8_t) {
+            static_cast<Timer*>(timer)->Sync();
+            const bool wasCounterBitSet = static_cast<Timer*>(timer)->IsCounterBitSet();
+            static_cast<Timer*>(timer)->m_divider = 0x00;
+            static_cast<Timer*>(timer)->m_nbClocks = 0;
+            static_cast<Timer*>(timer)->OnCounterBitChanged(wasCounterBitSet);
+        });
+
+    registers.Install(
+        0xFF05, this,
+        [](void* timer, uint16_t) {
+            static_cast<Timer*>(timer)->Sync();
+            return static_cast<Timer*>(timer)->m_timerCounter;
+        },
+        [](void* timer, uint16_t, uint8_t data) {
+            static_cast<Timer*>(timer)->Sync();
+            static_cast<Timer*>(timer)->m_timerCounter = data;
+            static_cast<Timer*>(timer)->ScheduleOverflow();
+        });
+
+    // The modulo is only used on overflow, which is always synchronized
+    registers.Install(
+        0xFF06, this, [](void* timer, uint16_t) { return static_cast<Timer*>(timer)->m_timerModulo; },
+        [](void* timer, uint16_t, uint8_t data) { static_cast<Timer*>(timer)->m_timerModulo = data; });
+
+    registers.Install(
+        0xFF07, this, [](void* timer, uint16_t) { return static_cast<Timer*>(timer)->m_timerControl; },
+        [](void* timer, uint16_t, uint8_t data) {
+            static_cast<Timer*>(timer)->Sync();
+            const bool wasCounterBitSet = static_cast<Timer*>(timer)->IsCounterBitSet();
+            static_cast<Timer*>(timer)->WriteTimerControl(data);
+            static_cast<Timer*>(timer)->OnCounterBitChanged(wasCounterBitSet);
+        });
+}
 
-    switch (addr)
+bool Timer::IsCounterBitSet() const
+{
+    // TIMA is incremented when this bit of the internal counter goes from 1 to 0
+    return m_enabled && (m_nbClocks & ((m_timerControlValue + 1) >> 1)) != 0;
+}
+
+void Timer::OnCounterBitChanged(bool wasCounterBitSet)
+{
+    // Writing DIV or TAC can also make the bit fall, and increment TIMA
+    if (wasCounterBitSet && !IsCounterBitSet() && ++m_timerCounter == 0x00)
     {
-    case 0xFF04:
-        data = m_divider;
-        break;
-    case 0xFF05:
-        data = m_timerCounter;
+        // Overflow now: reload, and raise the interrupt on the next cycle. The next overflow is scheduled then.
+        m_timerCounter = m_timerModulo;
+        if (m_bus != nullptr)
+            m_bus->GetScheduler().Schedule(SchedulerEvent::TimerOverflow, m_bus->GetNbCycles() + 1);
+        return;
+    }
+
+    ScheduleOverflow();
+}
+
+void Timer::WriteTimerControl(uint8_t data)
+{
+    m_timerControl = data;
+    m_enabled = !!(m_timerControl & 0x04);
+
+    switch(m_timerControl & 0x03)
+    {
+    case 0:
+        m_timerControlValue = 1024 - 1; // CPU Clock / 1024
         break;
-    case 0xFF06:
-        data = m_timerModulo;
+    case 1:
+        m_timerControlValue = 16 - 1; // CPU Clock / 16
         break;
-    case 0xFF07:
-        data = m_timerControl;
+    case 2:
+        m_timerControlValue = 64 - 1; // CPU Clock / 64
         break;
+    case 3:
     default:
+        m_timerControlValue = 256 - 1; // CPU Clock / 256
         break;
     }
+}
+
+size_t Timer::GetNbClocksFromBus() const
+{
+    return m_bus != nullptr ? m_bus->GetNbCycles() * 4 : 0;
+}
+
+void Timer::Sync()
+{
+    const size_t nbClocks = GetNbClocksFromBus();
+    Advance(nbClocks - m_lastSyncClock);
+    m_lastSyncClock = nbClocks;
+}
 
-    return data;
+void Timer::OnOverflow()
+{
+    Sync();
+    ScheduleOverflow();
 }
 
-void Timer::WriteByte(uint16_t addr, uint8_t data)
+void Timer::ScheduleOverflow()
+{
+    if (m_bus == nullptr)
+        return;
+
+    Scheduler& scheduler = m_bus->GetScheduler();
+    if (!m_enabled)
+    {
+        scheduler.Cancel(SchedulerEvent::TimerOverflow);
+        return;
+    }
+
+    // The overflow raises the interrupt during the bus cycle of its clock
+    const size_t overflowClock = m_lastSyncClock + GetNbClocksBeforeOverflow();
+    scheduler.Schedule(SchedulerEvent::TimerOverflow, (overflowClock + 3) / 4);
+}
+
+size_t Timer::GetNbClocksBeforeOverflow() const
+{
+    if (!m_enabled)
+        return SIZE_MAX;
+
+    // The counter is incremented each time the clock counter is a multiple of the period.
+    // The clock counter wraps at a multiple of all the periods, so we don't need to care about it.
+    const size_t period = m_timerControlValue + 1;
+    const size_t nbClocksBeforeIncrement = period - (m_nbClocks & m_timerControlValue);
+    const size_t nbIncrementsBeforeOverflow = 0x100 - m_timerCounter;
+
+    return nbClocksBeforeIncrement + (nbIncrementsBeforeOverflow - 1) * period;
+}
+
+size_t Timer::GetNbClocksBeforeChange(uint16_t addr) const
 {
     switch (addr)
     {
     case 0xFF04:
-        m_divider = 0x00; // Any write to the divider register resets it.
-        break;
+        return 0x100 - (m_nbClocks & (size_t)0xFF);
     case 0xFF05:
-        m_timerCounter = data;
-        break;
-    case 0xFF06:
-        m_timerModulo = data;
-        break;
-    case 0xFF07:
-        m_timerControl = data;
-        m_enabled = !!(m_timerControl & 0x04);
-
-        switch(m_timerControl & 0x03)
-        {
-        case 0:
-            m_timerControlValue = 1024 - 1; // CPU Clock / 1024
-            break;
-        case 1:
-            m_timerControlValue = 16 - 1; // CPU Clock / 16
-            break;
-        case 2:
-            m_timerControlValue = 64 - 1; // CPU Clock / 64
-            break;
-        case 3:
-        default:
-            m_timerControlValue = 256 - 1; // CPU Clock / 256
-            break;
-        }
-
-        break;
+        return m_enabled ? (m_timerControlValue + 1) - (m_nbClocks & m_timerControlValue) : SIZE_MAX;
     default:
-        break;
+        return SIZE_MAX;
     }
 }
 
-bool Timer::Clock()
+void Timer::Advance(size_t nbClocks)
 {
-    if (++m_nbClocks == GBEmulator::CPU_SINGLE_SPEED_FREQ)
+    // The counter is reloaded with the modulo on overflow
+    size_t nbClocksBeforeOverflow = GetNbClocksBeforeOverflow();
+    while (nbClocks >= nbClocksBeforeOverflow)
     {
-        m_nbClocks = 0;
+        Count(nbClocksBeforeOverflow);
+        m_timerCounter = m_timerModulo;
+        nbClocks -= nbClocksBeforeOverflow;
+        nbClocksBeforeOverflow = GetNbClocksBeforeOverflow();
     }
 
-    // Divider is always incremented at a speed of 16384Hz => CPU Clock / 256 (double in double speed mode)
-    if ((m_nbClocks & (size_t)0xFF) == 0)
-        m_divider++;
+    Count(nbClocks);
+}
 
-    // If the timer is not enabled exit there
-    if (!m_enabled)
-        return false;
+void Timer::Count(size_t nbClocks)
+{
+    const size_t endClocks = m_nbClocks + nbClocks;
 
-    bool hasOverflow = false;
+    m_divider += (uint8_t)((endClocks >> 8) - (m_nbClocks >> 8));
 
-    if ((m_nbClocks & m_timerControlValue) == 0)
+    if (m_enabled)
     {
-        if (++m_timerCounter == 0x00) // overflow after increment
-        {
-            hasOverflow = true;
-            m_timerCounter = m_timerModulo; // reset counter to the modulo value
-        }
+        const size_t period = m_timerControlValue + 1;
+        m_timerCounter += (uint8_t)(endClocks / period - m_nbClocks / period);
     }
 
-    return hasOverflow;
+    m_nbClocks = endClocks % GBEmulator::CPU_SINGLE_SPEED_FREQ;
 }
 
 void Timer::Reset()
@@ -111,17 +199,23 @@ void Timer::Reset()
     m_enabled = false;
     m_timerControlValue = 4096; // value at 0
     m_nbClocks = 0;
+    m_lastSyncClock = GetNbClocksFromBus();
+    ScheduleOverflow();
 }
 
 void Timer::SerializeTo(Utils::IWriteVisitor& visitor) const
 {
-    visitor.WriteValue(m_divider);
-    visitor.WriteValue(m_timerCounter);
-    visitor.WriteValue(m_timerModulo);
-    visitor.WriteValue(m_timerControl);
-    visitor.WriteValue(m_timerControlValue);
-    visitor.WriteValue(m_enabled);
-    visitor.WriteValue(m_nbClocks);
+    // Registers are only up to date after a synchronization
+    Timer timer(*this);
+    timer.Advance(GetNbClocksFromBus() - m_lastSyncClock);
+
+    visitor.WriteValue(timer.m_divider);
+    visitor.WriteValue(timer.m_timerCounter);
+    visitor.WriteValue(timer.m_timerModulo);
+    visitor.WriteValue(timer.m_timerControl);
+    visitor.WriteValue(timer.m_timerControlValue);
+    visitor.WriteValue(timer.m_enabled);
+    visitor.WriteValue(timer.m_nbClocks);
 }
 
 void Timer::DeserializeFrom(Utils::IReadVisitor& visitor)
@@ -133,4 +227,5 @@ void Timer::DeserializeFrom(Utils::IReadVisitor& visitor)
     visitor.ReadValue(m_timerControlValue);
     visitor.ReadValue(m_enabled);
     visitor.ReadValue(m_nbClocks);
+    m_lastSyncClock = GetNbClocksFromBus();
 }
\ No newline at end of file
@@ -0,0 +1,1195 @@
+#include <core/bus.h>
+#include <core/z80JitCompiler.h>
+#include <core/z80Processor.h>
+#include <cstddef>
+#include <cstring>
+
+#if GBEMULATOR_JIT_SUPPORTED
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#endif
+
+using GBEmulator::Z80JitCompiler;
+
+namespace
+{
+// Size of the executable memory. When it's full, blocks are not compiled anymore
+// until the next reset.
+constexpr size_t CODE_SIZE = 2 * 1024 * 1024;
+
+// x86-64 registers
+constexpr uint8_t RAX = 0;
+constexpr uint8_t RCX = 1;
+constexpr uint8_t RDX = 2;
+constexpr uint8_t RBX = 3;
+constexpr uint8_t RBP = 5;
+constexpr uint8_t RSI = 6;
+constexpr uint8_t RDI = 7;
+constexpr uint8_t R8 = 8;
+constexpr uint8_t R9 = 9;
+constexpr uint8_t R10 = 10;
+constexpr uint8_t R11 = 11;
+
+// Arguments of the functions: CPU pointer, then the second and third arguments
+#ifdef _WIN32
+constexpr uint8_t CPU_REG = RCX;
+constexpr uint8_t ARG2_REG = RDX;
+constexpr uint8_t ARG3_REG = R8;
+#else
+constexpr uint8_t CPU_REG = RDI;
+constexpr uint8_t ARG2_REG = RSI;
+constexpr uint8_t ARG3_REG = RDX;
+#endif
+// Kept during the whole block (callee-saved): cycles left and bus pointer
+constexpr uint8_t BUDGET_REG = RBX;
+constexpr uint8_t BUS_REG = RBP;
+// Everything else is scratch: EAX and EDX for the data, R8-R11 for the memory accesses
+
+// Conditions of the jumps (jcc = 0x70 + condition)
+constexpr uint8_t CONDITION_B = 0x02;
+constexpr uint8_t CONDITION_AE = 0x03;
+constexpr uint8_t CONDITION_E = 0x04;
+constexpr uint8_t CONDITION_NE = 0x05;
+constexpr uint8_t CONDITION_A = 0x07;
+constexpr uint8_t CONDITION_ALWAYS = 0xFF;
+
+// Game Boy flags (register F)
+constexpr uint8_t FLAG_Z = 0x80;
+constexpr uint8_t FLAG_N = 0x40;
+constexpr uint8_t FLAG_H = 0x20;
+constexpr uint8_t FLAG_C = 0x10;
+constexpr uint8_t FLAG_UNUSED = 0x0F;
+
+// x86 opcodes for "op al, dl". "op al, imm8" is the same + 4
+// Indexed like the ALU operations of the Game Boy: ADD, ADC, SUB, SBC, AND, XOR, OR, CP
+constexpr uint8_t ALU_OPCODES[8] = {0x00, 0x10, 0x28, 0x18, 0x20, 0x30, 0x08, 0x38};
+
+// x86 rotation/shift operation (in the reg field of 0xD0) for the CB prefixed shifts:
+// RLC, RRC, RL, RR, SLA, SRA, SWAP (rotation by 4) and SRL
+constexpr uint8_t SHIFT_OPERATIONS[8] = {0, 1, 2, 3, 4, 7, 0, 5};
+
+// High RAM, 0xFF80-0xFFFE
+constexpr uint16_t HRAM_START = 0xFF80;
+constexpr uint16_t HRAM_SIZE = 0x7F;
+
+uint8_t* AllocateCode(size_t size)
+{
+#if !GBEMULATOR_JIT_SUPPORTED
+    (void)size;
+    return nullptr;
+#elif defined(_WIN32)
+    return static_cast<uint8_t*>(VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+#else
+    void* code = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return code == MAP_FAILED ? nullptr : static_cast<uint8_t*>(code);
+#endif
+}
+
+void FreeCode(uint8_t* code, size_t size)
+{
+#if !GBEMULATOR_JIT_SUPPORTED
+    (void)code;
+    (void)size;
+#elif defined(_WIN32)
+    VirtualFree(code, 0, MEM_RELEASE);
+#else
+    munmap(code, size);
+#endif
+}
+
+void ProtectCode(uint8_t* code, size_t size, bool executable)
+{
+#if !GBEMULATOR_JIT_SUPPORTED
+    (void)code;
+    (void)size;
+    (void)executable;
+#elif defined(_WIN32)
+    DWORD oldProtect;
+    VirtualProtect(code, size, executable ? PAGE_EXECUTE_READ : PAGE_READWRITE, &oldProtect);
+#else
+    mprotect(code, size, executable ? (PROT_READ | PROT_EXEC) : (PROT_READ | PROT_WRITE));
+#endif
+}
+} // namespace
+
+Z80JitCompiler::Z80JitCompiler(const Z80Processor& cpu)
+    : m_cpu(cpu)
+{
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(&cpu);
+    auto offset = [base](const void* member) {
+        return (int32_t)(reinterpret_cast<const uint8_t*>(member) - base);
+    };
+
+    m_offsets.A = offset(&cpu.m_AF.A);
+    m_offsets.F = offset(&cpu.m_AF.F);
+    m_offsets.AF = offset(&cpu.m_AF.AF);
+    m_offsets.PC = offset(&cpu.m_PC);
+    m_offsets.lazyFlagsOperation = offset(&cpu.m_lazyFlags.operation);
+    m_offsets.bus = offset(&cpu.m_bus);
+    m_offsets.ramCodeBitmap = offset(cpu.m_decodeCache.GetRAMCodeBitmap());
+
+    m_offsets.registers[0] = offset(&cpu.m_BC.B);
+    m_offsets.registers[1] = offset(&cpu.m_BC.C);
+    m_offsets.registers[2] = offset(&cpu.m_DE.D);
+    m_offsets.registers[3] = offset(&cpu.m_DE.E);
+    m_offsets.registers[4] = offset(&cpu.m_HL.H);
+    m_offsets.registers[5] = offset(&cpu.m_HL.L);
+    // (HL) is a memory access
+    m_offsets.registers[6] = -1;
+    m_offsets.registers[7] = m_offsets.A;
+
+    m_offsets.wordRegisters[0] = offset(&cpu.m_BC.BC);
+    m_offsets.wordRegisters[1] = offset(&cpu.m_DE.DE);
+    m_offsets.wordRegisters[2] = offset(&cpu.m_HL.HL);
+    m_offsets.wordRegisters[3] = offset(&cpu.m_SP);
+}
+
+Z80JitCompiler::~Z80JitCompiler()
+{
+    if (m_code != nullptr)
+        FreeCode(m_code, m_codeSize);
+}
+
+bool Z80JitCompiler::Allocate()
+{
+    if (m_code != nullptr)
+        return true;
+
+    m_code = AllocateCode(CODE_SIZE);
+    if (m_code == nullptr)
+        return false;
+
+    m_codeSize = CODE_SIZE;
+    m_codeUsed = 0;
+    ProtectCode(m_code, m_codeSize, true);
+    m_buffer.reserve(MAX_BLOCK_CODE_SIZE);
+
+    return true;
+}
+
+void Z80JitCompiler::Reset()
+{
+    m_codeUsed = 0;
+    m_nbCompiledInstructions = 0;
+}
+
+void Z80JitCompiler::BeginBlock()
+{
+    // The bus is connected after the CPU is built, and the arena is allocated once
+    const Bus& bus = *m_cpu.m_bus;
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(&bus);
+    m_offsets.readPages = (int32_t)(reinterpret_cast<const uint8_t*>(bus.m_readPages.data()) - base);
+    m_offsets.writePages = (int32_t)(reinterpret_cast<const uint8_t*>(bus.m_writePages.data()) - base);
+    m_highRAM = bus.m_memory->highRAM.data();
+
+    m_buffer.clear();
+    m_exits.clear();
+    m_exitJumps.clear();
+    m_nbCycles = 0;
+    m_isBlockTerminated = false;
+
+    Emit8(0x50 | BUDGET_REG); // push rbx
+    Emit8(0x50 | BUS_REG);    // push rbp
+    EmitRegisterOperation(0x89, ARG2_REG, BUDGET_REG); // mov ebx, budget
+    EmitMemoryOperation(0x8B, BUS_REG, CPU(m_offsets.bus), WIDE); // mov rbp, [bus]
+
+    // Flags are computed in F for the whole block
+    EmitMaterializeFlags();
+}
+
+bool Z80JitCompiler::CompileInstruction(uint16_t address, uint8_t firstByte, uint8_t opcode, uint16_t operand,
+                                        uint8_t length, InstructionHandler handler)
+{
+    constexpr size_t MAX_EXIT_CODE_SIZE = 32;
+    if (m_isBlockTerminated || m_exits.full() || m_exitJumps.size() + 8 > m_exitJumps.capacity() ||
+        m_buffer.size() + MAX_INSTRUCTION_CODE_SIZE + m_exits.capacity() * MAX_EXIT_CODE_SIZE > MAX_BLOCK_CODE_SIZE)
+        return false;
+
+    const size_t bufferSize = m_buffer.size();
+    const size_t nbExitJumps = m_exitJumps.size();
+
+    // The block is left before this instruction when it doesn't have enough cycles to run it
+    m_exits.push_back({address, m_nbCycles});
+    EmitRegisterOperation(0x81, 7, BUDGET_REG); // cmp ebx, cycles
+    const size_t budgetPosition = m_buffer.size();
+    Emit32(0);
+    EmitExitJump(CONDITION_B);
+
+    m_nbCyclesTaken = 0;
+    const uint8_t nbCycles = firstByte == 0xCB ? EmitCBInstruction(opcode)
+                                               : EmitInstruction(address, opcode, operand, length, handler);
+    if (nbCycles == 0)
+    {
+        m_buffer.resize(bufferSize);
+        m_exitJumps.resize(nbExitJumps);
+        m_exits.resize(m_exits.size() - 1);
+        return false;
+    }
+
+    const uint32_t nbNeededCycles = m_nbCycles + (nbCycles > m_nbCyclesTaken ? nbCycles : m_nbCyclesTaken);
+    std::memcpy(&m_buffer[budgetPosition], &nbNeededCycles, sizeof(nbNeededCycles));
+
+    m_nbCycles += nbCycles;
+    m_nextAddress = address + length;
+    return true;
+}
+
+Z80JitCompiler::NativeBlock Z80JitCompiler::EndBlock()
+{
+    const uint16_t nbInstructions = (uint16_t)m_exits.size();
+    if (m_code == nullptr || nbInstructions == 0)
+        return nullptr;
+
+    if (!m_isBlockTerminated)
+        EmitReturnToAddress(m_nextAddress, m_nbCycles, nbInstructions);
+
+    // Exits before each instruction, only for the ones that are used
+    std::array<size_t, MAX_BLOCK_LENGTH + 1> exitPositions;
+    exitPositions.fill(0);
+    for (const ExitJump& jump : m_exitJumps)
+    {
+        size_t& position = exitPositions[jump.exitIndex];
+        if (position == 0)
+        {
+            position = m_buffer.size();
+            const Exit& exit = m_exits[jump.exitIndex];
+            EmitReturnToAddress(exit.address, exit.nbCycles, jump.exitIndex);
+        }
+
+        const int32_t displacement = (int32_t)(position - (jump.position + 4));
+        std::memcpy(&m_buffer[jump.position], &displacement, sizeof(displacement));
+    }
+
+    // Align functions on 16 bytes
+    const size_t start = (m_codeUsed + 0x0F) & ~(size_t)0x0F;
+    if (start + m_buffer.size() > m_codeSize)
+        return nullptr;
+
+    ProtectCode(m_code, m_codeSize, false);
+    // Pad with int3
+    std::memset(m_code + m_codeUsed, 0xCC, start - m_codeUsed);
+    std::memcpy(m_code + start, m_buffer.data(), m_buffer.size());
+    ProtectCode(m_code, m_codeSize, true);
+
+    m_codeUsed = start + m_buffer.size();
+    m_nbCompiledInstructions += nbInstructions;
+
+    return reinterpret_cast<NativeBlock>(m_code + start);
+}
+
+void Z80JitCompiler::Emit16(uint16_t value)
+{
+    Emit8((uint8_t)(value & 0x00FF));
+    Emit8((uint8_t)(value >> 8));
+}
+
+void Z80JitCompiler::Emit32(uint32_t value)
+{
+    Emit16((uint16_t)(value & 0x0000FFFF));
+    Emit16((uint16_t)(value >> 16));
+}
+
+void Z80JitCompiler::Emit64(uint64_t value)
+{
+    Emit32((uint32_t)(value & 0xFFFFFFFF));
+    Emit32((uint32_t)(value >> 32));
+}
+
+void Z80JitCompiler::EmitOpcode(uint16_t opcode, uint8_t flags, uint8_t reg, uint8_t index, uint8_t base)
+{
+    if (flags & WORD)
+        Emit8(0x66);
+
+    // REX prefix: W for 64 bits operands, and the 4th bit of the registers
+    uint8_t rex = 0x40;
+    if (flags & WIDE)
+        rex |= 0x08;
+    if (reg & 0x08)
+        rex |= 0x04;
+    if (index != NO_INDEX && (index & 0x08))
+        rex |= 0x02;
+    if (base & 0x08)
+        rex |= 0x01;
+    if (rex != 0x40)
+        Emit8(rex);
+
+    if (opcode > 0xFF)
+        Emit8((uint8_t)(opcode >> 8));
+    Emit8((uint8_t)(opcode & 0x00FF));
+}
+
+void Z80JitCompiler::EmitMemoryOperation(uint16_t opcode, uint8_t reg, const Memory& memory, uint8_t flags)
+{
+    EmitOpcode(opcode, flags, reg, memory.index, memory.base);
+
+    // mod = 10 (disp32). A SIB byte is needed for an index, or for rsp/r12 as base.
+    if (memory.index == NO_INDEX && (memory.base & 0x07) != 0x04)
+    {
+        Emit8(0x80 | ((reg & 0x07) << 3) | (memory.base & 0x07));
+    }
+    else
+    {
+        const uint8_t index = memory.index == NO_INDEX ? 0x04 : (memory.index & 0x07);
+        Emit8(0x84 | ((reg & 0x07) << 3));
+        Emit8((memory.scale << 6) | (index << 3) | (memory.base & 0x07));
+    }
+    Emit32((uint32_t)memory.displacement);
+}
+
+void Z80JitCompiler::EmitRegisterOperation(uint16_t opcode, uint8_t reg, uint8_t rm, uint8_t flags)
+{
+    EmitOpcode(opcode, flags, reg, NO_INDEX, rm);
+    Emit8(0xC0 | ((reg & 0x07) << 3) | (rm & 0x07));
+}
+
+Z80JitCompiler::Memory Z80JitCompiler::CPU(int32_t offset) const { return {CPU_REG, offset}; }
+
+size_t Z80JitCompiler::EmitForwardJump(uint8_t condition)
+{
+    if (condition == CONDITION_ALWAYS)
+    {
+        Emit8(0xE9); // jmp rel32
+    }
+    else
+    {
+        Emit8(0x0F); // jcc rel32
+        Emit8(0x80 | condition);
+    }
+
+    const size_t position = m_buffer.size();
+    Emit32(0);
+    return position;
+}
+
+void Z80JitCompiler::PatchForwardJump(size_t position)
+{
+    const int32_t displacement = (int32_t)(m_buffer.size() - (position + 4));
+    std::memcpy(&m_buffer[position], &displacement, sizeof(displacement));
+}
+
+void Z80JitCompiler::EmitExitJump(uint8_t condition)
+{
+    const size_t position = EmitForwardJump(condition);
+    m_exitJumps.push_back({position, (uint16_t)(m_exits.size() - 1)});
+}
+
+void Z80JitCompiler::EmitReturn(uint16_t nbCycles, uint16_t nbInstructions)
+{
+    Emit8(0xB8); // mov eax, nbCycles | nbInstructions << 16
+    Emit32((uint32_t)nbCycles | ((uint32_t)nbInstructions << 16));
+    Emit8(0x58 | BUS_REG);    // pop rbp
+    Emit8(0x58 | BUDGET_REG); // pop rbx
+    Emit8(0xC3);              // ret
+}
+
+void Z80JitCompiler::EmitReturnToAddress(uint16_t address, uint16_t nbCycles, uint16_t nbInstructions)
+{
+    EmitMemoryOperation(0xC7, 0, CPU(m_offsets.PC), WORD); // mov word [PC], address
+    Emit16(address);
+    EmitReturn(nbCycles, nbInstructions);
+}
+
+void Z80JitCompiler::EmitCall(const void* function)
+{
+    // Keep the CPU pointer, and the stack aligned on 16 bytes with 32 bytes of shadow space (Win64).
+    // rbx and rbp are already pushed.
+    Emit8(0x50 | CPU_REG);                      // push cpu
+    EmitRegisterOperation(0x83, 5, 0x04, WIDE); // sub rsp, 32
+    Emit8(0x20);
+    EmitOpcode(0xB8 | RAX, WIDE, 0, NO_INDEX, RAX); // mov rax, function
+    Emit64(reinterpret_cast<uint64_t>(function));
+    EmitRegisterOperation(0xFF, 2, RAX);        // call rax
+    EmitRegisterOperation(0x83, 0, 0x04, WIDE); // add rsp, 32
+    Emit8(0x20);
+    Emit8(0x58 | CPU_REG); // pop cpu
+}
+
+void Z80JitCompiler::EmitFlags(uint8_t use, uint8_t keep, uint8_t set)
+{
+    // x86 flags in AH: SF ZF 0 AF 0 PF 1 CF
+    // Z is ZF << 1, H is AF << 1 and C is CF << 4
+    Emit8(0x9F); // lahf
+    Emit8(0x0F); // movzx edx, ah
+    Emit8(0xB6);
+    Emit8(0xD4);
+    Emit8(0x89); // mov eax, edx
+    Emit8(0xD0);
+    Emit8(0x83); // and eax, 0x01
+    Emit8(0xE0);
+    Emit8(0x01);
+    Emit8(0xC1); // shl eax, 4
+    Emit8(0xE0);
+    Emit8(0x04);
+    Emit8(0x83); // and edx, 0x50
+    Emit8(0xE2);
+    Emit8(0x50);
+    Emit8(0x01); // add edx, edx
+    Emit8(0xD2);
+    Emit8(0x09); // or edx, eax
+    Emit8(0xC2);
+    Emit8(0x81); // and edx, use
+    Emit8(0xE2);
+    Emit32(use);
+
+    EmitMemoryOperation(0x0FB6, RAX, CPU(m_offsets.F)); // movzx eax, byte [F]
+    Emit8(0x25); // and eax, keep
+    Emit32(keep);
+    Emit8(0x09); // or eax, edx
+    Emit8(0xD0);
+    if (set != 0)
+    {
+        Emit8(0x0D); // or eax, set
+        Emit32(set);
+    }
+    EmitMemoryOperation(0x88, RAX, CPU(m_offsets.F)); // mov [F], al
+}
+
+void Z80JitCompiler::EmitShiftFlags(bool zeroFlag)
+{
+    EmitRegisterOperation(0xC0, 4, RDX); // shl dl, 4
+    Emit8(0x04);
+    if (zeroFlag)
+    {
+        Emit8(0x84); // test al, al
+        Emit8(0xC0);
+        Emit8(0x75); // jnz +3
+        Emit8(0x03);
+        Emit8(0x80); // or dl, Z
+        Emit8(0xCA);
+        Emit8(FLAG_Z);
+    }
+    EmitMemoryOperation(0x80, 4, CPU(m_offsets.F)); // and byte [F], unused
+    Emit8(FLAG_UNUSED);
+    EmitMemoryOperation(0x08, RDX, CPU(m_offsets.F)); // or [F], dl
+}
+
+void Z80JitCompiler::EmitMaterializeFlags()
+{
+    static_assert((uint8_t)FlagsOperation::None == 0, "Native code expects None to be 0");
+
+    EmitMemoryOperation(0x80, 7, CPU(m_offsets.lazyFlagsOperation)); // cmp byte [lazyFlagsOperation], 0
+    Emit8(0x00);
+    const size_t skip = EmitForwardJump(CONDITION_E);
+    EmitCall(reinterpret_cast<const void*>(&Z80Processor::MaterializeFlagsFromJit));
+    PatchForwardJump(skip);
+}
+
+void Z80JitCompiler::EmitResolveAddress(bool isWrite, uint8_t nbBytes)
+{
+    static_assert(sizeof(Bus::WritePage) == 16, "Native code expects write pages of 16 bytes");
+
+    // Both bytes must be in the same page
+    if (nbBytes == 2)
+    {
+        EmitRegisterOperation(0x80, 7, R8); // cmp r8b, 0xFF
+        Emit8(0xFF);
+        EmitExitJump(CONDITION_E);
+    }
+
+    EmitRegisterOperation(0x89, R8, R9); // mov r9d, r8d
+    EmitRegisterOperation(0xC1, 5, R9);  // shr r9d, 8
+    Emit8(0x08);
+
+    Memory page = {BUS_REG, m_offsets.writePages, R9};
+    if (isWrite)
+    {
+        EmitRegisterOperation(0xC1, 4, R9); // shl r9d, 4
+        Emit8(0x04);
+        page.displacement = m_offsets.writePages + (int32_t)offsetof(Bus::WritePage, data);
+        EmitMemoryOperation(0x8B, R10, page, WIDE); // mov r10, [page.data]
+    }
+    else
+    {
+        page.displacement = m_offsets.readPages;
+        page.scale = 3;
+        EmitMemoryOperation(0x8B, R10, page, WIDE); // mov r10, [readPages + r9 * 8]
+    }
+
+    EmitRegisterOperation(0x85, R10, R10, WIDE); // test r10, r10
+    const size_t noPage = EmitForwardJump(CONDITION_E);
+
+    if (isWrite)
+    {
+        // VRAM writes must be seen by the PPU at the right dot
+        page.displacement = m_offsets.writePages + (int32_t)offsetof(Bus::WritePage, isVRAM);
+        EmitMemoryOperation(0x80, 7, page); // cmp byte [page.isVRAM], 0
+        Emit8(0x00);
+        EmitExitJump(CONDITION_NE);
+
+        page.displacement = m_offsets.writePages + (int32_t)offsetof(Bus::WritePage, ramIndex);
+        EmitMemoryOperation(0x0FB7, R11, page); // movzx r11d, word [page.ramIndex]
+    }
+
+    EmitRegisterOperation(0x0FB6, R9, R8); // movzx r9d, r8b
+    // No RAM index is 0xFFFF, it stays the same
+    if (isWrite)
+        EmitRegisterOperation(0x09, R9, R11); // or r11d, r9d
+    EmitRegisterOperation(0x01, R9, R10, WIDE); // add r10, r9
+    const size_t end = EmitForwardJump(CONDITION_ALWAYS);
+
+    // High RAM
+    PatchForwardJump(noPage);
+    EmitRegisterOperation(0x89, R8, R9); // mov r9d, r8d
+    EmitRegisterOperation(0x81, 5, R9);  // sub r9d, HRAM_START
+    Emit32(HRAM_START);
+    EmitRegisterOperation(0x83, 7, R9); // cmp r9d, HRAM_SIZE - nbBytes
+    Emit8((uint8_t)(HRAM_SIZE - nbBytes));
+    EmitExitJump(CONDITION_A);
+
+    EmitOpcode(0xB8 | (R10 & 0x07), WIDE, 0, NO_INDEX, R10); // mov r10, highRAM
+    Emit64(reinterpret_cast<uint64_t>(m_highRAM));
+    EmitRegisterOperation(0x01, R9, R10, WIDE); // add r10, r9
+    if (isWrite)
+    {
+        EmitRegisterOperation(0x89, R9, R11); // mov r11d, r9d
+        EmitRegisterOperation(0x81, 0, R11);  // add r11d, DECODE_CACHE_HRAM_OFFSET
+        Emit32(DECODE_CACHE_HRAM_OFFSET);
+    }
+
+    PatchForwardJump(end);
+}
+
+void Z80JitCompiler::EmitWriteNotification(uint8_t nbBytes)
+{
+    EmitRegisterOperation(0x81, 7, R11); // cmp r11d, DECODE_CACHE_NO_RAM
+    Emit32(DECODE_CACHE_NO_RAM);
+    const size_t noRAM = EmitForwardJump(CONDITION_E);
+
+    // Only call the CPU if there is decoded code in those bytes
+    EmitRegisterOperation(0x89, R11, R9); // mov r9d, r11d
+    EmitRegisterOperation(0xC1, 5, R9);   // shr r9d, 3
+    Emit8(0x03);
+    EmitMemoryOperation(nbBytes == 2 ? 0x0FB7 : 0x0FB6, R9, {CPU_REG, m_offsets.ramCodeBitmap, R9}); // movzx r9d, [bitmap]
+    EmitRegisterOperation(0x89, R11, RAX); // mov eax, r11d
+    EmitRegisterOperation(0x83, 4, RAX);   // and eax, 7
+    Emit8(0x07);
+    EmitRegisterOperation(0x0FA3, RAX, R9); // bt r9d, eax
+
+    size_t isCode = 0;
+    if (nbBytes == 2)
+    {
+        isCode = EmitForwardJump(CONDITION_B);
+        EmitRegisterOperation(0xFF, 0, RAX);    // inc eax
+        EmitRegisterOperation(0x0FA3, RAX, R9); // bt r9d, eax
+    }
+    const size_t noCode = EmitForwardJump(CONDITION_AE);
+    if (nbBytes == 2)
+        PatchForwardJump(isCode);
+
+    EmitRegisterOperation(0x89, R11, ARG2_REG); // mov arg2, r11d
+    EmitOpcode(0xB8 | (ARG3_REG & 0x07), 0, 0, NO_INDEX, ARG3_REG); // mov arg3, nbBytes
+    Emit32(nbBytes);
+    EmitCall(reinterpret_cast<const void*>(&Z80Processor::OnRAMWriteFromJit));
+
+    PatchForwardJump(noCode);
+    PatchForwardJump(noRAM);
+}
+
+void Z80JitCompiler::EmitLoadAddress(int32_t wordRegisterOffset)
+{
+    EmitMemoryOperation(0x0FB7, R8, CPU(wordRegisterOffset)); // movzx r8d, word [rr]
+}
+
+void Z80JitCompiler::EmitPush()
+{
+    const int32_t SP = m_offsets.wordRegisters[3];
+
+    EmitLoadAddress(SP);
+    EmitRegisterOperation(0x83, 5, R8); // sub r8d, 2
+    Emit8(0x02);
+    EmitRegisterOperation(0x81, 4, R8); // and r8d, 0xFFFF
+    Emit32(0xFFFF);
+    EmitResolveAddress(true, 2);
+
+    // MSB at SP - 1, LSB at SP - 2
+    EmitMemoryOperation(0x89, RDX, {R10, 0}, WORD); // mov [r10], dx
+    EmitMemoryOperation(0x89, R8, CPU(SP), WORD);   // mov [SP], r8w
+    EmitWriteNotification(2);
+}
+
+void Z80JitCompiler::EmitPop()
+{
+    const int32_t SP = m_offsets.wordRegisters[3];
+
+    EmitLoadAddress(SP);
+    EmitResolveAddress(false, 2);
+    EmitMemoryOperation(0x0FB7, RDX, {R10, 0});   // movzx edx, word [r10]
+    EmitMemoryOperation(0x83, 0, CPU(SP), WORD); // add word [SP], 2
+    Emit8(0x02);
+}
+
+void Z80JitCompiler::EmitLoadOperand(uint8_t registerIndex)
+{
+    // movzx eax, byte [r]
+    if (registerIndex == 6)
+        EmitMemoryOperation(0x0FB6, RAX, {R10, 0});
+    else
+        EmitMemoryOperation(0x0FB6, RAX, CPU(m_offsets.registers[registerIndex]));
+}
+
+uint8_t Z80JitCompiler::EmitALU(uint8_t operation, bool literal, uint8_t registerIndex, uint8_t operand)
+{
+    if (!literal && registerIndex == 6)
+    {
+        EmitLoadAddress(m_offsets.wordRegisters[2]);
+        EmitResolveAddress(false, 1);
+    }
+
+    // ADC and SBC: load the carry in CF
+    if (operation == 1 || operation == 3)
+    {
+        EmitMemoryOperation(0x0FB6, RAX, CPU(m_offsets.F)); // movzx eax, byte [F]
+        Emit8(0x0F); // bt eax, 4
+        Emit8(0xBA);
+        Emit8(0xE0);
+        Emit8(0x04);
+    }
+
+    // mov doesn't touch the flags
+    if (!literal)
+    {
+        const Memory source = registerIndex == 6 ? Memory{R10, 0} : CPU(m_offsets.registers[registerIndex]);
+        EmitMemoryOperation(0x8A, RDX, source); // mov dl, [r]
+    }
+
+    EmitMemoryOperation(0x8A, RAX, CPU(m_offsets.A)); // mov al, [A]
+
+    if (literal)
+    {
+        Emit8(ALU_OPCODES[operation] + 4); // op al, imm8
+        Emit8(operand);
+    }
+    else
+    {
+        Emit8(ALU_OPCODES[operation]); // op al, dl
+        Emit8(0xD0);
+    }
+
+    // CP doesn't store the result
+    if (operation != 7)
+        EmitMemoryOperation(0x88, RAX, CPU(m_offsets.A)); // mov [A], al
+
+    switch (operation)
+    {
+    case 0: // ADD
+    case 1: // ADC
+        EmitFlags(FLAG_Z | FLAG_H | FLAG_C, FLAG_UNUSED, 0);
+        break;
+    case 2: // SUB
+    case 3: // SBC
+    case 7: // CP
+        EmitFlags(FLAG_Z | FLAG_H | FLAG_C, FLAG_UNUSED, FLAG_N);
+        break;
+    case 4: // AND
+        EmitFlags(FLAG_Z, FLAG_UNUSED, FLAG_H);
+        break;
+    default: // XOR and OR
+        EmitFlags(FLAG_Z, FLAG_UNUSED, 0);
+        break;
+    }
+
+    return (literal || registerIndex == 6) ? 2 : 1;
+}
+
+
+size_t Z80JitCompiler::EmitSkipIfConditionNotMet(uint8_t opcode)
+{
+    // Condition is in bits 3 and 4: NZ, Z, NC, C
+    const uint8_t condition = (opcode >> 3) & 0x03;
+    const uint8_t mask = (condition & 0x02) ? FLAG_C : FLAG_Z;
+    const bool jumpIfSet = (condition & 0x01) != 0;
+
+    EmitMemoryOperation(0xF6, 0, CPU(m_offsets.F)); // test byte [F], mask
+    Emit8(mask);
+    return EmitForwardJump(jumpIfSet ? CONDITION_E : CONDITION_NE);
+}
+
+uint8_t Z80JitCompiler::EmitJump(uint8_t opcode, bool isConditional, uint16_t target, uint8_t nbCyclesTaken,
+                                 uint8_t nbCyclesNotTaken)
+{
+    const size_t skip = isConditional ? EmitSkipIfConditionNotMet(opcode) : 0;
+    EmitReturnToAddress(target, m_nbCycles + nbCyclesTaken, (uint16_t)m_exits.size());
+
+    if (!isConditional)
+    {
+        m_isBlockTerminated = true;
+        return nbCyclesTaken;
+    }
+
+    PatchForwardJump(skip);
+    m_nbCyclesTaken = nbCyclesTaken;
+    return nbCyclesNotTaken;
+}
+
+uint8_t Z80JitCompiler::EmitCallInstruction(uint8_t opcode, bool isConditional, uint16_t nextAddress, uint16_t target,
+                                 uint8_t nbCyclesTaken, uint8_t nbCyclesNotTaken)
+{
+    const size_t skip = isConditional ? EmitSkipIfConditionNotMet(opcode) : 0;
+    Emit8(0xBA); // mov edx, nextAddress
+    Emit32(nextAddress);
+    EmitPush();
+    EmitReturnToAddress(target, m_nbCycles + nbCyclesTaken, (uint16_t)m_exits.size());
+
+    if (!isConditional)
+    {
+        m_isBlockTerminated = true;
+        return nbCyclesTaken;
+    }
+
+    PatchForwardJump(skip);
+    m_nbCyclesTaken = nbCyclesTaken;
+    return nbCyclesNotTaken;
+}
+
+uint8_t Z80JitCompiler::EmitInstruction(uint16_t address, uint8_t opcode, uint16_t operand, uint8_t length,
+                                        InstructionHandler handler)
+{
+    const uint16_t nextAddress = address + length;
+    const uint8_t literal = (uint8_t)(operand & 0x00FF);
+    const int32_t HL = m_offsets.wordRegisters[2];
+    const int32_t SP = m_offsets.wordRegisters[3];
+
+    // First 4 rows, by column
+    if (opcode < 0x40)
+    {
+        const int32_t wordRegister = m_offsets.wordRegisters[opcode >> 4];
+        const uint8_t registerIndex = (opcode >> 3) & 0x07;
+
+        switch (opcode & 0x0F)
+        {
+        case 0x01: // LD rr,d16
+            EmitMemoryOperation(0xC7, 0, CPU(wordRegister), WORD); // mov word [rr], d16
+            Emit16(operand);
+            return 3;
+
+        case 0x02: // LD (rr),A
+        case 0x0A: // LD A,(rr)
+        {
+            // (HL+) and (HL-) for the last two rows
+            const bool isWrite = (opcode & 0x0F) == 0x02;
+            EmitLoadAddress(opcode >= 0x20 ? HL : wordRegister);
+            EmitResolveAddress(isWrite, 1);
+            if (isWrite)
+            {
+                EmitMemoryOperation(0x0FB6, RAX, CPU(m_offsets.A)); // movzx eax, byte [A]
+                EmitMemoryOperation(0x88, RAX, {R10, 0});          // mov [r10], al
+            }
+            else
+            {
+                EmitMemoryOperation(0x0FB6, RAX, {R10, 0});        // movzx eax, byte [r10]
+                EmitMemoryOperation(0x88, RAX, CPU(m_offsets.A)); // mov [A], al
+            }
+            if (opcode >= 0x20)
+                EmitMemoryOperation(0xFF, opcode >= 0x30 ? 1 : 0, CPU(HL), WORD); // inc/dec word [HL]
+            if (isWrite)
+                EmitWriteNotification(1);
+            return 2;
+        }
+
+        case 0x03: // INC rr
+        case 0x0B: // DEC rr
+            EmitMemoryOperation(0xFF, (opcode & 0x08) ? 1 : 0, CPU(wordRegister), WORD); // inc/dec word [rr]
+            return 2;
+
+        case 0x09: // ADD HL,rr
+            // Z is untouched, H is the carry from bit 11 and C from bit 15
+            EmitMemoryOperation(0x0FB7, RAX, CPU(HL));           // movzx eax, word [HL]
+            EmitMemoryOperation(0x0FB7, RDX, CPU(wordRegister)); // movzx edx, word [rr]
+            EmitRegisterOperation(0x89, RAX, R8);                // mov r8d, eax
+            EmitRegisterOperation(0x81, 4, R8);                  // and r8d, 0xFFF
+            Emit32(0x0FFF);
+            EmitRegisterOperation(0x89, RDX, R9); // mov r9d, edx
+            EmitRegisterOperation(0x81, 4, R9);   // and r9d, 0xFFF
+            Emit32(0x0FFF);
+            EmitRegisterOperation(0x01, R9, R8); // add r8d, r9d
+            EmitRegisterOperation(0xC1, 5, R8);  // shr r8d, 7
+            Emit8(0x07);
+            EmitRegisterOperation(0x83, 4, R8); // and r8d, H
+            Emit8(FLAG_H);
+            EmitRegisterOperation(0x01, RDX, RAX);               // add eax, edx
+            EmitMemoryOperation(0x89, RAX, CPU(HL), WORD);       // mov [HL], ax
+            EmitRegisterOperation(0xC1, 5, RAX);                 // shr eax, 12
+            Emit8(0x0C);
+            EmitRegisterOperation(0x83, 4, RAX); // and eax, C
+            Emit8(FLAG_C);
+            EmitRegisterOperation(0x09, R8, RAX);                // or eax, r8d
+            EmitMemoryOperation(0x0FB6, RDX, CPU(m_offsets.F)); // movzx edx, byte [F]
+            EmitRegisterOperation(0x83, 4, RDX);                 // and edx, Z | unused
+            Emit8(FLAG_Z | FLAG_UNUSED);
+            EmitRegisterOperation(0x09, RDX, RAX);            // or eax, edx
+            EmitMemoryOperation(0x88, RAX, CPU(m_offsets.F)); // mov [F], al
+            return 2;
+
+        default:
+            break;
+        }
+
+        switch (opcode & 0x07)
+        {
+        case 0x04: // INC r
+        case 0x05: // DEC r
+        {
+            const bool isDec = (opcode & 0x07) == 0x05;
+            Memory data = CPU(m_offsets.registers[registerIndex]);
+            if (registerIndex == 6)
+            {
+                EmitLoadAddress(HL);
+                EmitResolveAddress(true, 1);
+                data = {R10, 0};
+            }
+
+            EmitMemoryOperation(0xFE, isDec ? 1 : 0, data); // inc/dec byte [r]
+            // Carry is untouched
+            EmitFlags(FLAG_Z | FLAG_H, FLAG_UNUSED | FLAG_C, isDec ? FLAG_N : 0);
+
+            if (registerIndex != 6)
+                return 1;
+
+            EmitWriteNotification(1);
+            return 3;
+        }
+
+        case 0x06: // LD r,d8
+            if (registerIndex != 6)
+            {
+                EmitMemoryOperation(0xC6, 0, CPU(m_offsets.registers[registerIndex])); // mov byte [r], d8
+                Emit8(literal);
+                return 2;
+            }
+
+            EmitLoadAddress(HL);
+            EmitResolveAddress(true, 1);
+            EmitMemoryOperation(0xC6, 0, {R10, 0}); // mov byte [r10], d8
+            Emit8(literal);
+            EmitWriteNotification(1);
+            return 3;
+
+        default:
+            break;
+        }
+
+        switch (opcode)
+        {
+        case 0x00: // NOP
+            return 1;
+
+        case 0x07: // RLCA
+        case 0x0F: // RRCA
+        case 0x17: // RLA
+        case 0x1F: // RRA
+        {
+            // Same as the CB prefixed rotations, but Z is always 0
+            const uint8_t operation = opcode >> 3;
+            EmitMemoryOperation(0x0FB6, RAX, CPU(m_offsets.A)); // movzx eax, byte [A]
+            if (operation >= 2)
+            {
+                EmitMemoryOperation(0x0FB6, RDX, CPU(m_offsets.F)); // movzx edx, byte [F]
+                EmitRegisterOperation(0x0FBA, 4, RDX);               // bt edx, 4
+                Emit8(0x04);
+            }
+            EmitRegisterOperation(0xD0, operation, RAX);        // rol/ror/rcl/rcr al, 1
+            EmitRegisterOperation(0x0F92, 0, RDX);              // setc dl
+            EmitMemoryOperation(0x88, RAX, CPU(m_offsets.A)); // mov [A], al
+            EmitShiftFlags(false);
+            return 1;
+        }
+
+        case 0x08: // LD (a16),SP
+            EmitOpcode(0xB8 | (R8 & 0x07), 0, 0, NO_INDEX, R8); // mov r8d, a16
+            Emit32(operand);
+            EmitResolveAddress(true, 2);
+            EmitMemoryOperation(0x0FB7, RDX, CPU(SP));      // movzx edx, word [SP]
+            EmitMemoryOperation(0x89, RDX, {R10, 0}, WORD); // mov [r10], dx
+            EmitWriteNotification(2);
+            return 5;
+
+        case 0x18: // JR
+        case 0x20:
+        case 0x28:
+        case 0x30:
+        case 0x38:
+            return EmitJump(opcode, opcode != 0x18, (uint16_t)(nextAddress + (int8_t)literal), 3, 2);
+
+        case 0x27: // DAA, through the interpreter
+            EmitOpcode(0xB8 | (ARG2_REG & 0x07), 0, 0, NO_INDEX, ARG2_REG); // mov arg2, opcode
+            Emit32(opcode);
+            EmitCall(reinterpret_cast<const void*>(handler));
+            EmitMaterializeFlags();
+            return 1;
+
+        case 0x2F: // CPL
+            EmitMemoryOperation(0xF6, 2, CPU(m_offsets.A)); // not byte [A]
+            EmitMemoryOperation(0x80, 1, CPU(m_offsets.F)); // or byte [F], N | H
+            Emit8(FLAG_N | FLAG_H);
+            return 1;
+
+        case 0x37: // SCF
+        case 0x3F: // CCF
+            EmitMemoryOperation(0x80, 4, CPU(m_offsets.F)); // and byte [F], ~(N | H)
+            Emit8((uint8_t)~(FLAG_N | FLAG_H));
+            EmitMemoryOperation(0x80, opcode == 0x37 ? 1 : 6, CPU(m_offsets.F)); // or/xor byte [F], C
+            Emit8(FLAG_C);
+            return 1;
+
+        default:
+            // STOP
+            return 0;
+        }
+    }
+
+    // LD r,r'
+    if (opcode < 0x80)
+    {
+        const uint8_t writeIndex = (opcode >> 3) & 0x07;
+        const uint8_t readIndex = opcode & 0x07;
+
+        // HALT
+        if (writeIndex == 6 && readIndex == 6)
+            return 0;
+
+        if (writeIndex == 6 || readIndex == 6)
+        {
+            EmitLoadAddress(HL);
+            EmitResolveAddress(writeIndex == 6, 1);
+        }
+
+        EmitLoadOperand(readIndex);
+        const Memory destination = writeIndex == 6 ? Memory{R10, 0} : CPU(m_offsets.registers[writeIndex]);
+        EmitMemoryOperation(0x88, RAX, destination); // mov [r], al
+
+        if (writeIndex == 6)
+            EmitWriteNotification(1);
+        return (writeIndex == 6 || readIndex == 6) ? 2 : 1;
+    }
+
+    // ALU A,r
+    if (opcode < 0xC0)
+        return EmitALU((opcode >> 3) & 0x07, false, opcode & 0x07, 0);
+
+    // ALU A,d8
+    if ((opcode & 0x07) == 0x06)
+        return EmitALU((opcode >> 3) & 0x07, true, 0, literal);
+
+    // RST
+    if ((opcode & 0x07) == 0x07)
+        return EmitCallInstruction(opcode, false, nextAddress, opcode & 0x38, 4, 4);
+
+    // POP and PUSH
+    if ((opcode & 0x0B) == 0x01)
+    {
+        const uint8_t index = (opcode >> 4) & 0x03;
+        const int32_t wordRegister = index == 3 ? m_offsets.AF : m_offsets.wordRegisters[index];
+        if ((opcode & 0x04) == 0)
+        {
+            EmitPop();
+            // Lowest bits of F are always 0
+            if (index == 3)
+            {
+                EmitRegisterOperation(0x81, 4, RDX); // and edx, 0xFFF0
+                Emit32(0xFFF0);
+            }
+            EmitMemoryOperation(0x89, RDX, CPU(wordRegister), WORD); // mov [rr], dx
+            return 3;
+        }
+
+        EmitMemoryOperation(0x0FB7, RDX, CPU(wordRegister)); // movzx edx, word [rr]
+        if (index == 3)
+        {
+            EmitRegisterOperation(0x81, 4, RDX); // and edx, 0xFFF0
+            Emit32(0xFFF0);
+        }
+        EmitPush();
+        return 4;
+    }
+
+    switch (opcode)
+    {
+    case 0xC0: // RET cc
+    case 0xC8:
+    case 0xD0:
+    case 0xD8:
+    case 0xC9: // RET
+    {
+        const bool isConditional = opcode != 0xC9;
+        const uint8_t nbCyclesTaken = isConditional ? 5 : 4;
+        const size_t skip = isConditional ? EmitSkipIfConditionNotMet(opcode) : 0;
+        EmitPop();
+        EmitMemoryOperation(0x89, RDX, CPU(m_offsets.PC), WORD); // mov [PC], dx
+        EmitReturn(m_nbCycles + nbCyclesTaken, (uint16_t)m_exits.size());
+
+        if (!isConditional)
+        {
+            m_isBlockTerminated = true;
+            return nbCyclesTaken;
+        }
+
+        PatchForwardJump(skip);
+        m_nbCyclesTaken = nbCyclesTaken;
+        return 2;
+    }
+
+    case 0xC2: // JP cc
+    case 0xCA:
+    case 0xD2:
+    case 0xDA:
+    case 0xC3: // JP
+        return EmitJump(opcode, opcode != 0xC3, operand, 4, 3);
+
+    case 0xC4: // CALL cc
+    case 0xCC:
+    case 0xD4:
+    case 0xDC:
+    case 0xCD: // CALL
+        return EmitCallInstruction(opcode, opcode != 0xCD, nextAddress, operand, 6, 3);
+
+    case 0xE9: // JP HL
+        EmitMemoryOperation(0x0FB7, RAX, CPU(HL));                // movzx eax, word [HL]
+        EmitMemoryOperation(0x89, RAX, CPU(m_offsets.PC), WORD); // mov [PC], ax
+        EmitReturn(m_nbCycles + 1, (uint16_t)m_exits.size());
+        m_isBlockTerminated = true;
+        return 1;
+
+    case 0xE8: // ADD SP,e8
+    case 0xF8: // LD HL,SP+e8
+        // H and C come from the addition of the low byte
+        EmitMemoryOperation(0x0FB6, RAX, CPU(SP)); // movzx eax, byte [SP]
+        Emit8(0x04);                               // add al, e8
+        Emit8(literal);
+        EmitFlags(FLAG_H | FLAG_C, FLAG_UNUSED, 0);
+        EmitMemoryOperation(0x0FB7, RAX, CPU(SP)); // movzx eax, word [SP]
+        Emit8(0x05);                               // add eax, e8
+        Emit32((uint32_t)(int32_t)(int8_t)literal);
+        EmitMemoryOperation(0x89, RAX, CPU(opcode == 0xE8 ? SP : HL), WORD); // mov [rr], ax
+        return opcode == 0xE8 ? 4 : 3;
+
+    case 0xF9: // LD SP,HL
+        EmitMemoryOperation(0x0FB7, RAX, CPU(HL));     // movzx eax, word [HL]
+        EmitMemoryOperation(0x89, RAX, CPU(SP), WORD); // mov [SP], ax
+        return 2;
+
+    case 0xE0: // LDH (a8),A
+    case 0xF0: // LDH A,(a8)
+    case 0xE2: // LD (C),A
+    case 0xF2: // LD A,(C)
+    case 0xEA: // LD (a16),A
+    case 0xFA: // LD A,(a16)
+    {
+        const bool isWrite = (opcode & 0x10) == 0;
+        if ((opcode & 0x0F) == 0x02)
+        {
+            // Only HRAM is accessed directly, the address is known at runtime
+            EmitMemoryOperation(0x0FB6, R8, CPU(m_offsets.registers[1])); // movzx r8d, byte [C]
+            EmitRegisterOperation(0x81, 1, R8);                           // or r8d, 0xFF00
+            Emit32(0xFF00);
+        }
+        else
+        {
+            // Don't compile what would always leave the block: IO registers, OAM, mapper and VRAM writes
+            const uint16_t addr = (opcode & 0x0F) == 0x00 ? (0xFF00 | literal) : operand;
+            if ((addr >= 0xFE00 && (addr < HRAM_START || addr == 0xFFFF)) || (isWrite && addr < 0xA000))
+                return 0;
+
+            EmitOpcode(0xB8 | (R8 & 0x07), 0, 0, NO_INDEX, R8); // mov r8d, addr
+            Emit32(addr);
+        }
+
+        EmitResolveAddress(isWrite, 1);
+        if (isWrite)
+        {
+            EmitMemoryOperation(0x0FB6, RAX, CPU(m_offsets.A)); // movzx eax, byte [A]
+            EmitMemoryOperation(0x88, RAX, {R10, 0});          // mov [r10], al
+            EmitWriteNotification(1);
+        }
+        else
+        {
+            EmitMemoryOperation(0x0FB6, RAX, {R10, 0});        // movzx eax, byte [r10]
+            EmitMemoryOperation(0x88, RAX, CPU(m_offsets.A)); // mov [A], al
+        }
+
+        switch (opcode & 0x0F)
+        {
+        case 0x00:
+            return 3;
+        case 0x02:
+            return 2;
+        default:
+            return 4;
+        }
+    }
+
+    default:
+        // RETI, DI, EI and invalid opcodes
+        return 0;
+    }
+}
+
+uint8_t Z80JitCompiler::EmitCBInstruction(uint8_t opcode)
+{
+    const uint8_t registerIndex = opcode & 0x07;
+    const uint8_t bit = (opcode >> 3) & 0x07;
+    const bool isBit = opcode >= 0x40 && opcode < 0x80;
+
+    Memory data = CPU(m_offsets.registers[registerIndex]);
+    if (registerIndex == 6)
+    {
+        EmitLoadAddress(m_offsets.wordRegisters[2]);
+        EmitResolveAddress(!isBit, 1);
+        data = {R10, 0};
+    }
+
+    // BIT
+    if (isBit)
+    {
+        EmitMemoryOperation(0xF6, 0, data); // test byte [r], 1 << bit
+        Emit8((uint8_t)(1 << bit));
+        // Carry is untouched
+        EmitFlags(FLAG_Z, FLAG_UNUSED | FLAG_C, FLAG_H);
+        return registerIndex == 6 ? 3 : 2;
+    }
+
+    // RES and SET, flags are untouched
+    if (opcode >= 0x80)
+    {
+        const bool isSet = opcode >= 0xC0;
+        EmitMemoryOperation(0x80, isSet ? 1 : 4, data); // or/and byte [r], mask
+        Emit8(isSet ? (uint8_t)(1 << bit) : (uint8_t)~(1 << bit));
+    }
+    // Rotations and shifts
+    else
+    {
+        EmitMemoryOperation(0x0FB6, RAX, data); // movzx eax, byte [r]
+
+        // RL and RR: load the carry in CF
+        if (bit == 2 || bit == 3)
+        {
+            EmitMemoryOperation(0x0FB6, RDX, CPU(m_offsets.F)); // movzx edx, byte [F]
+            EmitRegisterOperation(0x0FBA, 4, RDX);               // bt edx, 4
+            Emit8(0x04);
+        }
+
+        if (bit == 6)
+        {
+            // SWAP, carry is 0
+            EmitRegisterOperation(0xC0, 0, RAX); // rol al, 4
+            Emit8(0x04);
+            EmitRegisterOperation(0x31, RDX, RDX); // xor edx, edx
+        }
+        else
+        {
+            EmitRegisterOperation(0xD0, SHIFT_OPERATIONS[bit], RAX); // shift al, 1
+            EmitRegisterOperation(0x0F92, 0, RDX);                   // setc dl
+        }
+
+        EmitMemoryOperation(0x88, RAX, data); // mov [r], al
+        EmitShiftFlags(true);
+    }
+
+    if (registerIndex != 6)
+        return 2;
+
+    EmitWriteNotification(1);
+    return 4;
+}
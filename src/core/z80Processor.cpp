@@ -4,14 +4,28 @@
 #include <core/z80Processor.h>
 #include <cstdint>
 #include <sys/types.h>
+#include <utility>
 
 using GBEmulator::Z80Processor;
 
-Z80Processor::Z80Processor() { Reset(); }
+// Force the inlining of everything called by a function (when it's visible in this file)
+#if defined(__GNUC__) || defined(__clang__)
+#define Z80_FLATTEN __attribute__((flatten))
+#elif defined(_MSC_VER)
+#define Z80_FLATTEN [[msvc::flatten]]
+#else
+#define Z80_FLATTEN
+#endif
+
+Z80Processor::Z80Processor()
+    : m_jit(*this)
+{
+    Reset();
+}
 
 void Z80Processor::SerializeTo(Utils::IWriteVisitor& visitor) const
 {
-    visitor.WriteValue(m_AF.AF);
+    visitor.WriteValue(GetAFRegister().AF);
     visitor.WriteValue(m_BC.BC);
     visitor.WriteValue(m_DE.DE);
     visitor.WriteValue(m_HL.HL);
@@ -28,6 +42,7 @@ void Z80Processor::SerializeTo(Utils::IWriteVisitor& visitor) const
 void Z80Processor::DeserializeFrom(Utils::IReadVisitor& visitor)
 {
     visitor.ReadValue(m_AF.AF);
+    m_lazyFlags.operation = FlagsOperation::None;
     visitor.ReadValue(m_BC.BC);
     visitor.ReadValue(m_DE.DE);
     visitor.ReadValue(m_HL.HL);
@@ -39,11 +54,15 @@ void Z80Processor::DeserializeFrom(Utils::IReadVisitor& visitor)
     visitor.ReadValue(m_IMEScheduled);
     visitor.ReadValue(m_isPaused);
     visitor.ReadValue(m_isStopped);
+
+    // Memory has changed, previously decoded instructions can't be trusted
+    FlushDecodeCache();
 }
 
 void Z80Processor::Reset()
 {
     m_AF.AF = 0x0000;
+    m_lazyFlags.operation = FlagsOperation::None;
     m_BC.BC = 0x0000;
     m_DE.DE = 0x0000;
     m_HL.HL = 0x0000;
@@ -62,9 +81,19 @@ void Z80Processor::Reset()
     m_IMEEnabled = false;
     m_IMEScheduled = false;
     m_isPaused = false;
+    m_isInterruptPending = false;
 
     m_nbInstructionsExecuted = 0;
     m_opcodeCount.fill(0);
+
+    m_operand = 0x0000;
+    m_decodeCache.Clear();
+    m_currentBlock = nullptr;
+
+    m_loop.address = NO_LOOP;
+    m_idleLoopSkippedCycles.clear();
+    m_memoryLoopCycles.clear();
+    m_untrackedLoopCycles = 0;
 }
 
 inline uint8_t Z80Processor::ReadByte(uint16_t addr) { return m_bus->ReadByte(addr); }
@@ -86,11 +115,15 @@ bool Z80Processor::Clock()
         m_IMEEnabled = true;
     }
 
-    uint8_t interruptResult = HandleInterrupt();
-
-    if (interruptResult != 0)
+    // Interrupts only need to be handled when one is pending
+    if (m_isInterruptPending)
     {
-        m_cycles = interruptResult;
+        uint8_t interruptResult = HandleInterrupt();
+
+        if (interruptResult != 0)
+        {
+            m_cycles = interruptResult;
+        }
     }
 
     if (m_isPaused)
@@ -105,10 +138,16 @@ bool Z80Processor::Clock()
         //    std::cout << GBEmulator::Disassemble(*m_bus, m_PC, 1)[0] << std::endl;
         //}
 
-        uint8_t opcode = FetchByte();
-        m_cycles = DecodeOpcodeAndCall(opcode);
+        const DecodedInstruction& instruction = GetInstructionAtPC();
+        m_PC += instruction.length;
+        m_operand = instruction.operand;
+        m_cycles = instruction.handler(*this, instruction.opcode);
         m_nbInstructionsExecuted++;
-        m_opcodeCount[opcode]++;
+        m_opcodeCount[instruction.firstByte]++;
+
+        // Backward branch, it could be a busy-wait loop
+        if (m_PC < instruction.address && m_PC != m_loop.address)
+            DetectLoop(instruction);
     }
 
     m_cycles--;
@@ -252,13 +291,659 @@ inline uint16_t Z80Processor::PopWordFromStack()
     return (highData << 8) | lowData;
 }
 
-inline uint8_t Z80Processor::FetchByte() { return ReadByte(m_PC++); }
+void Z80Processor::EnableLazyFlags(bool value)
+{
+    MaterializeFlags();
+    m_lazyFlagsEnabled = value;
+}
+
+inline void Z80Processor::SetFlagsFromOperation(FlagsOperation operation, uint8_t left, uint8_t right, uint8_t carry,
+                                                uint8_t result)
+{
+    m_lazyFlags.operation = operation;
+    m_lazyFlags.left = left;
+    m_lazyFlags.right = right;
+    m_lazyFlags.carry = carry;
+    m_lazyFlags.result = result;
+
+    if (!m_lazyFlagsEnabled)
+        MaterializeFlags();
+}
+
+inline uint8_t Z80Processor::GetCarryFlag() const
+{
+    switch (m_lazyFlags.operation)
+    {
+    case FlagsOperation::None:
+        return m_AF.F.C;
+    case FlagsOperation::Add:
+        return (m_lazyFlags.left + m_lazyFlags.right + m_lazyFlags.carry) > 0xFF;
+    case FlagsOperation::Sub:
+        return (m_lazyFlags.right + m_lazyFlags.carry) > m_lazyFlags.left;
+    case FlagsOperation::And:
+    case FlagsOperation::Or:
+        return 0;
+    default:
+        return m_lazyFlags.carry;
+    }
+}
+
+GBEmulator::Flags Z80Processor::ComputeFlags() const
+{
+    Flags flags = m_AF.F;
+    const LazyFlags& lazy = m_lazyFlags;
+
+    if (lazy.operation == FlagsOperation::None)
+        return flags;
+
+    flags.Z = lazy.result == 0;
+    flags.C = GetCarryFlag();
+
+    switch (lazy.operation)
+    {
+    case FlagsOperation::Add:
+        flags.N = 0;
+        flags.H = ((lazy.left & 0x0F) + (lazy.right & 0x0F) + lazy.carry) > 0x0F;
+        break;
+    case FlagsOperation::Sub:
+        flags.N = 1;
+        flags.H = ((lazy.right & 0x0F) + lazy.carry) > (lazy.left & 0x0F);
+        break;
+    case FlagsOperation::Inc:
+        flags.N = 0;
+        flags.H = (lazy.left & 0x0F) == 0x0F;
+        break;
+    case FlagsOperation::Dec:
+        flags.N = 1;
+        flags.H = (lazy.left & 0x0F) == 0x00;
+        break;
+    case FlagsOperation::And:
+    case FlagsOperation::Bit:
+        flags.N = 0;
+        flags.H = 1;
+        break;
+    default: // Or and Shift
+        flags.N = 0;
+        flags.H = 0;
+        break;
+    }
+
+    return flags;
+}
+
+inline void Z80Processor::MaterializeFlags()
+{
+    if (m_lazyFlags.operation == FlagsOperation::None)
+        return;
+
+    m_AF.F = ComputeFlags();
+    m_lazyFlags.operation = FlagsOperation::None;
+}
+
+void Z80Processor::MaterializeFlagsFromJit(Z80Processor& cpu) { cpu.MaterializeFlags(); }
+
+inline uint8_t Z80Processor::FetchByte() { return (uint8_t)(m_operand & 0x00FF); }
+
+inline uint16_t Z80Processor::FetchWord() { return m_operand; }
+
+const Z80Processor::DecodedInstruction& Z80Processor::GetInstructionAtPC()
+{
+    // Most of the time, we are just executing the next instruction of the current block
+    if (m_currentBlock != nullptr && m_currentBlockEpoch == m_decodeCache.GetEpoch())
+    {
+        uint16_t nextIndex = m_currentBlockIndex + 1;
+        if (nextIndex < m_currentBlock->nbInstructions && m_currentBlockInstructions[nextIndex].address == m_PC)
+        {
+            m_currentBlockIndex = nextIndex;
+            return m_currentBlockInstructions[nextIndex];
+        }
+    }
+
+    return DecodeBlockAtPC();
+}
+
+const Z80Processor::DecodedInstruction& Z80Processor::DecodeBlockAtPC()
+{
+    // Uncached instructions can wrap around the address space
+    constexpr uint32_t NO_END_ADDRESS = 0x20000;
+
+    m_currentBlock = nullptr;
+
+    uint16_t bank = 0;
+    uint16_t ramIndex = DECODE_CACHE_NO_RAM;
+    uint32_t endAddress = 0;
+
+    // Not cacheable, decode it every time
+    if (!m_bus->GetCodeLocation(m_PC, bank, ramIndex, endAddress))
+    {
+        DecodeInstruction(m_PC, NO_END_ADDRESS, m_uncachedInstruction);
+        return m_uncachedInstruction;
+    }
+
+    const uint32_t key = InstructionCache::MakeKey(bank, m_PC);
+    InstructionCache::Block* block = m_decodeCache.Find(key);
+
+    if (block != nullptr)
+    {
+        // Self-modifying code can happen in RAM, only compile ROM blocks
+        if (m_dispatchMode == DispatchMode::Jit && block->ramPage == DECODE_CACHE_NO_RAM &&
+            ++block->nbExecutions == JIT_THRESHOLD)
+        {
+            CompileBlock(*block);
+        }
+    }
+    else
+    {
+        std::array<DecodedInstruction, MAX_BLOCK_LENGTH> instructions;
+        uint16_t nbInstructions = 0;
+        uint32_t addr = m_PC;
+
+        while (nbInstructions < MAX_BLOCK_LENGTH && DecodeInstruction(addr, endAddress, instructions[nbInstructions]))
+        {
+            const DecodedInstruction& instruction = instructions[nbInstructions++];
+            addr += instruction.length;
+
+            if (IsBlockTerminator(instruction.firstByte))
+                break;
+        }
+
+        // First instruction overlaps two memory regions, can't cache it
+        if (nbInstructions == 0)
+        {
+            DecodeInstruction(m_PC, NO_END_ADDRESS, m_uncachedInstruction);
+            return m_uncachedInstruction;
+        }
+
+        block = m_decodeCache.Insert(key, instructions.data(), nbInstructions, ramIndex, addr - m_PC);
+    }
+
+    m_currentBlock = block;
+    m_currentBlockInstructions = m_decodeCache.GetInstructions(*block);
+    m_currentBlockIndex = 0;
+    m_currentBlockEpoch = m_decodeCache.GetEpoch();
+
+    return m_currentBlockInstructions[0];
+}
+
+bool Z80Processor::DecodeInstruction(uint16_t addr, uint32_t endAddress, DecodedInstruction& instruction)
+{
+    const uint8_t opcode = ReadByte(addr);
+    const uint8_t length = m_opcodesLength[opcode];
+
+    if (addr + length > endAddress)
+        return false;
+
+    instruction.address = addr;
+    instruction.firstByte = opcode;
+    instruction.length = length;
+    instruction.opcode = opcode;
+    instruction.operand = 0x0000;
+
+    if (length > 1)
+        instruction.operand = ReadByte(addr + 1);
+    if (length > 2)
+        instruction.operand |= (uint16_t)ReadByte(addr + 2) << 8;
+
+    const bool specialized = m_dispatchMode != DispatchMode::Generic;
+
+    // Resolve CB prefixed instructions directly
+    if (opcode == 0xCB)
+    {
+        instruction.opcode = (uint8_t)instruction.operand;
+        instruction.handler = specialized ? m_specializedCBHandlers[instruction.opcode] : &ExecuteGenericCB;
+    }
+    else
+    {
+        instruction.handler = specialized ? m_specializedHandlers[opcode] : &ExecuteGeneric;
+    }
+
+    return true;
+}
+
+void Z80Processor::CompileBlock(const InstructionCache::Block& block)
+{
+    // All the instructions that could use native code were dropped with the flush
+    if (m_jitNbFlushes != m_decodeCache.GetNbFlushes())
+    {
+        m_jit.Reset();
+        m_jitNbFlushes = m_decodeCache.GetNbFlushes();
+    }
+
+    DecodedInstruction* instructions = m_decodeCache.GetInstructions(block);
+
+    m_jit.BeginCompilation();
+    for (uint16_t i = 0; i < block.nbInstructions; ++i)
+    {
+        DecodedInstruction& instruction = instructions[i];
 
-inline uint16_t Z80Processor::FetchWord()
+        // CB prefixed instructions are not compiled
+        if (instruction.firstByte == 0xCB)
+            continue;
+
+        Z80JitCompiler::NativeHandler handler = m_jit.Compile(instruction.opcode, instruction.operand);
+        if (handler != nullptr)
+            instruction.handler = handler;
+    }
+    m_jit.EndCompilation();
+}
+
+void Z80Processor::SetDispatchMode(DispatchMode mode)
 {
-    uint16_t lsb = (uint16_t)FetchByte();
-    uint16_t msb = (uint16_t)FetchByte();
-    return (msb << 8) | lsb;
+    if (mode == m_dispatchMode)
+        return;
+
+    // Already decoded instructions point to the handlers of the previous mode
+    m_dispatchMode = mode;
+    FlushDecodeCache();
+}
+
+void Z80Processor::FlushDecodeCache()
+{
+    m_decodeCache.Clear();
+    m_currentBlock = nullptr;
+    m_loop.address = NO_LOOP;
+}
+
+void Z80Processor::DetectLoop(const DecodedInstruction& branch)
+{
+    // Only conditional branches can loop until something changes
+    switch (branch.firstByte)
+    {
+    case 0x20: // JR NZ
+    case 0x28: // JR Z
+    case 0x30: // JR NC
+    case 0x38: // JR C
+    case 0xC2: // JP NZ
+    case 0xCA: // JP Z
+    case 0xD2: // JP NC
+    case 0xDA: // JP C
+        break;
+    default:
+        return;
+    }
+
+    m_loop.address = m_PC;
+    m_loop.kind = LoopKind::None;
+
+    // Only loops in ROM, the code can't change without a memory map change
+    uint16_t bank = 0;
+    uint16_t ramIndex = DECODE_CACHE_NO_RAM;
+    uint32_t endAddress = 0;
+    if (!m_bus->GetCodeLocation(m_PC, bank, ramIndex, endAddress) || ramIndex != DECODE_CACHE_NO_RAM)
+        return;
+
+    uint8_t nbInstructions = 0;
+    uint32_t addr = m_PC;
+    while (addr < branch.address)
+    {
+        if (nbInstructions == MAX_LOOP_LENGTH - 1 ||
+            !DecodeInstruction((uint16_t)addr, endAddress, m_loop.instructions[nbInstructions]))
+            return;
+
+        addr += m_loop.instructions[nbInstructions++].length;
+    }
+
+    if (addr != branch.address || nbInstructions < 1)
+        return;
+
+    DecodeInstruction(branch.address, endAddress, m_loop.instructions[nbInstructions++]);
+    m_loop.nbInstructions = nbInstructions;
+
+    if (IsIdleLoop())
+    {
+        m_loop.kind = LoopKind::Idle;
+        m_loop.nbSkippedCycles = GetLoopCycles(m_idleLoopSkippedCycles, m_PC);
+    }
+    else
+    {
+        m_loop.kind = GetMemoryLoopKind();
+        if (m_loop.kind != LoopKind::None)
+            m_loop.nbSkippedCycles = GetLoopCycles(m_memoryLoopCycles, m_PC);
+    }
+}
+
+size_t* Z80Processor::GetLoopCycles(LoopCycles& loops, uint16_t address)
+{
+    for (auto& [loopAddress, nbCycles] : loops)
+    {
+        if (loopAddress == address)
+            return &nbCycles;
+    }
+
+    if (loops.full())
+        return &m_untrackedLoopCycles;
+
+    loops.push_back({address, 0});
+    return &loops.back().second;
+}
+
+bool Z80Processor::IsIdleLoop()
+{
+    // The first instruction reads the polled register in A
+    const DecodedInstruction& load = m_loop.instructions[0];
+    if (load.firstByte == 0xF0) // LDH A,(a8)
+        m_loop.polledAddress = 0xFF00 | (load.operand & 0x00FF);
+    else if (load.firstByte == 0xFA) // LD A,(a16)
+        m_loop.polledAddress = load.operand;
+    else
+        return false;
+
+    // Those registers can only change on events known by the bus
+    switch (m_loop.polledAddress)
+    {
+    case 0xFF00: // Joypad
+    case 0xFF04: // DIV
+    case 0xFF05: // TIMA
+    case 0xFF0F: // IF
+    case 0xFF41: // STAT
+    case 0xFF44: // LY
+        break;
+    default:
+        return false;
+    }
+
+    // Then only operations on A with literals, which don't depend on the carry.
+    // Flags are then the same at the end of each iteration.
+    for (uint8_t i = 1; i < m_loop.nbInstructions - 1; ++i)
+    {
+        const DecodedInstruction& instruction = m_loop.instructions[i];
+        switch (instruction.firstByte)
+        {
+        case 0xC6: // ADD A,d8
+        case 0xD6: // SUB A,d8
+        case 0xE6: // AND A,d8
+        case 0xEE: // XOR A,d8
+        case 0xF6: // OR A,d8
+        case 0xFE: // CP A,d8
+            break;
+        case 0xCB: // BIT b,A
+            if ((instruction.opcode & 0xC7) == 0x47)
+                break;
+            return false;
+        default:
+            return false;
+        }
+    }
+
+    return true;
+}
+
+Z80Processor::LoopKind Z80Processor::GetMemoryLoopKind()
+{
+    // Recognized idioms, all ending with JR NZ:
+    // Copy: LD A,(HL+) / LD (DE),A / INC DE or LD A,(DE) / LD (HL+),A / INC DE
+    // Fill: LD (HL+),A
+    // Followed by the counter: DEC r8 or DEC BC / LD A,B / OR C
+    const uint8_t nbInstructions = m_loop.nbInstructions;
+    const DecodedInstruction* instructions = m_loop.instructions.data();
+    if (instructions[nbInstructions - 1].firstByte != 0x20)
+        return LoopKind::None;
+
+    uint8_t nbBodyInstructions = nbInstructions - 1;
+    uint8_t nbCycles = 3; // JR taken
+
+    // Counter
+    const uint8_t lastBodyOpcode = instructions[nbBodyInstructions - 1].firstByte;
+    if (nbBodyInstructions >= 4 && instructions[nbBodyInstructions - 3].firstByte == 0x0B &&
+        instructions[nbBodyInstructions - 2].firstByte == 0x78 && lastBodyOpcode == 0xB1)
+    {
+        m_loop.isWordCounter = true;
+        m_loop.counterRegister = 0; // BC
+        nbBodyInstructions -= 3;
+        nbCycles += 4;
+    }
+    else if (nbBodyInstructions >= 2 &&
+             (lastBodyOpcode == 0x05 || lastBodyOpcode == 0x0D || lastBodyOpcode == 0x15 || lastBodyOpcode == 0x1D))
+    {
+        m_loop.isWordCounter = false;
+        m_loop.counterRegister = lastBodyOpcode >> 3; // B, C, D or E
+        nbBodyInstructions -= 1;
+        nbCycles += 1;
+    }
+    else
+    {
+        return LoopKind::None;
+    }
+
+    constexpr uint8_t DE = 1;
+    constexpr uint8_t HL = 2;
+
+    // Fill, A must not be overwritten by the counter
+    if (nbBodyInstructions == 1 && instructions[0].firstByte == 0x22 && !m_loop.isWordCounter)
+    {
+        m_loop.destinationRegister = HL;
+        m_loop.nbCycles = nbCycles + 2;
+        return LoopKind::Fill;
+    }
+
+    // Copy, the counter can't be one of the pointers
+    if (nbBodyInstructions == 3 && instructions[2].firstByte == 0x13 && (m_loop.isWordCounter || m_loop.counterRegister < 2))
+    {
+        if (instructions[0].firstByte == 0x2A && instructions[1].firstByte == 0x12)
+        {
+            m_loop.sourceRegister = HL;
+            m_loop.destinationRegister = DE;
+        }
+        else if (instructions[0].firstByte == 0x1A && instructions[1].firstByte == 0x22)
+        {
+            m_loop.sourceRegister = DE;
+            m_loop.destinationRegister = HL;
+        }
+        else
+        {
+            return LoopKind::None;
+        }
+
+        m_loop.nbCycles = nbCycles + 6;
+        return LoopKind::Copy;
+    }
+
+    return LoopKind::None;
+}
+
+uint8_t Z80Processor::RunLoopIteration()
+{
+    uint8_t nbCycles = 0;
+    for (uint8_t i = 0; i < m_loop.nbInstructions; ++i)
+    {
+        const DecodedInstruction& instruction = m_loop.instructions[i];
+        m_PC += instruction.length;
+        m_operand = instruction.operand;
+        nbCycles += instruction.handler(*this, instruction.opcode);
+    }
+
+    return nbCycles;
+}
+
+size_t Z80Processor::SkipIdleLoop(size_t maxNbCycles)
+{
+    // Run a first iteration to know how long it is, and if the loop exits.
+    // Only A, F and PC are changed by the loop, so it can be undone.
+    const RegisterAF af = m_AF;
+    const LazyFlags lazyFlags = m_lazyFlags;
+    const uint16_t operand = m_operand;
+
+    const size_t nbCycles = RunLoopIteration();
+
+    if (m_PC != m_loop.address || nbCycles > maxNbCycles)
+    {
+        m_AF = af;
+        m_lazyFlags = lazyFlags;
+        m_operand = operand;
+        m_PC = (uint16_t)m_loop.address;
+        return 0;
+    }
+
+    // The polled register doesn't change, so all the iterations are the same than the first one
+    const size_t nbIterations = maxNbCycles / nbCycles;
+    m_nbInstructionsExecuted += nbIterations * m_loop.nbInstructions;
+    for (uint8_t i = 0; i < m_loop.nbInstructions; ++i)
+        m_opcodeCount[m_loop.instructions[i].firstByte] += nbIterations;
+
+    *m_loop.nbSkippedCycles += nbIterations * nbCycles;
+
+    return nbIterations * nbCycles;
+}
+
+bool Z80Processor::IsInMemoryLoop(uint16_t& destinationAddress) const
+{
+    if (!IsAtLoopStart() || (m_loop.kind != LoopKind::Copy && m_loop.kind != LoopKind::Fill))
+        return false;
+
+    destinationAddress = m_loop.destinationRegister == 1 ? m_DE.DE : m_HL.HL;
+    return true;
+}
+
+size_t Z80Processor::RunMemoryLoop(size_t maxNbCycles)
+{
+    size_t nbIterationsLeft = 0;
+    uint8_t counter = 0;
+    if (m_loop.isWordCounter)
+    {
+        nbIterationsLeft = m_BC.BC == 0 ? 0x10000 : m_BC.BC;
+    }
+    else
+    {
+        ReadByteFromRegisterIndex(m_loop.counterRegister, counter);
+        nbIterationsLeft = counter == 0 ? 0x100 : counter;
+    }
+
+    // The last iteration is run with the instructions, so registers and flags are exactly
+    // the ones of the loop. All the others are done in bulk before.
+    const size_t nbIterations = std::min<size_t>(nbIterationsLeft, maxNbCycles / m_loop.nbCycles);
+    if (nbIterations < 2)
+        return 0;
+
+    uint16_t source = 0x0000;
+    uint16_t destination = 0x0000;
+    ReadWordFromRegisterIndex(m_loop.destinationRegister, destination);
+    if (!m_bus->IsPlainMemory(destination, nbIterations, true))
+        return 0;
+
+    const uint16_t nbBulkIterations = (uint16_t)(nbIterations - 1);
+    if (m_loop.kind == LoopKind::Copy)
+    {
+        ReadWordFromRegisterIndex(m_loop.sourceRegister, source);
+        if (!m_bus->IsPlainMemory(source, nbIterations, false))
+            return 0;
+
+        m_bus->CopyMemory(destination, source, nbBulkIterations);
+        WriteWordToRegisterIndex(m_loop.sourceRegister, source + nbBulkIterations);
+    }
+    else
+    {
+        m_bus->FillMemory(destination, m_AF.A, nbBulkIterations);
+    }
+
+    WriteWordToRegisterIndex(m_loop.destinationRegister, destination + nbBulkIterations);
+    if (m_loop.isWordCounter)
+        m_BC.BC -= nbBulkIterations;
+    else
+        WriteByteToRegisterIndex(m_loop.counterRegister, (uint8_t)(counter - nbBulkIterations));
+
+    const size_t nbCycles = nbBulkIterations * m_loop.nbCycles + RunLoopIteration();
+
+    m_nbInstructionsExecuted += nbIterations * m_loop.nbInstructions;
+    for (uint8_t i = 0; i < m_loop.nbInstructions; ++i)
+        m_opcodeCount[m_loop.instructions[i].firstByte] += nbIterations;
+
+    *m_loop.nbSkippedCycles += nbCycles;
+
+    return nbCycles;
+}
+
+constexpr Z80Processor::OpCall Z80Processor::GetCBOpCall(uint8_t opcode)
+{
+    switch (opcode >> 4)
+    {
+    case 0x0: // RLC and RRC
+        return (opcode & 0x08) ? &Z80Processor::RRC : &Z80Processor::RLC;
+    case 0x1: // RL and RR
+        return (opcode & 0x08) ? &Z80Processor::RR : &Z80Processor::RL;
+    case 0x2: // SLA and SRA
+        return (opcode & 0x08) ? &Z80Processor::SRA : &Z80Processor::SLA;
+    case 0x3: // SWAP and SRL
+        return (opcode & 0x08) ? &Z80Processor::SRL : &Z80Processor::SWAP;
+
+    case 0x4: // fall-through
+    case 0x5: // fall-through
+    case 0x6: // fall-through
+    case 0x7: // BIT
+        return &Z80Processor::BIT;
+
+    case 0x8: // fall-through
+    case 0x9: // fall-through
+    case 0xA: // fall-through
+    case 0xB: // RES
+        return &Z80Processor::RES;
+
+    default: // SET
+        return &Z80Processor::SET;
+    };
+}
+
+constexpr bool Z80Processor::IsBlockTerminator(uint8_t opcode)
+{
+    switch (opcode)
+    {
+    case 0x10: // STOP
+    case 0x18: // JR
+    case 0x76: // HALT
+    case 0xC3: // JP
+    case 0xC9: // RET
+    case 0xCD: // CALL
+    case 0xD9: // RETI
+    case 0xE9: // JP HL
+        return true;
+    default:
+        // RST
+        return (opcode & 0xC7) == 0xC7;
+    }
+}
+
+// Dispatch of decoded instructions
+// Specialized handlers call the generic one with a constant opcode. Once flattened, all the
+// tests on the opcode (register index, memory access, number of cycles) are resolved
+// at compile time.
+template <uint8_t Opcode>
+Z80_FLATTEN uint8_t Z80Processor::ExecuteSpecialized(Z80Processor& cpu, uint8_t /*opcode*/)
+{
+    constexpr OpCall opCall = m_opcodesMap[Opcode];
+    return (cpu.*opCall)(Opcode);
+}
+
+template <uint8_t Opcode>
+Z80_FLATTEN uint8_t Z80Processor::ExecuteSpecializedCB(Z80Processor& cpu, uint8_t /*opcode*/)
+{
+    constexpr OpCall opCall = GetCBOpCall(Opcode);
+    return (cpu.*opCall)(Opcode);
+}
+
+template <bool IsCB, size_t... Opcodes>
+constexpr std::array<Z80Processor::InstructionHandler, 256> Z80Processor::MakeSpecializedHandlers(
+    std::index_sequence<Opcodes...>)
+{
+    if constexpr (IsCB)
+        return {&ExecuteSpecializedCB<(uint8_t)Opcodes>...};
+    else
+        return {&ExecuteSpecialized<(uint8_t)Opcodes>...};
+}
+
+const std::array<Z80Processor::InstructionHandler, 256> Z80Processor::m_specializedHandlers =
+    Z80Processor::MakeSpecializedHandlers<false>(std::make_index_sequence<256>());
+
+const std::array<Z80Processor::InstructionHandler, 256> Z80Processor::m_specializedCBHandlers =
+    Z80Processor::MakeSpecializedHandlers<true>(std::make_index_sequence<256>());
+
+uint8_t Z80Processor::ExecuteGeneric(Z80Processor& cpu, uint8_t opcode)
+{
+    auto opCall = m_opcodesMap[opcode];
+    return (cpu.*opCall)(opcode);
+}
+
+uint8_t Z80Processor::ExecuteGenericCB(Z80Processor& cpu, uint8_t opcode)
+{
+    return (cpu.*GetCBOpCall(opcode))(opcode);
 }
 
 constexpr const char* Z80Processor::GetDebugStringForOp(uint8_t opcode)
@@ -335,13 +1020,12 @@ constexpr const char* Z80Processor::GetDebugStringForOp(uint8_t opcode)
     return "XXX";
 }
 
-// Dispatchers
-uint8_t Z80Processor::DecodeOpcodeAndCall(uint8_t opcode)
+void Z80Processor::OnInterruptFlagsChanged()
 {
-    auto opCall = m_opcodesMap[opcode];
-    return (this->*opCall)(opcode);
+    m_isInterruptPending = (m_bus->m_registers.IF.flag & m_bus->m_registers.IE.flag) != 0;
 }
 
+// Only called when an interrupt is pending (IF & IE != 0)
 uint8_t Z80Processor::HandleInterrupt()
 {
     if (!m_IMEEnabled && !m_isPaused)
@@ -350,17 +1034,8 @@ uint8_t Z80Processor::HandleInterrupt()
         return 0;
     }
 
-    InterruptRegister& IE = m_bus->m_IE;
-
-    if (IE.flag == 0x00)
-        return 0;
-
-    InterruptRegister& IF = m_bus->m_IF;
-
-    bool interruptPending = (IF.flag & IE.flag) > 0;
-
-    if (!interruptPending)
-        return 0;
+    InterruptRegister& IE = m_bus->m_registers.IE;
+    InterruptRegister& IF = m_bus->m_registers.IF;
 
     if (m_isPaused)
     {
@@ -406,6 +1081,8 @@ uint8_t Z80Processor::HandleInterrupt()
         jumpingAddress = 0x0060;
     }
 
+    OnInterruptFlagsChanged();
+
     // Next instruction is push on the stack
     PushWordToStack(m_PC);
 
@@ -568,6 +1245,7 @@ uint8_t Z80Processor::ADD(uint8_t opcode)
     // Signed addition
     if (opcode == 0xE8)
     {
+        MaterializeFlags();
         int8_t data = (int8_t)(FetchByte());
         m_AF.F.C = (m_SP & 0xFF) + (data & 0xFF) > 0xFF;
         m_AF.F.H = (m_SP & 0x0F) + (data & 0x0F) > 0x0F;
@@ -581,6 +1259,8 @@ uint8_t Z80Processor::ADD(uint8_t opcode)
     // 16 bits mode
     if ((opcode & 0x0F) == 0x09)
     {
+        // Z is untouched
+        MaterializeFlags();
         uint8_t index = opcode >> 4;
         uint16_t data = 0;
         ReadWordFromRegisterIndex(index, data);
@@ -600,8 +1280,7 @@ uint8_t Z80Processor::ADD(uint8_t opcode)
     // but with a carry equal to 0
     // We re-use the same code then
     uint8_t overridenOpcode = opcode == 0xC6 ? 0xCE : opcode;
-    m_AF.F.C = 0;
-    return ADC(overridenOpcode);
+    return AddToAccumulator(overridenOpcode, 0);
 }
 
 // ADC op
@@ -615,7 +1294,9 @@ uint8_t Z80Processor::ADD(uint8_t opcode)
 // N: 0
 // H: If overflow from bit 3
 // C: If overflow from bit 7
-uint8_t Z80Processor::ADC(uint8_t opcode)
+uint8_t Z80Processor::ADC(uint8_t opcode) { return AddToAccumulator(opcode, GetCarryFlag()); }
+
+uint8_t Z80Processor::AddToAccumulator(uint8_t opcode, uint8_t carry)
 {
     uint8_t data = 0;
     uint8_t nbCycles = 1;
@@ -632,17 +1313,9 @@ uint8_t Z80Processor::ADC(uint8_t opcode)
             nbCycles++;
     }
 
-    // Half carry if the addition of the 4 lsb of each operand overflow
-    m_AF.F.H = ((data & 0x0F) + (m_AF.A & 0x0F) + m_AF.F.C) > 0x0F;
-
-    uint16_t temp = (uint16_t)m_AF.A + (uint16_t)data + (uint16_t)m_AF.F.C;
-
-    m_AF.F.N = 0;
-    m_AF.F.C = (temp & 0xFF00) > 0;
-
-    m_AF.A = (uint8_t)(temp & 0x00FF);
-
-    SetZeroFlag(m_AF.A);
+    uint8_t result = m_AF.A + data + carry;
+    SetFlagsFromOperation(FlagsOperation::Add, m_AF.A, data, carry, result);
+    m_AF.A = result;
 
     return nbCycles;
 }
@@ -658,8 +1331,7 @@ uint8_t Z80Processor::SUB(uint8_t opcode)
     // but with a carry equal to 0
     // We re-use the same code then
     uint8_t overridenOpcode = opcode == 0xD6 ? 0xDE : opcode;
-    m_AF.F.C = 0;
-    return SBC(overridenOpcode);
+    return SubtractFromAccumulator(overridenOpcode, 0);
 }
 
 // SBC op
@@ -673,14 +1345,16 @@ uint8_t Z80Processor::SUB(uint8_t opcode)
 // N: 1
 // H: If borrow from bit 4
 // C: If borrow (if data + carry > A)
-uint8_t Z80Processor::SBC(uint8_t opcode)
+uint8_t Z80Processor::SBC(uint8_t opcode) { return SubtractFromAccumulator(opcode, GetCarryFlag()); }
+
+uint8_t Z80Processor::SubtractFromAccumulator(uint8_t opcode, uint8_t carry)
 {
     uint8_t data = 0;
     uint8_t nbCycles = 1;
     if (opcode == 0xDE)
     {
         // Literal value
-        data = ReadByte(m_PC++);
+        data = FetchByte();
         nbCycles++;
     }
     else
@@ -690,15 +1364,9 @@ uint8_t Z80Processor::SBC(uint8_t opcode)
             nbCycles++;
     }
 
-    m_AF.F.H = ((data & 0x0F) + m_AF.F.C) > (m_AF.A & 0x0F);
-    uint8_t oldCarry = m_AF.F.C;
-    m_AF.F.C = (data + m_AF.F.C) > m_AF.A;
-
-    m_AF.A -= (data + oldCarry);
-
-    m_AF.F.N = 1;
-
-    SetZeroFlag(m_AF.A);
+    uint8_t result = m_AF.A - data - carry;
+    SetFlagsFromOperation(FlagsOperation::Sub, m_AF.A, data, carry, result);
+    m_AF.A = result;
 
     return nbCycles;
 }
@@ -731,13 +1399,9 @@ uint8_t Z80Processor::AND(uint8_t opcode)
             nbCycles++;
     }
 
-    m_AF.F.H = 1;
-    m_AF.F.C = 0;
-    m_AF.F.N = 0;
-
     m_AF.A &= data;
 
-    SetZeroFlag(m_AF.A);
+    SetFlagsFromOperation(FlagsOperation::And, 0, 0, 0, m_AF.A);
 
     return nbCycles;
 }
@@ -770,13 +1434,9 @@ uint8_t Z80Processor::OR(uint8_t opcode)
             nbCycles++;
     }
 
-    m_AF.F.H = 0;
-    m_AF.F.C = 0;
-    m_AF.F.N = 0;
-
     m_AF.A |= data;
 
-    SetZeroFlag(m_AF.A);
+    SetFlagsFromOperation(FlagsOperation::Or, 0, 0, 0, m_AF.A);
 
     return nbCycles;
 }
@@ -809,13 +1469,9 @@ uint8_t Z80Processor::XOR(uint8_t opcode)
             nbCycles++;
     }
 
-    m_AF.F.H = 0;
-    m_AF.F.C = 0;
-    m_AF.F.N = 0;
-
     m_AF.A ^= data;
 
-    SetZeroFlag(m_AF.A);
+    SetFlagsFromOperation(FlagsOperation::Or, 0, 0, 0, m_AF.A);
 
     return nbCycles;
 }
@@ -882,15 +1538,15 @@ uint8_t Z80Processor::DEC(uint8_t opcode)
     if (ReadByteFromRegisterIndex(index, data))
         nbCycles++;
 
-    m_AF.F.H = (data & 0x0F) == 0;
+    const uint8_t oldData = data;
 
     data--;
 
     if (WriteByteToRegisterIndex(index, data))
         nbCycles++;
 
-    SetZeroFlag(data);
-    m_AF.F.N = 1;
+    // Carry is untouched
+    SetFlagsFromOperation(FlagsOperation::Dec, oldData, 0, GetCarryFlag(), data);
 
     return nbCycles;
 }
@@ -934,14 +1590,14 @@ uint8_t Z80Processor::INC(uint8_t opcode)
     if (ReadByteFromRegisterIndex(index, data))
         nbCycles++;
 
-    m_AF.F.H = (data & 0x0F) == 0x0F;
+    const uint8_t oldData = data;
 
     data++;
     if (WriteByteToRegisterIndex(index, data))
         nbCycles++;
 
-    SetZeroFlag(data);
-    m_AF.F.N = 0;
+    // Carry is untouched
+    SetFlagsFromOperation(FlagsOperation::Inc, oldData, 0, GetCarryFlag(), data);
 
     return nbCycles;
 }
@@ -974,9 +1630,8 @@ uint8_t Z80Processor::BIT(uint8_t opcode)
     if (ReadByteFromRegisterIndex(registerIndex, data))
         ++nbCycles;
 
-    SetZeroFlag(data & (1 << bitToCheck));
-    m_AF.F.N = 0;
-    m_AF.F.H = 1;
+    // Carry is untouched
+    SetFlagsFromOperation(FlagsOperation::Bit, 0, 0, GetCarryFlag(), data & (1 << bitToCheck));
 
     return nbCycles;
 }
@@ -1069,10 +1724,7 @@ uint8_t Z80Processor::SWAP(uint8_t opcode)
     if (WriteByteToRegisterIndex(registerIndex, data))
         nbCycles++;
 
-    SetZeroFlag(data);
-    m_AF.F.N = 0;
-    m_AF.F.H = 0;
-    m_AF.F.C = 0;
+    SetFlagsFromOperation(FlagsOperation::Shift, 0, 0, 0, data);
 
     return nbCycles;
 }
@@ -1102,17 +1754,15 @@ uint8_t Z80Processor::RL(uint8_t opcode)
     if (ReadByteFromRegisterIndex(registerIndex, data))
         nbCycles++;
 
-    uint8_t oldCarry = m_AF.F.C;
-    m_AF.F.C = (data & 0x80) > 0;
+    uint8_t oldCarry = GetCarryFlag();
+    uint8_t carry = (data & 0x80) > 0;
 
     data = (data << 1) | oldCarry;
 
     if (WriteByteToRegisterIndex(registerIndex, data))
         nbCycles++;
 
-    SetZeroFlag(data);
-    m_AF.F.N = 0;
-    m_AF.F.H = 0;
+    SetFlagsFromOperation(FlagsOperation::Shift, 0, 0, carry, data);
 
     return nbCycles;
 }
@@ -1125,6 +1775,7 @@ uint8_t Z80Processor::RL(uint8_t opcode)
 uint8_t Z80Processor::RLA(uint8_t opcode)
 {
     RL(0x07);
+    MaterializeFlags();
     m_AF.F.Z = 0;
     return 1;
 }
@@ -1152,16 +1803,14 @@ uint8_t Z80Processor::RLC(uint8_t opcode)
     if (ReadByteFromRegisterIndex(registerIndex, data))
         nbCycles++;
 
-    m_AF.F.C = (data & 0x80) > 0;
+    uint8_t carry = (data & 0x80) > 0;
 
-    data = (data << 1) | m_AF.F.C;
+    data = (data << 1) | carry;
 
     if (WriteByteToRegisterIndex(registerIndex, data))
         nbCycles++;
 
-    SetZeroFlag(data);
-    m_AF.F.N = 0;
-    m_AF.F.H = 0;
+    SetFlagsFromOperation(FlagsOperation::Shift, 0, 0, carry, data);
 
     return nbCycles;
 }
@@ -1174,6 +1823,7 @@ uint8_t Z80Processor::RLC(uint8_t opcode)
 uint8_t Z80Processor::RLCA(uint8_t opcode)
 {
     RLC(0x07);
+    MaterializeFlags();
     m_AF.F.Z = 0;
     return 1;
 }
@@ -1201,17 +1851,15 @@ uint8_t Z80Processor::RR(uint8_t opcode)
     if (ReadByteFromRegisterIndex(registerIndex, data))
         nbCycles++;
 
-    uint8_t oldCarry = m_AF.F.C;
-    m_AF.F.C = data & 0x01;
+    uint8_t oldCarry = GetCarryFlag();
+    uint8_t carry = data & 0x01;
 
     data = (data >> 1) | (oldCarry << 7);
 
     if (WriteByteToRegisterIndex(registerIndex, data))
         nbCycles++;
 
-    SetZeroFlag(data);
-    m_AF.F.N = 0;
-    m_AF.F.H = 0;
+    SetFlagsFromOperation(FlagsOperation::Shift, 0, 0, carry, data);
 
     return nbCycles;
 }
@@ -1224,6 +1872,7 @@ uint8_t Z80Processor::RR(uint8_t opcode)
 uint8_t Z80Processor::RRA(uint8_t /*opcode*/)
 {
     RR(0x07);
+    MaterializeFlags();
     m_AF.F.Z = 0;
     return 1;
 }
@@ -1251,16 +1900,14 @@ uint8_t Z80Processor::RRC(uint8_t opcode)
     if (ReadByteFromRegisterIndex(registerIndex, data))
         nbCycles++;
 
-    m_AF.F.C = data & 0x01;
+    uint8_t carry = data & 0x01;
 
-    data = (data >> 1) | (m_AF.F.C << 7);
+    data = (data >> 1) | (carry << 7);
 
     if (WriteByteToRegisterIndex(registerIndex, data))
         nbCycles++;
 
-    SetZeroFlag(data);
-    m_AF.F.N = 0;
-    m_AF.F.H = 0;
+    SetFlagsFromOperation(FlagsOperation::Shift, 0, 0, carry, data);
 
     return nbCycles;
 }
@@ -1273,6 +1920,7 @@ uint8_t Z80Processor::RRC(uint8_t opcode)
 uint8_t Z80Processor::RRCA(uint8_t /*opcode*/)
 {
     RRC(0x07);
+    MaterializeFlags();
     m_AF.F.Z = 0;
     return 1;
 }
@@ -1300,16 +1948,14 @@ uint8_t Z80Processor::SLA(uint8_t opcode)
     if (ReadByteFromRegisterIndex(registerIndex, data))
         nbCycles++;
 
-    m_AF.F.C = (data & 0x80) > 0;
+    uint8_t carry = (data & 0x80) > 0;
 
     data <<= 1;
 
     if (WriteByteToRegisterIndex(registerIndex, data))
         nbCycles++;
 
-    SetZeroFlag(data);
-    m_AF.F.N = 0;
-    m_AF.F.H = 0;
+    SetFlagsFromOperation(FlagsOperation::Shift, 0, 0, carry, data);
 
     return nbCycles;
 }
@@ -1337,16 +1983,14 @@ uint8_t Z80Processor::SRA(uint8_t opcode)
     if (ReadByteFromRegisterIndex(registerIndex, data))
         nbCycles++;
 
-    m_AF.F.C = (data & 0x01) > 0;
+    uint8_t carry = (data & 0x01) > 0;
 
     data = (data >> 1) | (data & 0x80);
 
     if (WriteByteToRegisterIndex(registerIndex, data))
         nbCycles++;
 
-    SetZeroFlag(data);
-    m_AF.F.N = 0;
-    m_AF.F.H = 0;
+    SetFlagsFromOperation(FlagsOperation::Shift, 0, 0, carry, data);
 
     return nbCycles;
 }
@@ -1374,57 +2018,26 @@ uint8_t Z80Processor::SRL(uint8_t opcode)
     if (ReadByteFromRegisterIndex(registerIndex, data))
         nbCycles++;
 
-    m_AF.F.C = (data & 0x01) > 0;
+    uint8_t carry = (data & 0x01) > 0;
 
     data >>= 1;
 
     if (WriteByteToRegisterIndex(registerIndex, data))
         nbCycles++;
 
-    SetZeroFlag(data);
-    m_AF.F.N = 0;
-    m_AF.F.H = 0;
+    SetFlagsFromOperation(FlagsOperation::Shift, 0, 0, carry, data);
 
     return nbCycles;
 }
 
 // Dispatcher instruction
+// Decoded instructions are directly resolved to the right handler, so this is only
+// here for completeness.
 uint8_t Z80Processor::DISP(uint8_t /*opcode*/)
 {
-    // First get the second opcode
+    // The second opcode is the operand of the instruction
     uint8_t opcode = FetchByte();
-
-    switch (opcode >> 4)
-    {
-    case 0x0: // RLC and RRC
-        return (opcode & 0x08) ? RRC(opcode) : RLC(opcode);
-    case 0x1: // RL and RR
-        return (opcode & 0x08) ? RR(opcode) : RL(opcode);
-    case 0x2: // SLA and SRA
-        return (opcode & 0x08) ? SRA(opcode) : SLA(opcode);
-    case 0x3: // SWAP and SRL
-        return (opcode & 0x08) ? SRL(opcode) : SWAP(opcode);
-
-    case 0x4: // fall-through
-    case 0x5: // fall-through
-    case 0x6: // fall-through
-    case 0x7: // BIT
-        return BIT(opcode);
-
-    case 0x8: // fall-through
-    case 0x9: // fall-through
-    case 0xA: // fall-through
-    case 0xB: // RES
-        return RES(opcode);
-
-    case 0xC: // fall-through
-    case 0xD: // fall-through
-    case 0xE: // fall-through
-    case 0xF: // SET
-        return SET(opcode);
-    };
-
-    return 0;
+    return (this->*GetCBOpCall(opcode))(opcode);
 }
 
 // Jumps and Subroutines
@@ -1445,6 +2058,10 @@ uint8_t Z80Processor::CALL(uint8_t opcode)
     // 0xCC => Z set
     // 0xDC => C set
     // 0xCD => Always jump
+    // Flags are only needed for conditional jumps
+    if (opcode != 0xCD)
+        MaterializeFlags();
+
     bool conditionMet = (opcode == 0xC4 && !m_AF.F.Z) || (opcode == 0xD4 && !m_AF.F.C) ||
                         (opcode == 0xCC && m_AF.F.Z) || (opcode == 0xDC && m_AF.F.C) || (opcode == 0xCD);
 
@@ -1483,6 +2100,10 @@ uint8_t Z80Processor::JP(uint8_t opcode)
     // 0xCA => Z set
     // 0xDA => C set
     // 0xC3 => Always jump
+    // Flags are only needed for conditional jumps
+    if (opcode != 0xC3)
+        MaterializeFlags();
+
     bool conditionMet = (opcode == 0xC2 && !m_AF.F.Z) || (opcode == 0xD2 && !m_AF.F.C) ||
                         (opcode == 0xCA && m_AF.F.Z) || (opcode == 0xDA && m_AF.F.C) || (opcode == 0xC3);
 
@@ -1509,6 +2130,10 @@ uint8_t Z80Processor::JR(uint8_t opcode)
     // 0x28 => Z set
     // 0x38 => C set
     // 0x18 => Always jump
+    // Flags are only needed for conditional jumps
+    if (opcode != 0x18)
+        MaterializeFlags();
+
     bool conditionMet = (opcode == 0x20 && !m_AF.F.Z) || (opcode == 0x30 && !m_AF.F.C) ||
                         (opcode == 0x28 && m_AF.F.Z) || (opcode == 0x38 && m_AF.F.C) || (opcode == 0x18);
 
@@ -1533,6 +2158,10 @@ uint8_t Z80Processor::RET(uint8_t opcode)
     // 0xC8 => Z set
     // 0xD8 => C set
     // 0xC9 => Always jump
+    // Flags are only needed for conditional jumps
+    if (opcode != 0xC9)
+        MaterializeFlags();
+
     bool conditionMet = (opcode == 0xC0 && !m_AF.F.Z) || (opcode == 0xD0 && !m_AF.F.C) ||
                         (opcode == 0xC8 && m_AF.F.Z) || (opcode == 0xD8 && m_AF.F.C) || (opcode == 0xC9);
 
@@ -1592,6 +2221,7 @@ uint8_t Z80Processor::POP(uint8_t opcode)
     if (index == 3)
     {
         // Special behavior for AF, only pop certain bits for the flag
+        MaterializeFlags();
         m_AF.AF = data & 0xFFF0;
     }
     else
@@ -1616,6 +2246,7 @@ uint8_t Z80Processor::PUSH(uint8_t opcode)
     if (index == 3)
     {
         // Special behavior for AF, only push certain bits for the flag
+        MaterializeFlags();
         data = (m_AF.AF & 0xFFF0);
     }
     else
@@ -1659,6 +2290,7 @@ uint8_t Z80Processor::LDSP(uint8_t opcode)
 // C: Inverted
 uint8_t Z80Processor::CCF(uint8_t /*opcode*/)
 {
+    MaterializeFlags();
     m_AF.F.C = ~m_AF.F.C;
     m_AF.F.N = 0;
     m_AF.F.H = 0;
@@ -1675,6 +2307,7 @@ uint8_t Z80Processor::CCF(uint8_t /*opcode*/)
 // Z and C: Untouched
 uint8_t Z80Processor::CPL(uint8_t /*opcode*/)
 {
+    MaterializeFlags();
     m_AF.A = ~m_AF.A;
     m_AF.F.N = 1;
     m_AF.F.H = 1;
@@ -1697,6 +2330,8 @@ uint8_t Z80Processor::CPL(uint8_t /*opcode*/)
 // need to do another pass to understand it better
 uint8_t Z80Processor::DAA(uint8_t /*opcode*/)
 {
+    MaterializeFlags();
+
     // Addition, adjust if (half-)carry occured or
     // is the result is out-of-bounds
     if (m_AF.F.N == 0)
@@ -1775,6 +2410,7 @@ uint8_t Z80Processor::NOP(uint8_t /*opcode*/) { return 1; }
 // H: 0
 uint8_t Z80Processor::SCF(uint8_t /*opcode*/)
 {
+    MaterializeFlags();
     m_AF.F.C = 1;
     m_AF.F.N = 0;
     m_AF.F.H = 0;
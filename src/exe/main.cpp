@@ -45,6 +45,8 @@ int main(int argc, char** argv)
     }
 
     GBEmulator::Bus bus;
+    // Live play, the game clock follows the real time
+    bus.SetRTCMode(GBEmulator::RTCMode::Host);
 
     GBAudioSystem audioSystem(bus, syncWithAudio, 2, GBEmulator::APU_SAMPLE_RATE, 256);
     audioSystem.Enable(enableAudioByDefault);
@@ -136,13 +138,19 @@ int main(int argc, char** argv)
                 size_t nbClocks = (size_t)(timeSpent / cpuPeriodUS);
                 if (!bus.IsInBreak())
                 {
-                    for (auto i = 0; i < nbClocks; ++i)
+                    for (size_t i = 0; i < nbClocks;)
                     {
-                        if (bus.Clock())
-                            DispatchMessageServiceSingleton::GetInstance().Push(
-                                RenderMessage(bus.GetPPU().GetScreen().data(), bus.GetPPU().GetScreen().size()));
+                        // Stops at the end of each frame to render it
+                        GBEmulator::RunStatus status = bus.RunCycles(nbClocks - i);
+                        i += status.nbCycles;
 
-                        if (bus.IsInBreak())
+                        if (status.frameFinished)
+                        {
+                            const GBEmulator::FrameView frame = bus.GetPPU().AcquireFrame();
+                            DispatchMessageServiceSingleton::GetInstance().Push(RenderMessage(frame.data, frame.size));
+                        }
+
+                        if (status.isInBreak || status.nbCycles == 0)
                             break;
                     }
                 }
@@ -197,7 +197,7 @@ bool CoreMessageService::Pull(Message& message)
         }
         case DefaultDebugMessageType::GET_VRAM:
         {
-            const std::vector<uint8_t> vram = m_bus.GetPPU().GetVRAM();
+            const auto& vram = m_bus.GetPPU().GetVRAM();
             assert(payload->m_dataCapacity < vram.size());
 
             uint16_t offset = payload->m_addressStart - 0x8000;
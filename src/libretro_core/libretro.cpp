@@ -12,11 +12,11 @@
 #include <array>
 #include <cstring>
 #include <memory>
+#include <string>
 
 static std::unique_ptr<GBEmulator::Bus> s_bus;
 static std::shared_ptr<GBEmulator::Controller> s_controller;
 
-static std::array<uint32_t, GBEmulator::GB_INTERNAL_HEIGHT * GBEmulator::GB_INTERNAL_WIDTH> frame_buf;
 static struct retro_log_callback logging;
 static retro_log_printf_t log_cb;
 static bool use_audio_cb;
@@ -42,7 +42,7 @@ void retro_init(void)
 
     environ_cb(RETRO_ENVIRONMENT_SET_PERFORMANCE_LEVEL, &level);
 
-    s_bus = std::make_unique<GBEmulator::Bus>();
+    s_bus = std::make_unique<GBEmulator::Bus>(GBEmulator::PixelFormat::XRGB8888);
     s_controller = std::make_shared<GBEmulator::Controller>();
     s_bus->ConnectController(s_controller);
 }
@@ -130,17 +130,9 @@ static void check_variables(void) {}
 
 static void video_callback()
 {
-    std::vector<uint8_t> screen = s_bus->GetPPU().GetScreen();
-
-    for (size_t i = 0; i < frame_buf.size(); ++i)
-    {
-        const uint32_t R = screen[3 * i];
-        const uint32_t G = screen[3 * i + 1];
-        const uint32_t B = screen[3 * i + 2];
-        frame_buf[i] = (R << 16) | (G << 8) | B;
-    }
-
-    video_cb(frame_buf.data(), GBEmulator::GB_INTERNAL_WIDTH, GBEmulator::GB_INTERNAL_HEIGHT,
+    // The PPU renders in XRGB8888 directly. The frame stays untouched until the next one is acquired.
+    const GBEmulator::FrameView frame = s_bus->GetPPU().AcquireFrame();
+    video_cb(frame.data, GBEmulator::GB_INTERNAL_WIDTH, GBEmulator::GB_INTERNAL_HEIGHT,
              GBEmulator::GB_INTERNAL_WIDTH * sizeof(uint32_t));
 }
 
@@ -162,17 +154,17 @@ void retro_run(void)
 {
     update_input();
 
-    while (s_bus->GetPPU().GetLY() != 0)
-    {
-        s_bus->Clock();
-        audio_callback();
-    }
-
-    while (s_bus->GetPPU().GetLY() <= 143)
+    // Run until the frame is complete, stopping each time audio samples are ready to send them.
+    // At most a frame worth of cycles, in case the LCD is off.
+    const size_t nbCyclesPerFrame = s_bus->GetNbCyclesPerFrame();
+    size_t nbCycles = 0;
+    GBEmulator::RunStatus status;
+    do
     {
-        s_bus->Clock();
+        status = s_bus->RunCycles(nbCyclesPerFrame - nbCycles, true);
+        nbCycles += status.nbCycles;
         audio_callback();
-    }
+    } while (!status.frameFinished && !status.isInBreak && nbCycles < nbCyclesPerFrame);
 
     video_callback();
 }
@@ -239,11 +231,32 @@ size_t retro_get_memory_size(unsigned id)
     return 0;
 }
 
-void retro_cheat_reset(void) {}
+void retro_cheat_reset(void)
+{
+    if (s_bus)
+        s_bus->ClearCheats();
+}
 
+// The frontend resets the cheats and sets all of them again each time one changes
 void retro_cheat_set(unsigned index, bool enabled, const char* code)
 {
     (void)index;
-    (void)enabled;
-    (void)code;
+    if (!s_bus || !enabled || code == nullptr)
+        return;
+
+    // Several codes can be joined with '+'
+    std::string codes = code;
+    size_t start = 0;
+    while (start <= codes.size())
+    {
+        size_t end = codes.find('+', start);
+        if (end == std::string::npos)
+            end = codes.size();
+
+        const std::string singleCode = codes.substr(start, end - start);
+        if (!singleCode.empty() && !s_bus->AddCheat(singleCode) && log_cb)
+            log_cb(RETRO_LOG_WARN, "Invalid cheat code: %s\n", singleCode.c_str());
+
+        start = end + 1;
+    }
 }
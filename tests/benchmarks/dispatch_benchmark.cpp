@@ -0,0 +1,84 @@
+#include <chrono>
+#include <common.h>
+#include <iostream>
+
+// Compare the specialized handlers against the generic ones (going through the opcodes map)
+// Both must give the exact same result. The benchmark, disabled by default, reports the number of
+// instructions per second for each of them (run with --gtest_also_run_disabled_tests).
+class DispatchBenchmark : public GBEmulatorTests::DefaultTest
+{
+public:
+    DispatchBenchmark() : GBEmulatorTests::DefaultTest()
+    {
+        m_testRomName = "cpu_instrs.gb";
+    }
+
+protected:
+    struct Result
+    {
+        size_t nbInstructions = 0;
+        double seconds = 0.0;
+        uint16_t registers[6] = {};
+    };
+
+    Result RunWithMode(GBEmulator::DispatchMode mode, size_t nbFrames)
+    {
+        const size_t nbCycles = nbFrames * 17556;
+
+        GBEmulator::Bus bus;
+        bus.InsertCartridge(m_cartridge);
+
+        GBEmulator::Z80Processor& cpu = bus.GetCPU();
+        cpu.SetDispatchMode(mode);
+
+        float samples[128];
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < nbCycles; ++i)
+        {
+            bus.Clock();
+            // Samples must be consumed, otherwise the APU will wait for the buffer to be emptied
+            bus.GetAPU().FillSamplesIfReady(samples);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        Result result;
+        result.nbInstructions = cpu.GetNbInstructionsExecuted();
+        result.seconds = std::chrono::duration<double>(end - start).count();
+        result.registers[0] = cpu.GetAFRegister().AF;
+        result.registers[1] = cpu.GetBCRegister().BC;
+        result.registers[2] = cpu.GetDERegister().DE;
+        result.registers[3] = cpu.GetHLRegister().HL;
+        result.registers[4] = cpu.GetStackPointer();
+        result.registers[5] = cpu.GetPC();
+        return result;
+    }
+
+    static void ExpectSameResult(const Result& generic, const Result& specialized)
+    {
+        EXPECT_EQ(generic.nbInstructions, specialized.nbInstructions);
+        for (int i = 0; i < 6; ++i)
+            EXPECT_EQ(generic.registers[i], specialized.registers[i]) << "register " << i;
+    }
+};
+
+TEST_F(DispatchBenchmark, SpecializedSameAsGeneric)
+{
+    ASSERT_TRUE(m_cartridge);
+
+    constexpr size_t NB_FRAMES = 30;
+    ExpectSameResult(RunWithMode(GBEmulator::DispatchMode::Generic, NB_FRAMES),
+                     RunWithMode(GBEmulator::DispatchMode::Specialized, NB_FRAMES));
+}
+
+TEST_F(DispatchBenchmark, DISABLED_SpecializedVsGeneric)
+{
+    ASSERT_TRUE(m_cartridge);
+
+    constexpr size_t NB_FRAMES = 300;
+    Result generic = RunWithMode(GBEmulator::DispatchMode::Generic, NB_FRAMES);
+    Result specialized = RunWithMode(GBEmulator::DispatchMode::Specialized, NB_FRAMES);
+    ExpectSameResult(generic, specialized);
+
+    std::cout << "Generic:     " << generic.nbInstructions / generic.seconds << " instructions/s" << std::endl;
+    std::cout << "Specialized: " << specialized.nbInstructions / specialized.seconds << " instructions/s" << std::endl;
+}
@@ -90,6 +90,24 @@ namespace GBEmulatorTests
         return "";
     }
 
+    // Load a rom of the tests folder, nullptr if it can't be found or opened
+    inline std::shared_ptr<GBEmulator::Cartridge> LoadTestCartridge(const std::string& romName)
+    {
+        std::string romPath = FindTestRom(romName);
+        EXPECT_FALSE(romPath.empty()) << "Failed to find the rom";
+
+        if (romPath.empty())
+            return nullptr;
+
+        GBEmulator::Utils::FileReadVisitor visitor(romPath);
+        EXPECT_TRUE(visitor.IsValid()) << "Failed to open the rom";
+
+        if (!visitor.IsValid())
+            return nullptr;
+
+        return std::make_shared<GBEmulator::Cartridge>(visitor);
+    }
+
     class DefaultTest : public ::testing::Test
     {
     public:
@@ -98,19 +116,7 @@ namespace GBEmulatorTests
             if (!m_cartridge || m_loadedCartridgeName != m_testRomName)
             {
                 EXPECT_FALSE(m_testRomName.empty());
-                std::string romPath = GBEmulatorTests::FindTestRom(m_testRomName.c_str());
-                EXPECT_FALSE(romPath.empty()) << "Failed to find the rom";
-
-                if (romPath.empty())
-                    return;
-
-                GBEmulator::Utils::FileReadVisitor visitor(romPath);
-                EXPECT_TRUE(visitor.IsValid()) << "Failed to open the rom";
-
-                if (!visitor.IsValid())
-                    return;
-
-                m_cartridge = std::make_shared<GBEmulator::Cartridge>(visitor);
+                m_cartridge = GBEmulatorTests::LoadTestCartridge(m_testRomName);
                 EXPECT_TRUE(m_cartridge) << "Failed to load the rom";
 
                 m_loadedCartridgeName = m_testRomName;
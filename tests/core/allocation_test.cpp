@@ -0,0 +1,117 @@
+#include <common.h>
+#include <core/controller.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Count the allocations of the whole test program, while enabled.
+// Aligned allocations (alignas larger than the default alignment) have their own overloads.
+static bool s_countAllocations = false;
+static size_t s_nbAllocations = 0;
+
+static void* Allocate(std::size_t size)
+{
+    if (s_countAllocations)
+        ++s_nbAllocations;
+
+    void* ptr = std::malloc(size > 0 ? size : 1);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+// The pointer returned by malloc is stored just before the aligned block
+static void* AllocateAligned(std::size_t size, std::align_val_t alignment)
+{
+    const std::uintptr_t mask = (std::uintptr_t)alignment - 1;
+    void* ptr = Allocate(size + (std::size_t)mask + sizeof(void*));
+    void* aligned = (void*)(((std::uintptr_t)ptr + sizeof(void*) + mask) & ~mask);
+    static_cast<void**>(aligned)[-1] = ptr;
+    return aligned;
+}
+
+// Not inlined, otherwise GCC warns about free() called on memory from operator new (-Wmismatched-new-delete)
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+static void Deallocate(void* ptr)
+{
+    std::free(ptr);
+}
+
+static void DeallocateAligned(void* ptr)
+{
+    if (ptr != nullptr)
+        Deallocate(static_cast<void**>(ptr)[-1]);
+}
+
+void* operator new(std::size_t size) { return Allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+
+void operator delete(void* ptr) noexcept { Deallocate(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { Deallocate(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { DeallocateAligned(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { DeallocateAligned(ptr); }
+
+// Aligned allocations must be counted too, the memory arena is cache line aligned
+TEST(AllocationCounterTest, CountsAlignedAllocations)
+{
+    struct alignas(64) CacheLine
+    {
+        uint8_t data[64];
+    };
+
+    s_nbAllocations = 0;
+    s_countAllocations = true;
+    auto line = std::make_unique<CacheLine>();
+    auto lines = std::make_unique<CacheLine[]>(3);
+    s_countAllocations = false;
+
+    EXPECT_EQ(s_nbAllocations, 2u);
+    EXPECT_EQ((std::uintptr_t)line.get() % 64, 0u);
+    EXPECT_EQ((std::uintptr_t)lines.get() % 64, 0u);
+}
+
+class AllocationTest : public ::testing::TestWithParam<const char*>
+{
+};
+
+// Once the cartridge is inserted, running the emulation must never allocate,
+// like the libretro core does: frames stopping on audio samples, and inputs each frame.
+TEST_P(AllocationTest, NoAllocationWhileRunning)
+{
+    auto cartridge = GBEmulatorTests::LoadTestCartridge(GetParam());
+    ASSERT_TRUE(cartridge) << "Failed to load the rom";
+
+    GBEmulator::Bus bus;
+    auto controller = std::make_shared<GBEmulator::Controller>();
+    bus.InsertCartridge(cartridge);
+    bus.ConnectController(controller);
+
+    constexpr size_t NB_FRAMES = 600;
+    float samples[128];
+
+    s_nbAllocations = 0;
+    s_countAllocations = true;
+    for (size_t frame = 0; frame < NB_FRAMES; ++frame)
+    {
+        controller->ToggleA((frame / 30) % 2 == 1);
+        controller->ToggleStart(false);
+
+        const size_t nbCyclesPerFrame = bus.GetNbCyclesPerFrame();
+        size_t nbCycles = 0;
+        GBEmulator::RunStatus status;
+        do
+        {
+            status = bus.RunCycles(nbCyclesPerFrame - nbCycles, true);
+            nbCycles += status.nbCycles;
+            bus.GetAPU().FillSamplesIfReady(samples);
+        } while (!status.frameFinished && nbCycles < nbCyclesPerFrame);
+    }
+    s_countAllocations = false;
+
+    EXPECT_EQ(s_nbAllocations, 0u);
+}
+
+INSTANTIATE_TEST_SUITE_P(TestRoms, AllocationTest, ::testing::Values("cpu_instrs.gb", "dmg-acid2.gb"));
@@ -0,0 +1,72 @@
+#include <common.h>
+#include <core/cheats.h>
+
+TEST(CheatsTest, ParseCodes)
+{
+    GBEmulator::GameGenieCode gameGenie;
+    ASSERT_TRUE(GBEmulator::ParseGameGenieCode("3E1-50F", gameGenie));
+    EXPECT_EQ(gameGenie.address, 0x0150);
+    EXPECT_EQ(gameGenie.data, 0x3E);
+    EXPECT_FALSE(gameGenie.hasCompare);
+
+    ASSERT_TRUE(GBEmulator::ParseGameGenieCode("3E1-50F-2A5", gameGenie));
+    EXPECT_TRUE(gameGenie.hasCompare);
+    EXPECT_EQ(gameGenie.compare, 0xF3);
+
+    GBEmulator::GameSharkCode gameShark;
+    ASSERT_TRUE(GBEmulator::ParseGameSharkCode("01AB00C1", gameShark));
+    EXPECT_EQ(gameShark.type, 0x01);
+    EXPECT_EQ(gameShark.data, 0xAB);
+    EXPECT_EQ(gameShark.address, 0xC100);
+
+    EXPECT_FALSE(GBEmulator::ParseGameGenieCode("3E1-50", gameGenie));
+    EXPECT_FALSE(GBEmulator::ParseGameSharkCode("01AB00CG", gameShark));
+
+    // RAM only
+    EXPECT_TRUE(GBEmulator::ParseGameSharkCode("01AB00A0", gameShark));
+    EXPECT_TRUE(GBEmulator::ParseGameSharkCode("01ABFFDF", gameShark));
+    EXPECT_TRUE(GBEmulator::ParseGameSharkCode("01AB80FF", gameShark));
+    EXPECT_FALSE(GBEmulator::ParseGameSharkCode("01AB0020", gameShark));
+    EXPECT_FALSE(GBEmulator::ParseGameSharkCode("01AB0080", gameShark));
+    EXPECT_FALSE(GBEmulator::ParseGameSharkCode("01AB00E0", gameShark));
+    EXPECT_FALSE(GBEmulator::ParseGameSharkCode("01AB40FF", gameShark));
+    EXPECT_FALSE(GBEmulator::ParseGameSharkCode("01ABFFFF", gameShark));
+}
+
+// Game Genie codes patch the ROM, GameShark codes are written in RAM at the start of VBlank
+TEST(CheatsTest, ApplyCodes)
+{
+    auto cartridge = GBEmulatorTests::LoadTestCartridge("bgbtest.gb");
+    ASSERT_TRUE(cartridge) << "Failed to load the rom";
+
+    GBEmulator::Bus bus;
+    bus.InsertCartridge(cartridge);
+    const GBEmulator::Bus& constBus = bus;
+    EXPECT_EQ(constBus.ReadByte(0x0150), 0xF3);
+
+    // Compare value doesn't match
+    EXPECT_TRUE(bus.AddCheat("3E1-50F-0A0"));
+    EXPECT_EQ(constBus.ReadByte(0x0150), 0xF3);
+
+    EXPECT_TRUE(bus.AddCheat("3E1-50F-2A5"));
+    EXPECT_EQ(constBus.ReadByte(0x0150), 0x3E);
+    EXPECT_EQ(constBus.ReadByte(0x0151), 0x31);
+
+    bus.ClearCheats();
+    EXPECT_EQ(constBus.ReadByte(0x0150), 0xF3);
+
+    EXPECT_TRUE(bus.AddCheat("01AB00C1"));
+    EXPECT_FALSE(bus.AddCheat("not a code"));
+    bool frameFinished = false;
+    for (int i = 0; i < 10 && !frameFinished; ++i)
+        frameFinished = bus.RunFrame().frameFinished;
+    ASSERT_TRUE(frameFinished);
+    EXPECT_EQ(constBus.ReadByte(0xC100), 0xAB);
+
+    // Not written anymore once another cartridge is inserted
+    bus.InsertCartridge(cartridge);
+    bus.WriteByte(0xC100, 0x00);
+    for (int i = 0; i < 10; ++i)
+        bus.RunFrame();
+    EXPECT_NE(constBus.ReadByte(0xC100), 0xAB);
+}
@@ -0,0 +1,104 @@
+#include <common.h>
+#include <core/lineCompositor.h>
+#include <random>
+
+using GBEmulator::CompositorImpl;
+
+namespace
+{
+constexpr CompositorImpl SIMD_IMPLS[] = {CompositorImpl::SSE2, CompositorImpl::AVX2};
+}
+
+class CompositorTest : public ::testing::TestWithParam<const char*>
+{
+};
+
+// Each SIMD implementation must render exactly the same frames as the scalar one
+TEST_P(CompositorTest, SameAsScalar)
+{
+    auto cartridge = GBEmulatorTests::LoadTestCartridge(GetParam());
+    ASSERT_TRUE(cartridge) << "Failed to load the rom";
+
+    for (CompositorImpl impl : SIMD_IMPLS)
+    {
+        if (!GBEmulator::IsCompositorImplSupported(impl))
+            continue;
+
+        GBEmulator::Bus scalarBus;
+        scalarBus.InsertCartridge(cartridge);
+        ASSERT_TRUE(scalarBus.GetPPU().SetCompositorImpl(CompositorImpl::Scalar));
+
+        GBEmulator::Bus bus;
+        bus.InsertCartridge(cartridge);
+        ASSERT_TRUE(bus.GetPPU().SetCompositorImpl(impl));
+
+        constexpr size_t NB_FRAMES = 120;
+        for (size_t frame = 0; frame < NB_FRAMES; ++frame)
+        {
+            scalarBus.RunFrame();
+            bus.RunFrame();
+            ASSERT_EQ(bus.GetPPU().GetScreen(), scalarBus.GetPPU().GetScreen())
+                << "Frame " << frame << " differs with implementation " << (int)impl;
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(TestRoms, CompositorTest, ::testing::Values("dmg-acid2.gb", "cgb-acid2.gbc"));
+
+// Spans of any size and alignment, as they are cut by palette writes
+TEST(CompositorTest, RandomSpans)
+{
+    std::mt19937 generator(42);
+    auto random = [&generator](unsigned max) { return (uint8_t)(generator() % (max + 1)); };
+
+    GBEmulator::LinePixels pixels;
+    for (size_t i = 0; i < GBEmulator::GB_INTERNAL_WIDTH; ++i)
+    {
+        pixels.bgColor[i] = random(3);
+        pixels.bgPalette[i] = random(7);
+        pixels.bgPriority[i] = random(1);
+        pixels.objColor[i] = random(3);
+        pixels.objPalette[i] = random(7);
+        pixels.objPriority[i] = random(1);
+    }
+
+    GBEmulator::CompositorPalette palette;
+    for (auto& color : palette)
+        color = generator() & 0x00FFFFFF;
+
+    // Every span of this configuration must match the scalar implementation
+    auto checkSpans = [&](CompositorImpl impl, GBEmulator::PixelFormat format, bool isGBC, bool bgMasterPriority)
+    {
+        constexpr size_t LINE_SIZE = 4 * GBEmulator::GB_INTERNAL_WIDTH;
+        for (size_t begin = 0; begin < GBEmulator::GB_INTERNAL_WIDTH; begin += 7)
+        {
+            for (size_t end = begin; end <= GBEmulator::GB_INTERNAL_WIDTH; end += 13)
+            {
+                std::array<uint8_t, LINE_SIZE> expected{};
+                std::array<uint8_t, LINE_SIZE> result{};
+                GBEmulator::ComposeLine(pixels, begin, end, palette, isGBC, bgMasterPriority, format, expected.data(),
+                                        CompositorImpl::Scalar);
+                GBEmulator::ComposeLine(pixels, begin, end, palette, isGBC, bgMasterPriority, format, result.data(),
+                                        impl);
+                ASSERT_EQ(result, expected) << "Span [" << begin << ", " << end << ") differs with implementation "
+                                            << (int)impl << " and format " << (int)format;
+            }
+        }
+    };
+
+    // One format per pixel size
+    constexpr GBEmulator::PixelFormat FORMATS[] = {GBEmulator::PixelFormat::XRGB8888, GBEmulator::PixelFormat::RGB888,
+                                                   GBEmulator::PixelFormat::RGB565, GBEmulator::PixelFormat::Y8};
+    for (CompositorImpl impl : SIMD_IMPLS)
+    {
+        if (!GBEmulator::IsCompositorImplSupported(impl))
+            continue;
+
+        for (GBEmulator::PixelFormat format : FORMATS)
+        {
+            checkSpans(impl, format, false, true);
+            checkSpans(impl, format, true, true);
+            checkSpans(impl, format, true, false);
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#include <common.h>
+#include <core/controller.h>
+
+// Inputs queued at a given cycle must be applied exactly at this cycle, with Clock() and RunCycles()
+TEST(ControllerTest, InputIsAppliedAtItsCycle)
+{
+    auto cartridge = GBEmulatorTests::LoadTestCartridge("bgbtest.gb");
+    ASSERT_TRUE(cartridge) << "Failed to load the rom";
+
+    constexpr size_t INPUT_CYCLE = 100000;
+    constexpr uint8_t BUTTONS = 0x90; // Start + A
+
+    for (bool useRunCycles : {false, true})
+    {
+        GBEmulator::Bus bus;
+        auto controller = std::make_shared<GBEmulator::Controller>();
+        bus.InsertCartridge(cartridge);
+        bus.ConnectController(controller);
+
+        controller->QueueInput(INPUT_CYCLE, BUTTONS);
+
+        while (bus.GetNbCycles() < INPUT_CYCLE - 1)
+        {
+            if (useRunCycles)
+                bus.RunCycles(INPUT_CYCLE - 1 - bus.GetNbCycles());
+            else
+                bus.Clock();
+        }
+
+        EXPECT_EQ(bus.GetNbCycles(), INPUT_CYCLE - 1);
+        EXPECT_EQ(controller->GetButtonsStatus(), 0x00);
+
+        bus.Clock();
+        EXPECT_EQ(controller->GetButtonsStatus(), BUTTONS);
+
+        // Toggles are applied on the next cycle
+        controller->ToggleA(false);
+        EXPECT_EQ(controller->GetButtonsStatus(), BUTTONS);
+        bus.Clock();
+        EXPECT_EQ(controller->GetButtonsStatus(), 0x80);
+    }
+}
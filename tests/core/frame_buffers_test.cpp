@@ -0,0 +1,88 @@
+#include <atomic>
+#include <common.h>
+#include <core/frameBuffers.h>
+#include <thread>
+
+TEST(FrameBuffersTest, PublishAndAcquire)
+{
+    GBEmulator::FrameBuffers buffers(4);
+    EXPECT_EQ(buffers.Acquire().sequence, 0u);
+
+    // Frames published without being acquired are replaced, the consumer gets the latest
+    for (uint8_t frame = 1; frame <= 3; ++frame)
+    {
+        buffers.GetBackBuffer()[0] = frame;
+        buffers.Publish();
+        EXPECT_EQ(buffers.GetLastPublished()[0], frame);
+    }
+
+    GBEmulator::FrameView view = buffers.Acquire();
+    EXPECT_EQ(view.sequence, 3u);
+    EXPECT_EQ(view.data[0], 3);
+
+    // The acquired frame is never written, even if the producer keeps publishing
+    for (uint8_t frame = 4; frame <= 10; ++frame)
+    {
+        EXPECT_NE(buffers.GetBackBuffer(), view.data);
+        buffers.GetBackBuffer()[0] = frame;
+        buffers.Publish();
+    }
+    EXPECT_EQ(view.data[0], 3);
+
+    // Nothing new, same frame
+    view = buffers.Acquire();
+    EXPECT_EQ(view.sequence, 10u);
+    EXPECT_EQ(buffers.Acquire().data, view.data);
+}
+
+// The emulation runs while another thread acquires the frames. Each acquired frame must be complete:
+// the frame with sequence N is the same as the Nth frame published, when replayed afterwards.
+TEST(FrameBuffersTest, ConsumerThread)
+{
+    auto cartridge = GBEmulatorTests::LoadTestCartridge("dmg-acid2.gb");
+    ASSERT_TRUE(cartridge) << "Failed to load the rom";
+
+    constexpr size_t NB_FRAMES = 120;
+    GBEmulator::Bus bus;
+    bus.InsertCartridge(cartridge);
+
+    std::atomic<bool> isRunning = true;
+    std::vector<std::pair<uint64_t, std::vector<uint8_t>>> acquiredFrames;
+    std::thread consumer(
+        [&]()
+        {
+            uint64_t lastSequence = 0;
+            while (isRunning)
+            {
+                GBEmulator::FrameView frame = bus.GetPPU().AcquireFrame();
+                if (frame.sequence != lastSequence)
+                {
+                    lastSequence = frame.sequence;
+                    acquiredFrames.emplace_back(frame.sequence,
+                                                std::vector<uint8_t>(frame.data, frame.data + frame.size));
+                }
+            }
+        });
+
+    while (bus.GetPPU().GetNbCompleteFrames() < NB_FRAMES)
+        bus.RunFrame();
+
+    isRunning = false;
+    consumer.join();
+
+    ASSERT_FALSE(acquiredFrames.empty());
+    for (size_t i = 1; i < acquiredFrames.size(); ++i)
+        EXPECT_LT(acquiredFrames[i - 1].first, acquiredFrames[i].first);
+
+    // Replay and compare the frames that were acquired
+    GBEmulator::Bus replayBus;
+    replayBus.InsertCartridge(cartridge);
+    for (const auto& [sequence, data] : acquiredFrames)
+    {
+        while (replayBus.GetPPU().GetNbCompleteFrames() < sequence)
+            replayBus.RunFrame();
+
+        ASSERT_EQ(replayBus.GetPPU().GetNbCompleteFrames(), sequence);
+        EXPECT_EQ(data, replayBus.GetPPU().GetScreen()) << "Frame " << sequence;
+    }
+}
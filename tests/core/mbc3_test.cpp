@@ -0,0 +1,124 @@
+#include <common.h>
+#include <core/utils/vectorVisitor.h>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+// rtc3test has no RAM, make it an MBC3 + RAM + timer cartridge with 4 banks of RAM
+std::shared_ptr<GBEmulator::Cartridge> LoadMBC3CartridgeWithRAM()
+{
+    std::string romPath = GBEmulatorTests::FindTestRom("rtc3test.gb");
+    if (romPath.empty())
+        return nullptr;
+
+    std::ifstream file(romPath, std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    data[0x0147] = 0x10;
+    data[0x0149] = 0x03;
+
+    GBEmulator::Utils::VectorReadVisitor visitor(data);
+    return std::make_shared<GBEmulator::Cartridge>(visitor);
+}
+} // namespace
+
+// Selecting a RAM bank unmaps the clock register, RAM writes must not go to the clock anymore
+TEST(MBC3Test, RAMAfterClockRegister)
+{
+    auto cartridge = LoadMBC3CartridgeWithRAM();
+    ASSERT_TRUE(cartridge) << "Failed to load the rom";
+
+    GBEmulator::Bus bus;
+    bus.InsertCartridge(cartridge);
+    const GBEmulator::Bus& constBus = bus;
+
+    // Enable RAM and the clock, set the seconds
+    bus.WriteByte(0x0000, 0x0A);
+    bus.WriteByte(0x4000, 0x08);
+    bus.WriteByte(0xA000, 0x05);
+
+    // RAM bank 0
+    bus.WriteByte(0x4000, 0x00);
+    bus.WriteByte(0xA000, 0x42);
+    bus.WriteByte(0xBFFF, 0x43);
+    EXPECT_EQ(constBus.ReadByte(0xA000), 0x42);
+    EXPECT_EQ(constBus.ReadByte(0xBFFF), 0x43);
+
+    // Seconds unchanged
+    bus.WriteByte(0x4000, 0x08);
+    EXPECT_EQ(constBus.ReadByte(0xA000), 0x05);
+}
+
+namespace
+{
+void RunSeconds(GBEmulator::Bus& bus, size_t nbSeconds)
+{
+    const size_t nbCycles = nbSeconds * 1048576;
+    for (size_t cycles = 0; cycles < nbCycles;)
+        cycles += bus.RunCycles(nbCycles - cycles).nbCycles;
+}
+} // namespace
+
+// Reads return the registers copied on the last latch
+TEST(MBC3Test, Latch)
+{
+    auto cartridge = LoadMBC3CartridgeWithRAM();
+    ASSERT_TRUE(cartridge) << "Failed to load the rom";
+
+    GBEmulator::Bus bus;
+    bus.InsertCartridge(cartridge);
+    const GBEmulator::Bus& constBus = bus;
+
+    bus.WriteByte(0x0000, 0x0A);
+    bus.WriteByte(0x4000, 0x08);
+    bus.WriteByte(0xA000, 0x05);
+    bus.WriteByte(0x6000, 0x00);
+    bus.WriteByte(0x6000, 0x01);
+    EXPECT_EQ(constBus.ReadByte(0xA000), 0x05);
+
+    RunSeconds(bus, 2);
+    EXPECT_EQ(constBus.ReadByte(0xA000), 0x05);
+
+    // 0x01 alone doesn't latch
+    bus.WriteByte(0x4000, 0x08);
+    bus.WriteByte(0x6000, 0x01);
+    EXPECT_EQ(constBus.ReadByte(0xA000), 0x05);
+
+    bus.WriteByte(0x6000, 0x00);
+    bus.WriteByte(0x6000, 0x01);
+    EXPECT_EQ(constBus.ReadByte(0xA000), 0x07);
+}
+
+// The cartridge outlives the first bus, it must not use it as its time source anymore
+TEST(MBC3Test, InsertInTwoBuses)
+{
+    auto cartridge = LoadMBC3CartridgeWithRAM();
+    ASSERT_TRUE(cartridge) << "Failed to load the rom";
+
+    {
+        GBEmulator::Bus bus;
+        bus.InsertCartridge(cartridge);
+        EXPECT_EQ(cartridge->GetRTCSource(), &bus);
+        RunSeconds(bus, 1);
+    }
+    EXPECT_EQ(cartridge->GetRTCSource(), nullptr);
+
+    GBEmulator::Bus bus;
+    bus.InsertCartridge(cartridge);
+    EXPECT_EQ(cartridge->GetRTCSource(), &bus);
+
+    // Replacing the cartridge of another bus doesn't detach this one
+    {
+        GBEmulator::Bus otherBus;
+        otherBus.InsertCartridge(cartridge);
+        otherBus.InsertCartridge(LoadMBC3CartridgeWithRAM());
+    }
+    bus.InsertCartridge(cartridge);
+    EXPECT_EQ(cartridge->GetRTCSource(), &bus);
+
+    // The time elapsed with the first bus since the last access is not counted
+    bus.WriteByte(0x0000, 0x0A);
+    bus.WriteByte(0x4000, 0x08);
+    const GBEmulator::Bus& constBus = bus;
+    EXPECT_EQ(constBus.ReadByte(0xA000), 0x00);
+}
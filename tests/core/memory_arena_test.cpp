@@ -0,0 +1,36 @@
+#include <common.h>
+#include <core/memoryArena.h>
+#include <cstring>
+
+// A copy of the memory arena brings back the memory and the registers, through the bus and the PPU
+TEST(MemoryArenaTest, RestoreMemory)
+{
+    auto cartridge = GBEmulatorTests::LoadTestCartridge("bgbtest.gb");
+    ASSERT_TRUE(cartridge) << "Failed to load the rom";
+
+    GBEmulator::Bus bus;
+    bus.InsertCartridge(cartridge);
+    const GBEmulator::Bus& constBus = bus;
+
+    bus.RunCycles(100000);
+    const auto snapshot = std::make_unique<GBEmulator::MemoryArena>(bus.GetMemory());
+    const uint8_t ly = bus.GetPPU().GetLY();
+    const uint8_t wramByte = constBus.ReadByte(0xC000);
+
+    // Change some of it
+    bus.RunCycles(12345);
+    bus.WriteByte(0xC000, ~wramByte);
+    bus.WriteByte(0xFFFF, 0x1F);
+    bus.WriteByte(0xFE00, 0xAB);
+    bus.WriteByte(0x9000, 0xCD);
+    EXPECT_NE(std::memcmp(snapshot.get(), &bus.GetMemory(), sizeof(GBEmulator::MemoryArena)), 0);
+
+    bus.RestoreMemory(*snapshot);
+    EXPECT_EQ(std::memcmp(snapshot.get(), &bus.GetMemory(), sizeof(GBEmulator::MemoryArena)), 0);
+
+    EXPECT_EQ(bus.GetPPU().GetLY(), ly);
+    EXPECT_EQ(constBus.ReadByte(0xC000), wramByte);
+    EXPECT_EQ(constBus.ReadByte(0xFFFF), snapshot->busRegisters.IE.flag);
+    EXPECT_EQ(bus.GetPPU().GetOAMEntries()[0].yPosition, snapshot->OAM[0].yPosition);
+    EXPECT_EQ(bus.GetPPU().GetVRAM()[0x1000], snapshot->videoRAM[0x1000]);
+}
@@ -0,0 +1,49 @@
+#include <common.h>
+#include <core/pixelFormat.h>
+
+using GBEmulator::PixelFormat;
+
+class PixelFormatTest : public ::testing::TestWithParam<const char*>
+{
+};
+
+// Every format must render the RGB888 frames, converted
+TEST_P(PixelFormatTest, SameAsRGB888)
+{
+    auto cartridge = GBEmulatorTests::LoadTestCartridge(GetParam());
+    ASSERT_TRUE(cartridge) << "Failed to load the rom";
+
+    for (PixelFormat format : {PixelFormat::XRGB8888, PixelFormat::RGB565, PixelFormat::RGB555, PixelFormat::Y8,
+                               PixelFormat::Shade})
+    {
+        GBEmulator::Bus rgbBus;
+        rgbBus.InsertCartridge(cartridge);
+
+        GBEmulator::Bus bus(format);
+        bus.InsertCartridge(cartridge);
+
+        const size_t bytesPerPixel = GBEmulator::GetBytesPerPixel(format);
+        ASSERT_EQ(bus.GetPPU().GetScreen().size(), GBEmulator::GB_NB_PIXELS * bytesPerPixel);
+
+        constexpr size_t NB_FRAMES = 60;
+        for (size_t frame = 0; frame < NB_FRAMES; ++frame)
+        {
+            rgbBus.RunFrame();
+            bus.RunFrame();
+
+            const auto& rgbScreen = rgbBus.GetPPU().GetScreen();
+            const auto& screen = bus.GetPPU().GetScreen();
+            for (size_t i = 0; i < GBEmulator::GB_NB_PIXELS; ++i)
+            {
+                std::array<uint8_t, 4> expected{};
+                GBEmulator::WritePixel(GBEmulator::ConvertRGB888(rgbScreen[3 * i], rgbScreen[3 * i + 1],
+                                                                 rgbScreen[3 * i + 2], format),
+                                       format, expected.data());
+                ASSERT_TRUE(std::equal(expected.begin(), expected.begin() + bytesPerPixel, &screen[i * bytesPerPixel]))
+                    << "Pixel " << i << " of frame " << frame << " differs with format " << (int)format;
+            }
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(TestRoms, PixelFormatTest, ::testing::Values("dmg-acid2.gb", "cgb-acid2.gbc"));
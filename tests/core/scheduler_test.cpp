@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include <core/scheduler.h>
+
+using GBEmulator::Scheduler;
+using GBEmulator::SchedulerEvent;
+
+TEST(SchedulerTest, EventsArePoppedInOrder)
+{
+    Scheduler scheduler;
+    EXPECT_EQ(scheduler.GetNextEventCycle(), Scheduler::NEVER);
+
+    scheduler.Schedule(SchedulerEvent::TimerOverflow, 100);
+    scheduler.Schedule(SchedulerEvent::SpeedSwitchDone, 50);
+    EXPECT_EQ(scheduler.GetNextEventCycle(), 50u);
+
+    SchedulerEvent event;
+    uint64_t eventCycle;
+    EXPECT_FALSE(scheduler.PopDueEvent(49, event, eventCycle));
+
+    ASSERT_TRUE(scheduler.PopDueEvent(200, event, eventCycle));
+    EXPECT_EQ(event, SchedulerEvent::SpeedSwitchDone);
+    EXPECT_EQ(eventCycle, 50u);
+
+    ASSERT_TRUE(scheduler.PopDueEvent(200, event, eventCycle));
+    EXPECT_EQ(event, SchedulerEvent::TimerOverflow);
+    EXPECT_EQ(eventCycle, 100u);
+
+    EXPECT_FALSE(scheduler.PopDueEvent(200, event, eventCycle));
+}
+
+TEST(SchedulerTest, RescheduleAndCancel)
+{
+    Scheduler scheduler;
+    scheduler.Schedule(SchedulerEvent::TimerOverflow, 100);
+    scheduler.Schedule(SchedulerEvent::SpeedSwitchDone, 50);
+
+    // Scheduling again moves the event
+    scheduler.Schedule(SchedulerEvent::TimerOverflow, 10);
+    EXPECT_EQ(scheduler.GetNextEventCycle(), 10u);
+    scheduler.Schedule(SchedulerEvent::TimerOverflow, 300);
+    EXPECT_EQ(scheduler.GetNextEventCycle(), 50u);
+    EXPECT_EQ(scheduler.GetEventCycle(SchedulerEvent::TimerOverflow), 300u);
+
+    scheduler.Cancel(SchedulerEvent::SpeedSwitchDone);
+    EXPECT_FALSE(scheduler.IsScheduled(SchedulerEvent::SpeedSwitchDone));
+    EXPECT_EQ(scheduler.GetNextEventCycle(), 300u);
+
+    scheduler.Cancel(SchedulerEvent::TimerOverflow);
+    EXPECT_EQ(scheduler.GetNextEventCycle(), Scheduler::NEVER);
+}
@@ -0,0 +1,116 @@
+#include <common.h>
+#include <core/utils/vectorVisitor.h>
+
+namespace
+{
+constexpr uint16_t DIV = 0xFF04;
+constexpr uint16_t TIMA = 0xFF05;
+constexpr uint16_t TMA = 0xFF06;
+constexpr uint16_t TAC = 0xFF07;
+
+// The CPU loops on itself (JR -2), the test drives the timer through the bus.
+// The internal counter of the timer starts at 0 (DIV written).
+class TimerTest : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        std::vector<uint8_t> rom(0x8000, 0x00);
+        rom[0x0100] = 0x18;
+        rom[0x0101] = 0xFE;
+        GBEmulator::Utils::VectorReadVisitor visitor(rom);
+        m_bus.InsertCartridge(std::make_shared<GBEmulator::Cartridge>(visitor));
+        m_bus.WriteByte(DIV, 0x00);
+    }
+
+protected:
+    uint8_t Read(uint16_t addr) const { return static_cast<const GBEmulator::Bus&>(m_bus).ReadByte(addr); }
+
+    GBEmulator::Bus m_bus;
+};
+} // namespace
+
+// The internal counter restarts, DIV is incremented 256 clocks (64 cycles) after the write
+TEST_F(TimerTest, DivWriteResetsCounter)
+{
+    GBEmulatorTests::RunForNCycles(m_bus, 50);
+    m_bus.WriteByte(DIV, 0x00);
+
+    GBEmulatorTests::RunForNCycles(m_bus, 63);
+    EXPECT_EQ(Read(DIV), 0x00);
+    GBEmulatorTests::RunForNCycles(m_bus, 1);
+    EXPECT_EQ(Read(DIV), 0x01);
+}
+
+// TIMA every 16 clocks (4 cycles): incremented when the bit 3 of the internal counter falls
+TEST_F(TimerTest, DivWriteFallingEdge)
+{
+    m_bus.WriteByte(TAC, 0x05);
+    m_bus.WriteByte(TIMA, 0x10);
+
+    // Bit 3 not set yet, no increment
+    GBEmulatorTests::RunForNCycles(m_bus, 1);
+    m_bus.WriteByte(DIV, 0x00);
+    EXPECT_EQ(Read(TIMA), 0x10);
+
+    // Bit 3 set
+    GBEmulatorTests::RunForNCycles(m_bus, 2);
+    m_bus.WriteByte(DIV, 0x00);
+    EXPECT_EQ(Read(TIMA), 0x11);
+
+    // And it counts from the reset
+    GBEmulatorTests::RunForNCycles(m_bus, 3);
+    EXPECT_EQ(Read(TIMA), 0x11);
+    GBEmulatorTests::RunForNCycles(m_bus, 1);
+    EXPECT_EQ(Read(TIMA), 0x12);
+}
+
+TEST_F(TimerTest, TacWriteFallingEdge)
+{
+    m_bus.WriteByte(TAC, 0x05);
+    m_bus.WriteByte(TIMA, 0x10);
+    GBEmulatorTests::RunForNCycles(m_bus, 2);
+
+    // Bit 9 is not set
+    m_bus.WriteByte(TAC, 0x04);
+    EXPECT_EQ(Read(TIMA), 0x11);
+
+    // Disabling the timer also makes the bit fall
+    m_bus.WriteByte(DIV, 0x00);
+    GBEmulatorTests::RunForNCycles(m_bus, 128);
+    m_bus.WriteByte(TAC, 0x00);
+    EXPECT_EQ(Read(TIMA), 0x12);
+
+    // Disabled, nothing happens
+    m_bus.WriteByte(DIV, 0x00);
+    GBEmulatorTests::RunForNCycles(m_bus, 2);
+    m_bus.WriteByte(TAC, 0x01);
+    EXPECT_EQ(Read(TIMA), 0x12);
+}
+
+// An increment from a write can also overflow: TIMA is reloaded and the interrupt raised on the next cycle,
+// and the following overflow is still scheduled
+TEST_F(TimerTest, DivWriteOverflow)
+{
+    m_bus.WriteByte(GBEmulator::IF_REG_ADDR, 0x00);
+    m_bus.WriteByte(TAC, 0x05);
+    m_bus.WriteByte(TMA, 0xFE);
+    m_bus.WriteByte(TIMA, 0xFF);
+    GBEmulatorTests::RunForNCycles(m_bus, 2);
+    EXPECT_EQ(Read(TIMA), 0xFF);
+
+    m_bus.WriteByte(DIV, 0x00);
+    EXPECT_EQ(Read(TIMA), 0xFE);
+    EXPECT_EQ(Read(GBEmulator::IF_REG_ADDR) & 0x04, 0x00);
+    GBEmulatorTests::RunForNCycles(m_bus, 1);
+    EXPECT_EQ(Read(GBEmulator::IF_REG_ADDR) & 0x04, 0x04);
+
+    // 0xFE, 0xFF, then overflow 32 clocks (8 cycles) after the DIV write
+    m_bus.WriteByte(GBEmulator::IF_REG_ADDR, 0x00);
+    GBEmulatorTests::RunForNCycles(m_bus, 6);
+    EXPECT_EQ(Read(TIMA), 0xFF);
+    EXPECT_EQ(Read(GBEmulator::IF_REG_ADDR) & 0x04, 0x00);
+    GBEmulatorTests::RunForNCycles(m_bus, 1);
+    EXPECT_EQ(Read(TIMA), 0xFE);
+    EXPECT_EQ(Read(GBEmulator::IF_REG_ADDR) & 0x04, 0x04);
+}
@@ -0,0 +1,125 @@
+#include <common.h>
+
+struct FastForwardParam
+{
+    const char* romName;
+    // The rom is busy-waiting on a register, rather than halting
+    bool hasIdleLoop;
+    // The rom copies/fills memory with loops that can be run in bulk
+    bool hasMemoryLoop;
+};
+
+// Run the test roms cycle by cycle and with the fast-forward (HALT, idle and memory loops), and compare the state
+// of the system. Skipping those cycles must not change anything, including the timing.
+class FastForwardTest : public ::testing::TestWithParam<FastForwardParam>
+{
+protected:
+    enum class Stepping
+    {
+        Clock,
+        FastForward,
+        // Bus::RunCycles, stopping on frames and audio samples
+        RunCycles
+    };
+
+    struct State
+    {
+        uint16_t registers[6] = {};
+        size_t nbInstructions = 0;
+        size_t nbFastForwardedCycles = 0;
+        size_t nbIdleLoopSkippedCycles = 0;
+        size_t nbMemoryLoopCycles = 0;
+        std::vector<uint8_t> screen;
+        std::vector<uint8_t> memory;
+    };
+
+    State Run(const std::shared_ptr<GBEmulator::Cartridge>& cartridge, Stepping stepping)
+    {
+        // Around 200 frames
+        constexpr size_t NB_CYCLES = 200 * 17556;
+
+        GBEmulator::Bus bus;
+        bus.InsertCartridge(cartridge);
+
+        State state;
+        float samples[128];
+        for (size_t i = 0; i < NB_CYCLES;)
+        {
+            size_t nbCycles = 0;
+            if (stepping == Stepping::RunCycles)
+                nbCycles = bus.RunCycles(NB_CYCLES - i, true).nbCycles;
+            else if (stepping == Stepping::FastForward)
+                nbCycles = bus.FastForward(NB_CYCLES - i);
+            state.nbFastForwardedCycles += nbCycles;
+            if (nbCycles == 0)
+            {
+                bus.Clock();
+                nbCycles = 1;
+            }
+            i += nbCycles;
+
+            // Samples must be consumed, otherwise the APU will wait for the buffer to be emptied
+            bus.GetAPU().FillSamplesIfReady(samples);
+        }
+
+        const GBEmulator::Z80Processor& cpu = bus.GetCPU();
+        state.registers[0] = cpu.GetAFRegister().AF;
+        state.registers[1] = cpu.GetBCRegister().BC;
+        state.registers[2] = cpu.GetDERegister().DE;
+        state.registers[3] = cpu.GetHLRegister().HL;
+        state.registers[4] = cpu.GetStackPointer();
+        state.registers[5] = cpu.GetPC();
+        state.nbInstructions = cpu.GetNbInstructionsExecuted();
+        for (const auto& [address, nbCycles] : cpu.GetIdleLoopSkippedCycles())
+            state.nbIdleLoopSkippedCycles += nbCycles;
+        for (const auto& [address, nbCycles] : cpu.GetMemoryLoopCycles())
+            state.nbMemoryLoopCycles += nbCycles;
+
+        const auto& screen = bus.GetPPU().GetScreen();
+        state.screen.assign(screen.begin(), screen.end());
+
+        // IO registers are skipped, reading them can have side effects
+        const GBEmulator::Bus& constBus = bus;
+        for (uint32_t addr = 0x0000; addr <= 0xFFFF; ++addr)
+            state.memory.push_back((addr >= 0xFF00 && addr < 0xFF80) ? 0 : constBus.ReadByte((uint16_t)addr));
+
+        return state;
+    }
+};
+
+TEST_P(FastForwardTest, SameAsClock)
+{
+    auto cartridge = GBEmulatorTests::LoadTestCartridge(GetParam().romName);
+    ASSERT_TRUE(cartridge) << "Failed to load the rom";
+
+    State reference = Run(cartridge, Stepping::Clock);
+    State fastForward = Run(cartridge, Stepping::FastForward);
+    State runCycles = Run(cartridge, Stepping::RunCycles);
+
+    EXPECT_GT(fastForward.nbFastForwardedCycles, 0u);
+    if (GetParam().hasIdleLoop)
+    {
+        EXPECT_GT(fastForward.nbIdleLoopSkippedCycles, 0u);
+    }
+    if (GetParam().hasMemoryLoop)
+    {
+        EXPECT_GT(fastForward.nbMemoryLoopCycles, 0u);
+    }
+
+    EXPECT_EQ(reference.nbInstructions, fastForward.nbInstructions);
+    for (int i = 0; i < 6; ++i)
+        EXPECT_EQ(reference.registers[i], fastForward.registers[i]) << "register " << i;
+    EXPECT_TRUE(reference.screen == fastForward.screen);
+    EXPECT_TRUE(reference.memory == fastForward.memory);
+
+    EXPECT_EQ(reference.nbInstructions, runCycles.nbInstructions);
+    for (int i = 0; i < 6; ++i)
+        EXPECT_EQ(reference.registers[i], runCycles.registers[i]) << "register " << i;
+    EXPECT_TRUE(reference.screen == runCycles.screen);
+    EXPECT_TRUE(reference.memory == runCycles.memory);
+}
+
+INSTANTIATE_TEST_SUITE_P(TestRoms, FastForwardTest,
+                         ::testing::Values(FastForwardParam{"dmg-acid2.gb", false, true},
+                                           FastForwardParam{"bgbtest.gb", true, true},
+                                           FastForwardParam{"02-interrupts.gb", false, false}));
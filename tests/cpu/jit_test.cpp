@@ -0,0 +1,77 @@
+#include <common.h>
+
+// Run the test roms with the interpreter and the JIT, and compare the state of the system.
+// Both backends must behave exactly the same, including the timing.
+class JitTest : public ::testing::TestWithParam<const char*>
+{
+protected:
+    struct State
+    {
+        uint16_t registers[6] = {};
+        size_t nbInstructions = 0;
+        size_t nbCompiledInstructions = 0;
+        std::vector<uint8_t> screen;
+        std::vector<uint8_t> memory;
+    };
+
+    State RunWithMode(const std::shared_ptr<GBEmulator::Cartridge>& cartridge, GBEmulator::DispatchMode mode)
+    {
+        // Around 200 frames
+        constexpr size_t NB_CYCLES = 200 * 17556;
+
+        GBEmulator::Bus bus;
+        bus.InsertCartridge(cartridge);
+
+        GBEmulator::Z80Processor& cpu = bus.GetCPU();
+        cpu.SetDispatchMode(mode);
+
+        float samples[128];
+        for (size_t i = 0; i < NB_CYCLES; ++i)
+        {
+            bus.Clock();
+            // Samples must be consumed, otherwise the APU will wait for the buffer to be emptied
+            bus.GetAPU().FillSamplesIfReady(samples);
+        }
+
+        State state;
+        state.registers[0] = cpu.GetAFRegister().AF;
+        state.registers[1] = cpu.GetBCRegister().BC;
+        state.registers[2] = cpu.GetDERegister().DE;
+        state.registers[3] = cpu.GetHLRegister().HL;
+        state.registers[4] = cpu.GetStackPointer();
+        state.registers[5] = cpu.GetPC();
+        state.nbInstructions = cpu.GetNbInstructionsExecuted();
+        state.nbCompiledInstructions = cpu.GetNbJitCompiledInstructions();
+
+        const auto& screen = bus.GetPPU().GetScreen();
+        state.screen.assign(screen.begin(), screen.end());
+
+        // IO registers are skipped, reading them can have side effects
+        const GBEmulator::Bus& constBus = bus;
+        for (uint32_t addr = 0x0000; addr <= 0xFFFF; ++addr)
+            state.memory.push_back((addr >= 0xFF00 && addr < 0xFF80) ? 0 : constBus.ReadByte((uint16_t)addr));
+
+        return state;
+    }
+};
+
+TEST_P(JitTest, SameAsInterpreter)
+{
+    auto cartridge = GBEmulatorTests::LoadTestCartridge(GetParam());
+    ASSERT_TRUE(cartridge) << "Failed to load the rom";
+
+    State interpreter = RunWithMode(cartridge, GBEmulator::DispatchMode::Specialized);
+    State jit = RunWithMode(cartridge, GBEmulator::DispatchMode::Jit);
+
+#if GBEMULATOR_JIT_SUPPORTED
+    EXPECT_GT(jit.nbCompiledInstructions, 0u);
+#endif
+
+    EXPECT_EQ(interpreter.nbInstructions, jit.nbInstructions);
+    for (int i = 0; i < 6; ++i)
+        EXPECT_EQ(interpreter.registers[i], jit.registers[i]) << "register " << i;
+    EXPECT_TRUE(interpreter.screen == jit.screen);
+    EXPECT_TRUE(interpreter.memory == jit.memory);
+}
+
+INSTANTIATE_TEST_SUITE_P(TestRoms, JitTest, ::testing::Values("cpu_instrs.gb", "instr_timing.gb", "mem_timing.gb"));